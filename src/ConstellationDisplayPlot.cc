@@ -46,6 +46,8 @@
 
 #include <qwt_scale_draw.h>
 #include <qwt_legend.h>
+#include <qwt_color_map.h>
+#include <qwt_matrix_raster_data.h>
 #include <QColor>
 #include <iostream>
 
@@ -92,6 +94,7 @@ ConstellationDisplayPlot::ConstellationDisplayPlot(int nplots, QWidget* parent)
 
   d_numPoints = 1024;
   d_pen_size = 5;
+  d_density_visible = false;
 
   d_zoomer.push_back(new ConstellationDisplayZoomer(canvas()));
 
@@ -189,6 +192,104 @@ ConstellationDisplayPlot::set_pen_size(int size)
   }
 }
 
+void
+ConstellationDisplayPlot::setDensityRaster(const std::shared_ptr<PersistenceRaster> &raster)
+{
+  for(QwtPlotSpectrogram *item : qAsConst(d_density_items)) {
+    item->detach();
+    delete item;
+  }
+  d_density_items.clear();
+
+  d_density = raster;
+  if(!raster) {
+    setDensityVisible(false);
+    return;
+  }
+
+  for(int i = 0; i < d_nplots && i < (int)raster->numChannels(); i++) {
+    QColor color = d_plot_curve[i]->pen().color();
+    QColor none = color;
+    none.setAlpha(0);
+
+    QwtLinearColorMap *colorMap = new QwtLinearColorMap(none, Qt::white);
+    colorMap->addColorStop(0.6, color);
+
+    QwtPlotSpectrogram *item = new QwtPlotSpectrogram();
+    item->setColorMap(colorMap);
+    item->setDisplayMode(QwtPlotSpectrogram::ImageMode, true);
+    item->setItemAttribute(QwtPlotItem::AutoScale, false);
+    item->setItemAttribute(QwtPlotItem::Legend, false);
+    item->setAxes(d_plot_curve[i]->xAxis(), d_plot_curve[i]->yAxis());
+    item->setZ(d_plot_curve[i]->z() - 1);
+    item->setVisible(d_density_visible);
+    item->attach(this);
+    d_density_items.push_back(item);
+  }
+
+  updateDensity();
+  replot();
+}
+
+void
+ConstellationDisplayPlot::updateDensity()
+{
+  if(!d_density || !d_density_visible) {
+    return;
+  }
+
+  const unsigned int width = d_density->width();
+
+  for(int i = 0; i < d_density_items.size(); i++) {
+    QwtPlotSpectrogram *item = d_density_items[i];
+
+    // The cells follow the visible area; zooming or panning starts the
+    // accumulation over
+    QwtInterval xrange = axisInterval(item->xAxis()).normalized();
+    QwtInterval yrange = axisInterval(item->yAxis()).normalized();
+    if(xrange.minValue() != d_density->horizontalMin(i) ||
+       xrange.maxValue() != d_density->horizontalMax(i)) {
+      d_density->setHorizontalRange(i, xrange.minValue(), xrange.maxValue());
+    }
+    if(yrange.minValue() != d_density->verticalMin(i) ||
+       yrange.maxValue() != d_density->verticalMax(i)) {
+      d_density->setVerticalRange(i, yrange.minValue(), yrange.maxValue());
+    }
+
+    d_density->snapshot(i, d_density_snapshot);
+
+    QwtMatrixRasterData *data = new QwtMatrixRasterData();
+    data->setValueMatrix(QVector<double>::fromStdVector(d_density_snapshot),
+                         width);
+    data->setInterval(Qt::XAxis, xrange);
+    data->setInterval(Qt::YAxis, yrange);
+    data->setInterval(Qt::ZAxis, QwtInterval(0.0, 1.0));
+    item->setData(data);
+  }
+}
+
+void
+ConstellationDisplayPlot::setDensityVisible(bool visible)
+{
+  d_density_visible = visible && d_density;
+
+  for(QwtPlotSpectrogram *item : qAsConst(d_density_items)) {
+    item->setVisible(d_density_visible);
+  }
+  for(int i = 0; i < d_nplots; i++) {
+    d_plot_curve[i]->setVisible(!d_density_visible);
+  }
+
+  updateDensity();
+  replot();
+}
+
+bool
+ConstellationDisplayPlot::densityVisible() const
+{
+  return d_density_visible;
+}
+
 void
 ConstellationDisplayPlot::replot()
 {
@@ -277,11 +378,47 @@ ConstellationDisplayPlot::newData(const QEvent* updateEvent)
 			 0);
 }
 
+void
+ConstellationDisplayPlot::newFrame(const QEvent* updateEvent)
+{
+  FrameReadyEvent *fevent = (FrameReadyEvent*)updateEvent;
+  const adiscope::FrameExchange::Slot *slot = fevent->exchange()->take();
+
+  if(!slot) {
+    return;
+  }
+
+  // The sink already binned the points into the density raster
+  if(d_density_visible) {
+    if(!d_stop) {
+      updateDensity();
+      replot();
+    }
+    return;
+  }
+
+  // The frame holds the real parts of all the inputs, then the imaginary ones
+  const size_t nplots = slot->frame->numChannels() / 2;
+  std::vector<double*> realDataPoints(nplots);
+  std::vector<double*> imagDataPoints(nplots);
+  for(size_t i = 0; i < nplots; i++) {
+    realDataPoints[i] = slot->frame->channel(i) + slot->offset;
+    imagDataPoints[i] = slot->frame->channel(nplots + i) + slot->offset;
+  }
+
+  this->plotNewData(realDataPoints,
+			 imagDataPoints,
+			 slot->size,
+			 0);
+}
+
 void
 ConstellationDisplayPlot::customEvent(QEvent * e)
 {
   if(e->type() == ConstUpdateEvent::Type()) {
     newData(e);
+  } else if(e->type() == FrameReadyEvent::Type()) {
+    newFrame(e);
   }
 }
 
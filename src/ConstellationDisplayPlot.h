@@ -44,9 +44,13 @@
 
 #include <stdint.h>
 #include <cstdio>
+#include <memory>
 #include <vector>
 
+#include <qwt_plot_spectrogram.h>
+
 #include "DisplayPlot.h"
+#include "persistence_raster.hpp"
 #include "spectrumUpdateEvents.h"
 
 namespace adiscope {
@@ -81,6 +85,14 @@ public:
 		double ymin, double ymax);
   void set_pen_size(int size);
 
+  /*
+   * Density raster filled by the XY sink; when shown, it replaces the
+   * curves and the drawing cost no longer depends on the number of points
+   */
+  void setDensityRaster(const std::shared_ptr<PersistenceRaster> &raster);
+  void setDensityVisible(bool visible);
+  bool densityVisible() const;
+
 public Q_SLOTS:
   void setAutoScale(bool state);
 
@@ -88,6 +100,7 @@ public Q_SLOTS:
 
 private Q_SLOTS:
   void newData(const QEvent*);
+  void newFrame(const QEvent*);
 
 private:
   void _autoScale(double bottom, double top);
@@ -96,6 +109,12 @@ private:
   std::vector<double*> d_imag_data;
 
   int64_t d_pen_size;
+
+  std::shared_ptr<PersistenceRaster> d_density;
+  QVector<QwtPlotSpectrogram *> d_density_items;
+  bool d_density_visible;
+  std::vector<double> d_density_snapshot;
+  void updateDensity();
 };
 } //adiscope
 
@@ -28,13 +28,105 @@
 #include "osc_scale_engine.h"
 
 #include <QDebug>
+#include <QtConcurrentRun>
+#include <algorithm>
 #include <qwt_symbol.h>
+#include <qwt_scale_widget.h>
 #include <boost/make_shared.hpp>
+#include <volk/volk.h>
 
 #define ERROR_VALUE -10000000
 
+/* Default largest error of the dB conversion, in dB */
+static const double DEFAULT_LOG_ACCURACY = 0.001;
+
 using namespace adiscope;
 
+/*
+ * One spectrum on its way through the worker thread. Once processed, its
+ * arrays are swapped with y_original_data and y_data, so the ones shown
+ * before get filled by the next job.
+ */
+struct FftDisplayPlot::SpectrumJob {
+	uint64_t nbPoints;
+	bool complete;
+	std::vector<double *> input;
+	std::vector<double *> output;
+
+	// Frequency span of the spectrum
+	double start;
+	double stop;
+
+	// Bins the worker converts to the display unit, see LazyBins
+	size_t from;
+	size_t to;
+	std::vector<LazyBins> lazy;
+	MagnitudeType magType;
+	double norm;
+	std::vector<double> scale;
+
+	SpectrumJob(): nbPoints(0), complete(false), start(0), stop(0),
+		from(0), to(0), magType(DBFS), norm(1) {}
+
+	~SpectrumJob()
+	{
+		release();
+	}
+
+	void release()
+	{
+		for (size_t i = 0; i < input.size(); i++) {
+			delete[] input[i];
+			delete[] output[i];
+		}
+
+		input.clear();
+		output.clear();
+	}
+
+	void fill(const std::vector<double *> &pts, unsigned int nplots,
+		  uint64_t size)
+	{
+		if (size != nbPoints || input.size() != nplots) {
+			release();
+
+			for (unsigned int i = 0; i < nplots; i++) {
+				input.push_back(new double[size]);
+				output.push_back(new double[size]);
+			}
+
+			nbPoints = size;
+		}
+
+		for (unsigned int i = 0; i < nplots; i++) {
+			memcpy(input[i], pts[i], size * sizeof(double));
+		}
+
+		complete = false;
+	}
+};
+
+/*
+ * out = scale * log10(in) + offset. The logarithm is taken in single
+ * precision, within the accuracy set on the plot, which is plenty for a
+ * display in dB.
+ */
+static void log10Scaled(const double *in, double *out, size_t size,
+			double scale, double offset, std::vector<float> &scratch,
+			const FastLog &fastLog)
+{
+	scratch.resize(size);
+	float *tmp = scratch.data();
+	const double k = scale * M_LN2 / M_LN10;
+
+	volk_64f_convert_32f(tmp, in, size);
+	fastLog.log2(tmp, tmp, size);
+
+	for (size_t i = 0; i < size; i++) {
+		out[i] = tmp[i] * k + offset;
+	}
+}
+
 class FftDisplayZoomer: public LimitedPlotZoomer
 {
 public:
@@ -73,6 +165,16 @@ FftDisplayPlot::FftDisplayPlot(int nplots, QWidget *parent) :
 	d_stop_frequency(1000),
 	d_sampl_rate(1),
 	d_preset_sampl_rate(d_sampl_rate),
+	d_zoomed(false),
+	d_preset_zoomed(false),
+	d_center_frequency(0),
+	d_preset_center_frequency(0),
+	d_sweep_points(0),
+	d_preset_sweep_points(0),
+	d_sweep_start(0),
+	d_preset_sweep_start(0),
+	d_sweep_stop(0),
+	d_preset_sweep_stop(0),
 	d_presetMagType(MagnitudeType::DBFS),
 	d_mrkCtrl(nullptr),
 	d_emitNewMkrData(true),
@@ -80,8 +182,20 @@ FftDisplayPlot::FftDisplayPlot(int nplots, QWidget *parent) :
 	d_logScaleEnabled(false),
 	d_buffer_idx(0),
 	d_nb_overlapping_avg(1),
+	d_processPoints(0),
+	d_processSweepPoints(0),
+	d_waterfall_channel(0),
+	d_fastLog(logAccuracyToError(DEFAULT_LOG_ACCURACY)),
+	d_lazyFrom(0),
+	d_lazyTo(0),
+	d_lazyMagType(DBFS),
+	d_lazyNorm(1),
 	n_ref_curves(0)
 {
+	// Spectra are processed in order, one at a time
+	d_pool.setMaxThreadCount(1);
+	connect(&d_watcher, SIGNAL(finished()), SLOT(onSpectrumProcessed()));
+
 	// TO DO: Add more colors
 	d_markerColors << QColor(255, 242, 0) << QColor(210, 155, 210);
 	d_zoomer.push_back(nullptr);
@@ -114,6 +228,7 @@ FftDisplayPlot::FftDisplayPlot(int nplots, QWidget *parent) :
 	d_ch_avg_obj.resize(nplots);
 	d_win_coefficient_sum_sqr.resize(nplots);
 	d_win_coefficient_sum.resize(nplots);
+	d_band_power.resize(nplots);
 
 	m_sweepStart = 0;
 	m_sweepStop = 1000;
@@ -135,6 +250,10 @@ FftDisplayPlot::FftDisplayPlot(int nplots, QWidget *parent) :
 	setAxisScaleDraw(QwtAxis::XBottom, xScaleDraw);
 	xScaleDraw->setFloatPrecision(2);
 
+	// The waterfall columns follow the frequency axis
+	connect(axisWidget(QwtAxis::XBottom), &QwtScaleWidget::scaleDivChanged,
+		this, &FftDisplayPlot::updateWaterfallAxes);
+
 	_resetXAxisPoints();
 
 	d_mrkCtrl = new MarkerController(this);
@@ -186,6 +305,9 @@ FftDisplayPlot::FftDisplayPlot(int nplots, QWidget *parent) :
 
 FftDisplayPlot::~FftDisplayPlot()
 {
+	d_watcher.disconnect(this);
+	d_pool.waitForDone();
+
 	for (uint c = 0; c < d_nplots + n_ref_curves; c++) {
 		for (uint i = 0; i < d_markers[c].size(); i++) {
 			d_markers[c][i].ui->detach();
@@ -552,6 +674,8 @@ void FftDisplayPlot::unregisterReferenceWaveform(QString name)
 
 void FftDisplayPlot::setWindowCoefficientSum(unsigned int ch, float sum, float sqr_sum)
 {
+	std::lock_guard<std::mutex> lock(d_processMutex);
+
 	d_win_coefficient_sum[ch] = sum;
 	d_win_coefficient_sum_sqr[ch] = sqr_sum;
 }
@@ -602,6 +726,7 @@ void FftDisplayPlot::useLogFreq(bool use_log_freq)
 	}
 	d_logScaleEnabled = use_log_freq;
 	replot();
+	updateWaterfallAxes();
 }
 
 std::vector<double*> FftDisplayPlot::getOrginal_data() {
@@ -628,32 +753,63 @@ int64_t FftDisplayPlot::getNumPoints()
 void FftDisplayPlot::plotData(const std::vector<double *> &pts,
 		uint64_t num_points)
 {
-	uint64_t halfNumPoints = num_points / 2;
 	bool numPointsChanged = false;
 	bool samplRateChanged = false;
 	bool magTypeChanged = false;
 
-	// Update sample rate if required
-	if (d_sampl_rate != d_preset_sampl_rate) {
+	// Update sample rate and band if required
+	if (d_sampl_rate != d_preset_sampl_rate ||
+			d_zoomed != d_preset_zoomed ||
+			d_center_frequency != d_preset_center_frequency ||
+			d_sweep_points != d_preset_sweep_points ||
+			d_sweep_start != d_preset_sweep_start ||
+			d_sweep_stop != d_preset_sweep_stop) {
+		// The worker reads the rate for the noise bandwidth
+		std::unique_lock<std::mutex> lock(d_processMutex);
 		d_sampl_rate = d_preset_sampl_rate;
-		d_start_frequency = 0;
-		d_stop_frequency = d_sampl_rate / 2;
+		d_processSweepPoints = d_preset_sweep_points;
+		lock.unlock();
+
+		d_zoomed = d_preset_zoomed;
+		d_center_frequency = d_preset_center_frequency;
+		d_sweep_points = d_preset_sweep_points;
+		d_sweep_start = d_preset_sweep_start;
+		d_sweep_stop = d_preset_sweep_stop;
+
+		if (d_sweep_points) {
+			d_start_frequency = d_sweep_start;
+			d_stop_frequency = d_sweep_stop;
+		} else if (d_zoomed) {
+			d_start_frequency = d_center_frequency - d_sampl_rate / 2;
+			d_stop_frequency = d_center_frequency + d_sampl_rate / 2;
+		} else {
+			d_start_frequency = 0;
+			d_stop_frequency = d_sampl_rate / 2;
+		}
+
 		samplRateChanged = true;
 
 		Q_EMIT sampleRateUpdated(d_sampl_rate);
 	}
 
+	// The spectrum of a real signal is symmetric, only the first half
+	// is shown. Zoomed and swept spectra are complex and shown whole.
+	uint64_t nbPoints = d_zoomed || d_sweep_points ?
+		num_points : num_points / 2;
+
 	if (d_magType != d_presetMagType) {
+		std::lock_guard<std::mutex> lock(d_processMutex);
+
 		d_magType = d_presetMagType;
 		magTypeChanged = true;
 	}
 
-	if (d_stop || halfNumPoints == 0)
+	if (d_stop || nbPoints == 0)
 		return;
 
-	if (halfNumPoints != d_numPoints || d_firstInit) {
+	if (nbPoints != d_numPoints || d_firstInit) {
 		d_firstInit = false;
-		d_numPoints = halfNumPoints;
+		d_numPoints = nbPoints;
 		numPointsChanged = true;
 
 		Q_EMIT sampleCountUpdated(d_numPoints);
@@ -661,56 +817,53 @@ void FftDisplayPlot::plotData(const std::vector<double *> &pts,
 		if (x_data)
 			delete []x_data;
 
-		x_data = new double[halfNumPoints];
+		x_data = new double[nbPoints];
+		d_lazyBins.clear();
 
+		// The curves stay empty until a spectrum of the new size
+		// comes out of the worker. The data is zeroed meanwhile, as
+		// it can still be recalculated before then.
 		for (unsigned int i = 0; i < d_nplots; i++) {
 			if (y_data[i])
 				delete[] y_data[i];
 			if (y_original_data[i])
 				delete[] y_original_data[i];
 
-			y_data[i] = new double[halfNumPoints];
-			y_original_data[i] = new double[halfNumPoints];
+			y_data[i] = new double[nbPoints]();
+			y_original_data[i] = new double[nbPoints]();
 
 #if QWT_VERSION < 0x060000
-			d_plot_curve[i]->setRawData(x_data,
-					y_data[i], halfNumPoints);
+			d_plot_curve[i]->setRawData(x_data, y_data[i], 0);
 #else
-			d_plot_curve[i]->setRawSamples(x_data,
-					y_data[i], halfNumPoints);
+			d_plot_curve[i]->setRawSamples(x_data, y_data[i], 0);
 #endif
 		}
 
+		std::lock_guard<std::mutex> lock(d_processMutex);
+		d_processPoints = nbPoints;
+
 		// Resize the average objects to the new number of points
 		for (size_t i = 0; i < d_ch_avg_obj.size(); i++) {
 			if (!d_ch_avg_obj[i])
 				continue;
 
 			uint size = d_ch_avg_obj[i]->dataWidth();
-			if (size == halfNumPoints)
+			if (size == nbPoints)
 				continue;
 
 			uint h = d_ch_avg_obj[i]->history();
 			bool h_en = d_ch_avg_obj[i]->historyEnabled();
 			d_ch_avg_obj[i] = getNewAvgObject(
-				d_ch_average_type[i], halfNumPoints, h, h_en);
+				d_ch_average_type[i], nbPoints, h, h_en);
 		}
 	}
 
-	// We store the received data before touching it
-	for (unsigned int i = 0; i < d_nplots; i++) {
-		memcpy(y_original_data[i], pts[i],
-				halfNumPoints * sizeof(double));
-	}
-
 	// When the magnitude type changes, we reset the data that is
 	// being stored in the average objects
 	if (magTypeChanged) {
 		resetAverageHistory();
 	}
 
-	averageDataAndComputeMagnitude(y_original_data, y_data, halfNumPoints);
-
 	_resetXAxisPoints();
 
 	if (numPointsChanged) {
@@ -749,16 +902,252 @@ void FftDisplayPlot::plotData(const std::vector<double *> &pts,
 		}
 	}
 
-	detectMarkers();
+	submitSpectrum(pts, nbPoints);
+}
 
-	_editFirstPoint();
-	replot();
+/*
+ * Averaging and the conversion to the display unit run on the worker
+ * thread. While one spectrum is processed, only the newest of the ones
+ * that arrive in the meantime is kept for after it.
+ */
+void FftDisplayPlot::submitSpectrum(const std::vector<double *> &pts,
+				    uint64_t nbPoints)
+{
+	if (d_runningJob) {
+		if (!d_pendingJob) {
+			d_pendingJob = takeJob();
+		}
 
-	Q_EMIT newData();
+		d_pendingJob->fill(pts, d_nplots, nbPoints);
+		d_pendingJob->start = d_start_frequency;
+		d_pendingJob->stop = d_stop_frequency;
+		convertedRange(nbPoints, d_start_frequency, d_stop_frequency,
+			       d_pendingJob->from, d_pendingJob->to);
+		return;
+	}
+
+	std::shared_ptr<SpectrumJob> job = takeJob();
+
+	job->fill(pts, d_nplots, nbPoints);
+	job->start = d_start_frequency;
+	job->stop = d_stop_frequency;
+	convertedRange(nbPoints, d_start_frequency, d_stop_frequency,
+		       job->from, job->to);
+	startJob(job);
+}
+
+std::shared_ptr<FftDisplayPlot::SpectrumJob> FftDisplayPlot::takeJob()
+{
+	if (d_spareJob) {
+		return std::move(d_spareJob);
+	}
+
+	return std::make_shared<SpectrumJob>();
+}
+
+void FftDisplayPlot::startJob(const std::shared_ptr<SpectrumJob> &job)
+{
+	d_runningJob = job;
+
+	SpectrumJob *raw = job.get();
+	d_watcher.setFuture(QtConcurrent::run(&d_pool, [this, raw]() {
+		std::lock_guard<std::mutex> lock(d_processMutex);
+
+		// The waterfall shows every bin
+		if (d_waterfall) {
+			raw->from = 0;
+			raw->to = raw->nbPoints;
+		}
+
+		// The average objects may have been resized since
+		raw->complete = raw->nbPoints == d_processPoints &&
+			averageDataAndComputeMagnitude(raw->input,
+				raw->output, raw->nbPoints, raw->from,
+				raw->to, raw->lazy);
+
+		raw->magType = d_magType;
+		raw->norm = d_processSweepPoints ?
+			d_processSweepPoints : raw->nbPoints;
+		raw->scale = y_scale_factor;
+
+		if (raw->complete) {
+			updateBandPower(raw->input, raw->nbPoints,
+					raw->start, raw->stop);
+		}
+
+		// The waterfall rows are written here, off the GUI thread
+		if (raw->complete && d_waterfall &&
+				d_waterfall_channel < d_nplots) {
+			d_waterfall->push(raw->output[d_waterfall_channel],
+					  raw->nbPoints, raw->start, raw->stop);
+		}
+	}));
+}
+
+/* Swaps the processed spectrum in, then updates markers and the curves */
+void FftDisplayPlot::onSpectrumProcessed()
+{
+	std::shared_ptr<SpectrumJob> job = std::move(d_runningJob);
+
+	if (!job) {
+		return;
+	}
+
+	if (d_pendingJob) {
+		std::shared_ptr<SpectrumJob> next = std::move(d_pendingJob);
+		startJob(next);
+	}
+
+	// Spectra of a size that is no longer shown are dropped
+	if (job->complete && job->nbPoints == (uint64_t)d_numPoints) {
+		for (unsigned int i = 0; i < d_nplots; i++) {
+			std::swap(y_data[i], job->output[i]);
+			std::swap(y_original_data[i], job->input[i]);
+
+#if QWT_VERSION < 0x060000
+			d_plot_curve[i]->setRawData(x_data, y_data[i],
+						    d_numPoints);
+#else
+			d_plot_curve[i]->setRawSamples(x_data, y_data[i],
+						       d_numPoints);
+#endif
+		}
+
+		d_lazyBins = job->lazy;
+		d_lazyFrom = job->from;
+		d_lazyTo = job->to;
+		d_lazyMagType = job->magType;
+		d_lazyNorm = job->norm;
+		d_lazyScale = job->scale;
+
+		// The band shown may have moved while the job was running
+		size_t from, to;
+		convertedRange(d_numPoints, d_start_frequency,
+			       d_stop_frequency, from, to);
+
+		if (!isStarted() || from < job->from || to > job->to) {
+			convertLazyBins();
+		}
+
+		detectMarkers();
+
+		_editFirstPoint();
+		replot();
+
+		updateWaterfallAxes();
+
+		Q_EMIT newData();
+	}
+
+	d_spareJob = job;
+}
+
+/*
+ * Prefix sums of the power of every channel, in V^2 per bin, for the
+ * band measurements. The power of a bin is the square of its VRMS
+ * value; dividing by the noise bandwidth of the window, in bins, makes
+ * the sum over a band the power of that band.
+ */
+void FftDisplayPlot::updateBandPower(const std::vector<double *> &in_data,
+				     uint64_t nb_points, double start,
+				     double stop)
+{
+	const double bin_width = (stop - start) / nb_points;
+	const double norm = d_processSweepPoints ?
+		d_processSweepPoints : nb_points;
+
+	for (unsigned int i = 0; i < d_nplots; i++) {
+		double scale = y_scale_factor[i] * y_scale_factor[i] /
+			(2.0 * norm * norm);
+
+		if (d_win_coefficient_sum[i] > 0 && d_sampl_rate > 0) {
+			double enbw = d_sampl_rate * d_win_coefficient_sum_sqr[i] /
+				(d_win_coefficient_sum[i] * d_win_coefficient_sum[i]);
+			scale *= bin_width / enbw;
+		}
+
+		d_band_power[i].update(in_data[i], nb_points, start, stop,
+				       scale);
+	}
+}
+
+double FftDisplayPlot::bandPower(uint chIdx, double from, double to)
+{
+	std::lock_guard<std::mutex> lock(d_processMutex);
+
+	if (chIdx >= d_band_power.size()) {
+		return 0;
+	}
+
+	return d_band_power[chIdx].power(from, to);
+}
+
+bool FftDisplayPlot::occupiedBandwidth(uint chIdx, double fraction,
+				       double &low, double &high)
+{
+	std::lock_guard<std::mutex> lock(d_processMutex);
+
+	if (chIdx >= d_band_power.size()) {
+		return false;
+	}
+
+	return d_band_power[chIdx].occupiedBandwidth(fraction, low, high);
+}
+
+void FftDisplayPlot::setWaterfallRaster(
+		const std::shared_ptr<WaterfallRaster> &raster,
+		unsigned int chIdx)
+{
+	{
+		std::lock_guard<std::mutex> lock(d_processMutex);
+
+		d_waterfall = raster;
+		d_waterfall_channel = chIdx;
+
+		if (raster) {
+			raster->clear();
+		}
+	}
+
+	updateWaterfallAxes();
+}
+
+/*
+ * The columns of the waterfall span the frequencies under the canvas, and
+ * its colours the vertical axis of its channel
+ */
+void FftDisplayPlot::updateWaterfallAxes()
+{
+	std::shared_ptr<WaterfallRaster> raster;
+	unsigned int chIdx;
+
+	{
+		std::lock_guard<std::mutex> lock(d_processMutex);
+		raster = d_waterfall;
+		chIdx = d_waterfall_channel;
+	}
+
+	if (!raster || chIdx >= d_nplots) {
+		return;
+	}
+
+	const QwtScaleMap xMap = canvasMap(QwtAxis::XBottom);
+
+	raster->setView(xMap.invTransform(0), xMap.invTransform(
+		canvas()->width()), d_logScaleEnabled);
+
+	QwtInterval range = axisInterval(d_plot_curve[chIdx]->yAxis())
+		.normalized();
+	raster->setRange(range.minValue(), range.maxValue());
 }
 
 void FftDisplayPlot::_editFirstPoint()
 {
+	// A zoomed or swept band has no mirrored DC bin to hide
+	if (d_zoomed || d_sweep_points) {
+		return;
+	}
+
 	// Set first point on the xAxis to 1 in order for it to
 	// be plotted and make the y_data[i][0] values equal to the ones
 	// of the next point to draw a straight line from the start of
@@ -770,10 +1159,82 @@ void FftDisplayPlot::_editFirstPoint()
 
 }
 
-void FftDisplayPlot::averageDataAndComputeMagnitude(std::vector<double *>
-	in_data, std::vector<double *> out_data, uint64_t nb_points)
+/* dst[from, to) = src[from, to) in the given unit; VROOTHZ is not handled */
+void FftDisplayPlot::convertMagnitude(MagnitudeType type, double scale,
+				      double norm, const double *src,
+				      double *dst, size_t from, size_t to)
+{
+	if (from >= to) {
+		return;
+	}
+
+	const size_t size = to - from;
+	src += from;
+	dst += from;
+
+	switch (type) {
+	//dB Full-Scale
+	case DBFS:
+		log10Scaled(src, dst, size, 10,
+			-10 * log10(2048.0 * 2048.0) -
+			20 * log10(norm), d_logScratch, d_fastLog);
+		break;
+	case DBV:
+		log10Scaled(src, dst, size, 10,
+			20 * log10(scale) -
+			20 * log10(norm) -
+			20 * log10(sqrt(2)), d_logScratch, d_fastLog);
+		break;
+	case DBU:
+		log10Scaled(src, dst, size, 10,
+			20 * log10(scale) -
+			20 * log10(norm) -
+			20 * log10(sqrt(2) * 0.77459667), d_logScratch,
+			d_fastLog);
+		break;
+	case VPEAK: {
+		const double k = scale / norm;
+
+		for (size_t s = 0; s < size; s++) {
+			dst[s] = sqrt(src[s]) * k;
+		}
+		break;
+	}
+	case VRMS: {
+		/* Another formula for this would be
+		 * sqrt(2 * (sqrt(source[i][s]) * sqrt(source[i][s])) /
+		 * (d_win_coefficient_sum * d_win_coefficient_sum));
+		 * This are equivalent (the only difference is the moment
+		 * when we apply the window compensation (before the FFT, or after.
+		 * With the current version, this is applied before (in calcCoherentPowerGain)
+		 */
+		const double k = scale / sqrt(2) / norm;
+
+		for (size_t s = 0; s < size; s++) {
+			dst[s] = sqrt(src[s]) * k;
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+bool FftDisplayPlot::averageDataAndComputeMagnitude(std::vector<double *>
+	in_data, std::vector<double *> out_data, uint64_t nb_points,
+	size_t from, size_t to, std::vector<LazyBins> &lazy)
 {
 	std::vector<double *> source;
+	const bool complete = d_magType != VROOTHZ ||
+		d_buffer_idx == (d_nb_overlapping_avg - 1);
+
+	// Bins keep the scale of the transform they come from
+	const double norm = d_processSweepPoints ?
+		d_processSweepPoints : nb_points;
+
+	to = std::min<size_t>(to, nb_points);
+	from = std::min(from, to);
+	lazy.assign(d_nplots, CONVERTED);
 
 	if (d_buffer_idx == 0) {
 		d_ps_avg.resize(d_nplots);
@@ -806,55 +1267,34 @@ void FftDisplayPlot::averageDataAndComputeMagnitude(std::vector<double *>
 		if (d_buffer_idx == 0) {
 			d_ps_avg[i].resize(nb_points);
 		}
-		for (int s = 0; s < nb_points; s++) {
-			//dB Full-Scale
-			switch (d_magType) {
-			case DBFS:
-				out_data[i][s] = 10 * log10((source[i][s] /
-					(2048 * 2048)) /
-					(nb_points * nb_points));
-				break;
-			case DBV:
-				out_data[i][s] = 10 * log10(source[i][s]) +
-					20 * log10(y_scale_factor[i]) -
-					20 * log10(nb_points) -
-					20 * log10(sqrt(2));
-				break;
-			case DBU:
-				out_data[i][s] = 10 * log10(source[i][s]) +
-					20 * log10(y_scale_factor[i]) -
-					20 * log10(nb_points) -
-					20 * log10(sqrt(2) * 0.77459667);
-				break;
-			case VPEAK:
-				out_data[i][s] = sqrt(source[i][s]) *
-					y_scale_factor[i] / nb_points;
-				break;
-			case VRMS:
-				/* Another formula for this would be
-				 * sqrt(2 * (sqrt(source[i][s]) * sqrt(source[i][s])) /
-				 * (d_win_coefficient_sum * d_win_coefficient_sum));
-				 * This are equivalent (the only difference is the moment
-				 * when we apply the window compensation (before the FFT, or after.
-				 * With the current version, this is applied before (in calcCoherentPowerGain)
-				 */
-				out_data[i][s] = sqrt(source[i][s]) *
-					y_scale_factor[i] / sqrt(2) / nb_points;
-				break;
-			case VROOTHZ:
-				auto ps_rms = sqrt(source[i][s]) * y_scale_factor[i] /  sqrt(2) / nb_points;
+		const double *src = source[i];
+		double *dst = out_data[i];
+
+		if (d_magType == VROOTHZ) {
+			for (uint64_t s = 0; s < nb_points; s++) {
+				auto ps_rms = sqrt(src[s]) * y_scale_factor[i] /  sqrt(2) / norm;
 				d_ps_avg[i][s] = sqrt((d_ps_avg[i][s] * d_ps_avg[i][s]) + (ps_rms * ps_rms));
 
-				if (d_buffer_idx == (d_nb_overlapping_avg - 1)) {
+				if (complete) {
 					d_ps_avg[i][s] = d_ps_avg[i][s] / sqrt(d_nb_overlapping_avg);
 					auto ls_rms = d_ps_avg[i][s];
 					auto enbw = d_sampl_rate * d_win_coefficient_sum_sqr[i] /
 							(d_win_coefficient_sum[i] * d_win_coefficient_sum[i]);
 					auto ls_d_rms = ls_rms / sqrt(enbw);
-					out_data[i][s] = ls_d_rms;
+					dst[s] = ls_d_rms;
 				}
-				break;
-			};
+			}
+		} else if (needs_dB_avg) {
+			// The history is kept in dB, every bin goes into it
+			convertMagnitude(d_magType, y_scale_factor[i], norm,
+					 src, dst, 0, nb_points);
+		} else {
+			convertMagnitude(d_magType, y_scale_factor[i], norm,
+					 src, dst, from, to);
+
+			if (from > 0 || to < nb_points) {
+				lazy[i] = src == dst ? IN_PLACE : FROM_INPUT;
+			}
 		}
 
 		if (needs_dB_avg) {
@@ -868,6 +1308,106 @@ void FftDisplayPlot::averageDataAndComputeMagnitude(std::vector<double *>
 	} else {
 		d_buffer_idx++;
 	}
+
+	return complete;
+}
+
+/*
+ * Bins of a spectrum that must be converted right away: the visible
+ * band, when peaks are only searched there, and the bins of the fixed
+ * markers.
+ */
+void FftDisplayPlot::convertedRange(uint64_t nbPoints, double start,
+				    double stop, size_t &from,
+				    size_t &to) const
+{
+	from = 0;
+	to = nbPoints;
+
+	if (!m_visiblePeakSearch || !(stop > start)) {
+		return;
+	}
+
+	// One more bin on each side for the rounding of peakSearchRange
+	const double coef = nbPoints / (stop - start);
+	from = qBound<double>(0, floor((m_sweepStart - start) * coef) - 1,
+			      nbPoints);
+	to = qBound<double>(from, ceil((m_sweepStop - start) * coef) + 1,
+			    nbPoints);
+
+	for (int c = 0; c < d_nplots; c++) {
+		for (const marker &m : d_markers[c]) {
+			if (!m.data || m.data->type != 0 || m.data->bin < 0) {
+				continue;
+			}
+
+			const size_t bin = std::min<size_t>(m.data->bin,
+							    nbPoints - 1);
+			from = std::min(from, bin);
+			to = std::max(to, bin + 1);
+		}
+	}
+}
+
+/* Converts what the worker left of the shown spectrum */
+bool FftDisplayPlot::convertLazyBins()
+{
+	bool converted = false;
+
+	{
+		std::lock_guard<std::mutex> lock(d_processMutex);
+
+		for (size_t i = 0; i < d_lazyBins.size(); i++) {
+			if (d_lazyBins[i] == CONVERTED || !y_data[i]) {
+				continue;
+			}
+
+			const double *src = d_lazyBins[i] == FROM_INPUT ?
+				y_original_data[i] : y_data[i];
+
+			convertMagnitude(d_lazyMagType, d_lazyScale[i],
+					 d_lazyNorm, src, y_data[i], 0,
+					 d_lazyFrom);
+			convertMagnitude(d_lazyMagType, d_lazyScale[i],
+					 d_lazyNorm, src, y_data[i], d_lazyTo,
+					 d_numPoints);
+			converted = true;
+		}
+
+		d_lazyBins.clear();
+	}
+
+	if (converted) {
+		_editFirstPoint();
+	}
+
+	return converted;
+}
+
+void FftDisplayPlot::completeSpectrum()
+{
+	if (convertLazyBins()) {
+		detectMarkers();
+		replot();
+	}
+}
+
+/* The accuracy is given in dB, the error of the logarithm in log2 */
+double FftDisplayPlot::logAccuracyToError(double dB)
+{
+	return dB / (10 * log10(2.0));
+}
+
+double FftDisplayPlot::logAccuracy() const
+{
+	return d_fastLog.maxError() * 10 * log10(2.0);
+}
+
+void FftDisplayPlot::setLogAccuracy(double dB)
+{
+	std::lock_guard<std::mutex> lock(d_processMutex);
+
+	d_fastLog.setMaxError(logAccuracyToError(dB));
 }
 
 void FftDisplayPlot::_resetXAxisPoints()
@@ -924,9 +1464,12 @@ void FftDisplayPlot::setSampleRate(double sr, double units,
 {
 	d_start_frequency = 0;
 	d_stop_frequency = sr / 2;
-	d_sampl_rate = sr;
 	d_preset_sampl_rate = sr;
 
+	std::unique_lock<std::mutex> lock(d_processMutex);
+	d_sampl_rate = sr;
+	lock.unlock();
+
 	_resetXAxisPoints();
 }
 
@@ -940,6 +1483,28 @@ void FftDisplayPlot::presetSampleRate(double sr)
 	d_preset_sampl_rate = sr;
 }
 
+/*
+ * When enabled, the data is the two sided spectrum of a band of the
+ * preset sample rate around center, e.g. from a down converter.
+ */
+void FftDisplayPlot::presetZoom(bool enabled, double center)
+{
+	d_preset_zoomed = enabled;
+	d_preset_center_frequency = enabled ? center : 0;
+}
+
+/*
+ * With a non zero fftSize, the data is a band from start to stop
+ * stitched from the zoomed spectra of several transforms of fftSize
+ * bins, at the preset sample rate. A zero fftSize ends the sweep.
+ */
+void FftDisplayPlot::presetSweep(uint64_t fftSize, double start, double stop)
+{
+	d_preset_sweep_points = fftSize;
+	d_preset_sweep_start = fftSize ? start : 0;
+	d_preset_sweep_stop = fftSize ? stop : 0;
+}
+
 FftDisplayPlot::AverageType FftDisplayPlot::averageType(uint chIdx) const
 {
 	if (chIdx < d_ch_average_type.size())
@@ -966,6 +1531,7 @@ void FftDisplayPlot::setAverage(uint chIdx, enum AverageType avg_type,
 		return;
 	}
 
+	std::unique_lock<std::mutex> lock(d_processMutex);
 
 	if (d_ch_avg_obj[chIdx] && (history != d_ch_avg_obj[chIdx]->history())
 			&& (history_en == d_ch_avg_obj[chIdx]->historyEnabled())) {
@@ -974,19 +1540,30 @@ void FftDisplayPlot::setAverage(uint chIdx, enum AverageType avg_type,
 		d_ch_average_type[chIdx] = avg_type;
 		d_ch_avg_obj[chIdx] = getNewAvgObject(avg_type, d_numPoints, history, history_en);
 		d_current_avg_index[chIdx] = 0;
-		Q_EMIT currentAverageIndex(chIdx, d_current_avg_index[chIdx]);
+		lock.unlock();
+		Q_EMIT currentAverageIndex(chIdx, 0);
 	}
 }
 
 void FftDisplayPlot::resetAverageHistory()
 {
-	for (size_t i = 0; i < d_ch_avg_obj.size(); i++)
-		if (d_ch_avg_obj[i])
-			d_ch_avg_obj[i]->reset();
+	size_t nb_channels;
 
-	for (size_t i = 0; i < d_current_avg_index.size(); i++) {
-		d_current_avg_index[i] = 0;
-		Q_EMIT currentAverageIndex(i, d_current_avg_index[i]);
+	{
+		std::lock_guard<std::mutex> lock(d_processMutex);
+
+		for (size_t i = 0; i < d_ch_avg_obj.size(); i++)
+			if (d_ch_avg_obj[i])
+				d_ch_avg_obj[i]->reset();
+
+		nb_channels = d_current_avg_index.size();
+		for (size_t i = 0; i < nb_channels; i++) {
+			d_current_avg_index[i] = 0;
+		}
+	}
+
+	for (size_t i = 0; i < nb_channels; i++) {
+		Q_EMIT currentAverageIndex(i, 0);
 	}
 }
 
@@ -1063,91 +1640,126 @@ void FftDisplayPlot::setBtmHorAxisUnit(const QString &unit)
 	}
 }
 
-void FftDisplayPlot::findPeaks(int chn)
+/*
+ * Trace of a channel and the range of bins searched for peaks. The first
+ * bins, close to DC, are skipped unless a zoomed band is shown.
+ */
+bool FftDisplayPlot::peakSearchRange(int chn, const double *&x,
+				     const double *&y, size_t &size,
+				     size_t &start, size_t &stop) const
 {
-	QList<std::shared_ptr<struct marker_data>>& markers = d_peaks[chn];
-	QList<std::shared_ptr<struct marker_data>>& f_sort_mrks = d_freq_asc_sorted_peaks[chn];
-	int marker_count = markers.size();
-	int maxX[marker_count + 1];
-	float maxY[marker_count + 1];
-	double *x = nullptr;
-	double *y = nullptr;
-	unsigned int num_points = 0;
+	if (chn < 0 || chn >= d_nplots + n_ref_curves) {
+		return false;
+	}
+
 	if (chn < d_nplots) {
 		x = x_data;
 		y = y_data[chn];
-		num_points = d_numPoints;
+		size = d_numPoints;
 	} else {
 		x = d_refXdata[chn - d_nplots];
 		y = d_refYdata[chn - d_nplots];
-		num_points = d_plot_curve[chn]->data()->size();
+		size = d_plot_curve[chn]->data()->size();
 	}
 
 	if (!x || !y) {
-		return;
+		return false;
 	}
 
-	for (int i = 0; i <= marker_count; i++) {
-		maxX[i] = 0;
-		maxY[i] = -200.0;
+	start = d_zoomed || d_sweep_points ? 1 : 2;
+	stop = size;
+
+	if (m_visiblePeakSearch) {
+		auto coef  = size / (d_stop_frequency - d_start_frequency);
+		if ((m_sweepStart - d_start_frequency) * coef > start) {
+			start = (m_sweepStart - d_start_frequency) * coef;
+		}
+		stop = qBound<double>(0, (m_sweepStop - d_start_frequency) * coef,
+				      size);
 	}
 
-	maxY[0] = y[0];
+	return true;
+}
 
-	auto start = 3;
-	auto stop = num_points;
+void FftDisplayPlot::findPeaks(int chn)
+{
+	QList<std::shared_ptr<struct marker_data>>& markers = d_peaks[chn];
+	QList<std::shared_ptr<struct marker_data>>& f_sort_mrks = d_freq_asc_sorted_peaks[chn];
+	const double *x, *y;
+	size_t size, start, stop;
 
-	if(m_visiblePeakSearch)
-	{
-		auto coef  = num_points/d_stop_frequency;
-		if (m_sweepStart * coef > 0) {
-			start = m_sweepStart * coef;
-		}
-		stop = m_sweepStop * coef;
-		maxY[0] = y[start];
+	if (!peakSearchRange(chn, x, y, size, start, stop)) {
+		return;
 	}
 
-	for (int i = start; i < stop; i++) {
-		for (int j = 0; j < marker_count; j++ ) {
-			if (i < 2) {
-				continue;
-			}
-			if  ((y[i - 1] > maxY[j]) &&
-					((!((y[i - 2] > y[i - 1]) &&
-					 (y[i - 1] > y[i]))) &&
-					 (!((y[i - 2] < y[i - 1]) &&
-					 (y[i - 1] < y[i]))))) {
-
-				for (int k = marker_count; k > j; k--) {
-					maxY[k] = maxY[k - 1];
-					maxX[k] = maxX[k - 1];
-				}
-				maxY[j] = y[i - 1];
-				maxX[j] = i - 1;
-				break;
-			}
-		}
-	}
+	d_peakFinder.find(y, size, start, stop, markers.size());
 
-	for (int i = 0; i < marker_count; i++) {
-		markers[i]->x = x[maxX[i]];
-		markers[i]->y = y[maxX[i]];
-		markers[i]->bin = maxX[i];
-	}
+	const std::vector<PeakFinder::Peak> &peaks = d_peakFinder.peaks();
+	const std::vector<unsigned int> &by_bin = d_peakFinder.byBin();
+
+	// Markers without a peak to show stay on the first bin. They are
+	// kept after the peaks in magnitude order and before them in
+	// frequency order.
+	const int found = peaks.size();
+	const int missing = markers.size() - found;
 
 	for (int i = 0; i < markers.size(); i++) {
-		f_sort_mrks[i] = markers[i];
+		int bin = i < found ? peaks[i].bin : 0;
+
+		markers[i]->x = x[bin];
+		markers[i]->y = y[bin];
+		markers[i]->bin = bin;
+		markers[i]->active = i < found;
+	}
+
+	for (int i = 0; i < missing; i++) {
+		f_sort_mrks[i] = markers[found + i];
+	}
+	for (int i = 0; i < found; i++) {
+		f_sort_mrks[missing + i] = markers[by_bin[i]];
 	}
-	std::sort(f_sort_mrks.begin(), f_sort_mrks.end(),
-		[](const std::shared_ptr<struct marker_data> m1,
-			const std::shared_ptr<struct marker_data> m2) -> bool
-			{
-				return m1->x < m2->x;
-			});
 
 	updateMarkersUi();
 }
 
+std::vector<PeakFinder::Peak> FftDisplayPlot::topPeaks(uint chIdx,
+						       uint count) const
+{
+	const double *x, *y;
+	size_t size, start, stop;
+	PeakFinder finder;
+
+	if (!peakSearchRange(chIdx, x, y, size, start, stop)) {
+		return std::vector<PeakFinder::Peak>();
+	}
+
+	finder.setThreshold(d_peakFinder.threshold());
+	finder.setMinProminence(d_peakFinder.minProminence());
+	finder.find(y, size, start, stop, count);
+
+	return finder.peaks();
+}
+
+double FftDisplayPlot::peakThreshold() const
+{
+	return d_peakFinder.threshold();
+}
+
+void FftDisplayPlot::setPeakThreshold(double threshold)
+{
+	d_peakFinder.setThreshold(threshold);
+}
+
+double FftDisplayPlot::peakProminence() const
+{
+	return d_peakFinder.minProminence();
+}
+
+void FftDisplayPlot::setPeakProminence(double prominence)
+{
+	d_peakFinder.setMinProminence(prominence);
+}
+
 void FftDisplayPlot::updateMarkerUi(uint chIdx, uint mkIdx)
 {
 	auto marker = d_markers[chIdx][mkIdx];
@@ -1273,6 +1885,10 @@ void FftDisplayPlot::setPeakCount(uint chIdx, uint count)
 	for (uint i = 0; i < count; i++) {
 		auto data_marker_sp = std::make_shared<struct marker_data>();
 		data_marker_sp->type = 1; // Peak marker
+		data_marker_sp->x = 0;
+		data_marker_sp->y = 0;
+		data_marker_sp->bin = 0;
+		data_marker_sp->active = false;
 		data_marker_sp->update_ui = true;
 		d_peaks[chIdx].push_back(data_marker_sp);
 		d_freq_asc_sorted_peaks[chIdx].push_back(data_marker_sp);
@@ -1427,6 +2043,8 @@ void FftDisplayPlot::setMarkerAtFreq(uint chIdx, uint mkIdx, double freq)
 		return;
 	}
 
+	convertLazyBins();
+
 	unsigned int index = -1;
 	double *ydata = nullptr, *xdata = nullptr;
 	if (chIdx < d_nplots) {
@@ -1471,62 +2089,62 @@ void FftDisplayPlot::marker_to_max_peak(uint chIdx, uint mkIdx)
 
 void FftDisplayPlot::marker_to_next_higher_freq_peak(uint chIdx, uint mkIdx)
 {
-	auto peaks = d_freq_asc_sorted_peaks[chIdx];
+	const auto &peaks = d_freq_asc_sorted_peaks[chIdx];
 	double freq = d_markers[chIdx][mkIdx].ui->value().x();
-	int pos = -1;
 
 	// find the first peak with the freq higher that marker freq pos
-	for (int i = 0; i < peaks.size(); i++) {
-		if (peaks[i]->x > freq) {
-			pos = i;
-			break;
-		}
-	}
+	auto first = std::partition_point(peaks.begin(), peaks.end(),
+		[](const std::shared_ptr<struct marker_data> &m) {
+			return !m->active;
+		});
+	auto it = std::upper_bound(first, peaks.end(), freq,
+		[](double f, const std::shared_ptr<struct marker_data> &m) {
+			return f < m->x;
+		});
 
-	if (pos < 0)
+	if (it == peaks.end())
 		return;
 
-	marker_set_pos_source(chIdx, mkIdx, peaks[pos]);
+	marker_set_pos_source(chIdx, mkIdx, *it);
 }
 
 void FftDisplayPlot::marker_to_next_lower_freq_peak(uint chIdx, uint mkIdx)
 {
-	auto peaks = d_freq_asc_sorted_peaks[chIdx];
+	const auto &peaks = d_freq_asc_sorted_peaks[chIdx];
 	double freq = d_markers[chIdx][mkIdx].ui->value().x();
-	int pos = -1;
 
-	// find the first peak with the freq lower that marker freq pos
-	for (int i = peaks.size() - 1; i >= 0; i--) {
-		if (peaks[i]->x < freq) {
-			pos = i;
-			break;
-		}
-	}
+	// find the last peak with the freq lower that marker freq pos
+	auto first = std::partition_point(peaks.begin(), peaks.end(),
+		[](const std::shared_ptr<struct marker_data> &m) {
+			return !m->active;
+		});
+	auto it = std::lower_bound(first, peaks.end(), freq,
+		[](const std::shared_ptr<struct marker_data> &m, double f) {
+			return m->x < f;
+		});
 
-	if (pos < 0)
+	if (it == first)
 		return;
 
-	marker_set_pos_source(chIdx, mkIdx, peaks[pos]);
+	marker_set_pos_source(chIdx, mkIdx, *(it - 1));
 }
 
 void FftDisplayPlot::marker_to_next_higher_mag_peak(uint chIdx, uint mkIdx)
 {
-	auto peaks = d_peaks[chIdx];
+	const auto &peaks = d_peaks[chIdx];
 	double mag = d_markers[chIdx][mkIdx].ui->value().y();
-	int pos = -1;
 
-	// find the first peak with the magnitude higher than the current marker
-	for (int i = peaks.size() - 1; i >= 0; i--) {
-		if (peaks[i]->y > mag) {
-			pos = i;
-			break;
-		}
-	}
+	// The peaks are sorted by descending magnitude; find the last
+	// one with the magnitude higher than the current marker
+	auto it = std::partition_point(peaks.begin(), peaks.end(),
+		[mag](const std::shared_ptr<struct marker_data> &m) {
+			return m->active && m->y > mag;
+		});
 
-	if (pos < 0)
+	if (it == peaks.begin())
 		return;
 
-	marker_set_pos_source(chIdx, mkIdx, peaks[pos]);
+	marker_set_pos_source(chIdx, mkIdx, *(it - 1));
 }
 
 void FftDisplayPlot::setStartStop(double start, double stop)
@@ -1536,31 +2154,32 @@ void FftDisplayPlot::setStartStop(double start, double stop)
 	auto div = axisScaleDiv(QwtAxis::XBottom);
 	setXaxisNumDiv((div.ticks(2)).size() - 1);
 	setXaxisMajorTicksPos(div.ticks(2));
+
+	completeSpectrum();
 }
 
 void FftDisplayPlot::setVisiblePeakSearch(bool enabled)
 {
 	m_visiblePeakSearch = enabled;
+
+	completeSpectrum();
 }
 
 void FftDisplayPlot::marker_to_next_lower_mag_peak(uint chIdx, uint mkIdx)
 {
-	auto peaks = d_peaks[chIdx];
+	const auto &peaks = d_peaks[chIdx];
 	double mag = d_markers[chIdx][mkIdx].ui->value().y();
-	int pos = -1;
 
 	// find the first peak with the magnitude lower than the current marker
-	for (int i = 0; i < peaks.size(); i++) {
-		if (peaks[i]->y < mag) {
-			pos = i;
-			break;
-		}
-	}
+	auto it = std::partition_point(peaks.begin(), peaks.end(),
+		[mag](const std::shared_ptr<struct marker_data> &m) {
+			return m->active && m->y >= mag;
+		});
 
-	if (pos < 0)
+	if (it == peaks.end() || !(*it)->active)
 		return;
 
-	marker_set_pos_source(chIdx, mkIdx, peaks[pos]);
+	marker_set_pos_source(chIdx, mkIdx, *it);
 }
 
 int FftDisplayPlot::getMarkerPos(const QList<marker>& marker_list,
@@ -1621,6 +2240,8 @@ void FftDisplayPlot::onMrkCtrlMarkerPosChanged(std::shared_ptr<SpectrumMarker> &
 		bin = d_numPoints - 1;
 	}
 
+	convertLazyBins();
+
 	auto marker_data = std::make_shared<struct marker_data>();
 
 	unsigned int index = -1;
@@ -1710,6 +2331,8 @@ double FftDisplayPlot::channelScaleFactor(int chIdx) const
 
 void FftDisplayPlot::setScaleFactor(int chIdx, double scale)
 {
+	std::lock_guard<std::mutex> lock(d_processMutex);
+
 	y_scale_factor[chIdx] = scale;
 }
 
@@ -1720,6 +2343,8 @@ FftDisplayPlot::MagnitudeType FftDisplayPlot::magnitudeType() const
 
 void FftDisplayPlot::setMagnitudeType(enum MagnitudeType type)
 {
+	std::lock_guard<std::mutex> lock(d_processMutex);
+
 	d_presetMagType = type;
 	d_buffer_idx = 0;
 	d_ps_avg.clear();
@@ -1727,6 +2352,8 @@ void FftDisplayPlot::setMagnitudeType(enum MagnitudeType type)
 
 void FftDisplayPlot::setNbOverlappingAverages(unsigned int nb_avg)
 {
+	std::lock_guard<std::mutex> lock(d_processMutex);
+
 	d_buffer_idx = 0;
 	d_ps_avg.clear();
 	d_nb_overlapping_avg = nb_avg;
@@ -1744,11 +2371,21 @@ void FftDisplayPlot::recalculateMagnitudes()
 	}
 
 	if (d_presetMagType != d_magType) {
-		d_magType = d_presetMagType;
+		{
+			std::lock_guard<std::mutex> lock(d_processMutex);
+			d_magType = d_presetMagType;
+		}
 		resetAverageHistory();
 	}
 
-	averageDataAndComputeMagnitude(y_original_data, y_data, d_numPoints);
+	{
+		std::vector<LazyBins> lazy;
+		std::lock_guard<std::mutex> lock(d_processMutex);
+		averageDataAndComputeMagnitude(y_original_data, y_data,
+					       d_numPoints, 0, d_numPoints,
+					       lazy);
+	}
+	d_lazyBins.clear();
 	detectMarkers();
 
 	Q_EMIT newData();
@@ -27,7 +27,15 @@
 #include "plot_line_handle.h"
 #include "handles_area.hpp"
 #include "gui/cursor_readouts.h"
+#include "band_power.hpp"
+#include "peak_finder.hpp"
+#include "waterfall_raster.hpp"
+#include "fast_log.hpp"
 #include <boost/shared_ptr.hpp>
+#include <QFutureWatcher>
+#include <QThreadPool>
+#include <memory>
+#include <mutex>
 
 namespace adiscope {
 	class SpectrumAverage;
@@ -101,6 +109,21 @@ namespace adiscope {
 		double d_sampl_rate;
 		double d_preset_sampl_rate;
 
+		/* Zoomed data holds the two sided band around the center */
+		bool d_zoomed;
+		bool d_preset_zoomed;
+		double d_center_frequency;
+		double d_preset_center_frequency;
+
+		/* A stitched sweep spans its own band, made of the bins of
+		 * transforms of d_sweep_points */
+		uint64_t d_sweep_points;
+		uint64_t d_preset_sweep_points;
+		double d_sweep_start;
+		double d_preset_sweep_start;
+		double d_sweep_stop;
+		double d_preset_sweep_stop;
+
 		bool d_firstInit;
 
 		double m_sweepStart;
@@ -124,6 +147,7 @@ namespace adiscope {
 
 		QList<QList<std::shared_ptr<struct marker_data>>> d_peaks;
 		QList<QList<std::shared_ptr<struct marker_data>>> d_freq_asc_sorted_peaks;
+		PeakFinder d_peakFinder;
 		bool d_emitNewMkrData;
 
 		QList<QColor> d_markerColors;
@@ -139,6 +163,57 @@ namespace adiscope {
 		unsigned int d_nb_overlapping_avg;
 		std::vector<std::vector<double>> d_ps_avg;
 
+		/*
+		 * Averaging and magnitude conversion run on d_pool. The state
+		 * they use is guarded by d_processMutex.
+		 */
+		struct SpectrumJob;
+		QThreadPool d_pool;
+		QFutureWatcher<void> d_watcher;
+		std::shared_ptr<SpectrumJob> d_runningJob;
+		std::shared_ptr<SpectrumJob> d_pendingJob;
+		std::shared_ptr<SpectrumJob> d_spareJob;
+		std::mutex d_processMutex;
+		uint64_t d_processPoints;
+		uint64_t d_processSweepPoints;
+		std::vector<float> d_logScratch;
+		FastLog d_fastLog;
+
+		std::vector<BandPower> d_band_power;
+		void updateBandPower(const std::vector<double *> &in_data,
+				     uint64_t nb_points, double start,
+				     double stop);
+
+		std::shared_ptr<WaterfallRaster> d_waterfall;
+		unsigned int d_waterfall_channel;
+		void updateWaterfallAxes();
+
+		/*
+		 * The worker only converts the bins that can be seen or read
+		 * by a marker; the others are converted when something needs
+		 * the whole trace. Per channel, the bins left over are either
+		 * still to be converted from y_original_data or are averaged
+		 * values waiting in y_data.
+		 */
+		enum LazyBins {
+			CONVERTED,
+			FROM_INPUT,
+			IN_PLACE,
+		};
+		std::vector<LazyBins> d_lazyBins;
+		size_t d_lazyFrom;
+		size_t d_lazyTo;
+		MagnitudeType d_lazyMagType;
+		double d_lazyNorm;
+		std::vector<double> d_lazyScale;
+		void convertedRange(uint64_t nbPoints, double start, double stop,
+				    size_t &from, size_t &to) const;
+		bool convertLazyBins();
+		void convertMagnitude(MagnitudeType type, double scale,
+				      double norm, const double *src, double *dst,
+				      size_t from, size_t to);
+		static double logAccuracyToError(double dB);
+
 		void setupReadouts();
 		void updateHandleAreaPadding();
 
@@ -146,10 +221,21 @@ namespace adiscope {
 				uint64_t num_points);
 		void _resetXAxisPoints();
 
+		void submitSpectrum(const std::vector<double *> &pts,
+				    uint64_t nbPoints);
+		std::shared_ptr<SpectrumJob> takeJob();
+		void startJob(const std::shared_ptr<SpectrumJob> &job);
+
 		void resetAverages();
-		void averageDataAndComputeMagnitude(std::vector<double *>
+		/*
+		 * Returns false while overlapped averages are being gathered.
+		 * Only the bins in [from, to) are sure to be converted, lazy
+		 * tells what happened to the others of each channel.
+		 */
+		bool averageDataAndComputeMagnitude(std::vector<double *>
 			in_data, std::vector<double *> out_data,
-			uint64_t nb_points);
+			uint64_t nb_points, size_t from, size_t to,
+			std::vector<LazyBins> &lazy);
 		average_sptr getNewAvgObject(enum AverageType avg_type,
 			uint data_width, uint history, bool history_en);
 
@@ -157,6 +243,9 @@ namespace adiscope {
 		void remove_marker(int chn, int which);
 		void marker_set_pos_source(uint chIdx, uint mkIdx,
 			std::shared_ptr<struct marker_data> &source_sptr);
+		bool peakSearchRange(int chn, const double *&x, const double *&y,
+				     size_t &size, size_t &start,
+				     size_t &stop) const;
 		void findPeaks(int chn);
 		void calculate_fixed_markers(int chn);
 		int getMarkerPos(const QList<marker>& marker_list,
@@ -167,6 +256,7 @@ namespace adiscope {
 		QColor getChannelColor();
 
 	private Q_SLOTS:
+		void onSpectrumProcessed();
 		void onMrkCtrlMarkerSelected(std::shared_ptr<SpectrumMarker> &);
 		void onMrkCtrlMarkerPosChanged(std::shared_ptr<SpectrumMarker> &);
 		void onMrkCtrlMarkerReleased(std::shared_ptr<SpectrumMarker> &);
@@ -215,6 +305,17 @@ namespace adiscope {
 		uint peakCount(uint chIdx) const;
 		void setPeakCount(uint chIdx, uint count);
 
+		// Peaks under the threshold or less prominent are ignored,
+		// both in plot units
+		double peakThreshold() const;
+		void setPeakThreshold(double threshold);
+		double peakProminence() const;
+		void setPeakProminence(double prominence);
+
+		// The count highest peaks of a channel in the searched range
+		std::vector<PeakFinder::Peak> topPeaks(uint chIdx,
+						       uint count) const;
+
 		uint markerCount(uint chIdx) const;
 		void setMarkerCount(uint chIdx, uint count);
 
@@ -243,6 +344,16 @@ namespace adiscope {
 		void selectMarker(uint chIdx, uint mkIdx);
 
 		void recalculateMagnitudes();
+
+		/*
+		 * Converts the bins of the last spectrum the worker skipped,
+		 * for when the whole trace is read, e.g. to export it
+		 */
+		void completeSpectrum();
+
+		/* Largest error of the dB conversion; 0 makes it exact */
+		double logAccuracy() const;
+		void setLogAccuracy(double dB);
 		void replot();
 		void setZoomerEnabled();
 		double sampleRate();
@@ -252,6 +363,19 @@ namespace adiscope {
 		void unregisterReferenceWaveform(QString name);
 
 		void setWindowCoefficientSum(unsigned int ch, float sum, float sqr_sum);
+
+		/*
+		 * Power of the last spectrum of a channel between two
+		 * frequencies, in V^2
+		 */
+		double bandPower(uint chIdx, double from, double to);
+		/* Band holding the given fraction of the channel power */
+		bool occupiedBandwidth(uint chIdx, double fraction,
+				       double &low, double &high);
+
+		/* Waterfall fed with every spectrum of a channel; nullptr stops it */
+		void setWaterfallRaster(const std::shared_ptr<WaterfallRaster> &raster,
+					unsigned int chIdx);
 		void setNbOverlappingAverages(unsigned int nb_avg);
 		void useLogScaleY(bool log_scale);
 
@@ -274,6 +398,8 @@ namespace adiscope {
 		void setSampleRate(double sr, double units,
 			const std::string &strunits);
 		void presetSampleRate(double sr);
+		void presetZoom(bool enabled, double center);
+		void presetSweep(uint64_t fftSize, double start, double stop);
 		void useLogFreq(bool use_log_freq);
 		void customEvent(QEvent *e);
 		void showEvent(QShowEvent *event);
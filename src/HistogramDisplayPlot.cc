@@ -221,7 +221,6 @@ HistogramDisplayPlot::HistogramDisplayPlot(int nplots, QWidget* parent)
   : DisplayPlot(nplots, parent)
 {
   d_bins = 100;
-  d_accum = false;
   d_height = 0;
   stop = false;
   d_orientation = Qt::Horizontal;
@@ -518,8 +517,7 @@ HistogramDisplayPlot::plotNewData(const std::vector<double*> dataPoints,
 
       int index;
       for(int n = 0; n < d_nplots; n++) {
-        if(!d_accum)
-	  memset(d_ydata[n], 0, d_bins*sizeof(double));
+        memset(d_ydata[n], 0, d_bins*sizeof(double));
 	for(int64_t point = d_minPos; point < d_maxPos; point++) {
           index = boost::math::iround(1e-20 + (dataPoints[n][point] - d_left)/d_width);
           if((index >= 0) && (index < d_bins))
@@ -528,26 +526,57 @@ HistogramDisplayPlot::plotNewData(const std::vector<double*> dataPoints,
 	d_histograms[n]->setValues(d_xdata, d_ydata[n], d_bins);
       }
 
-      double height = 0;
-      double histogramHeights[d_nplots];
-      for(int n = 0; n < d_nplots; n++) {
+      _updateHeights(numDataPoints);
+    }
+  }
+}
+
+void
+HistogramDisplayPlot::plotNewCounts(const std::vector<const double*> &counts,
+				    int bins, double left, double binWidth,
+				    const int64_t numDataPoints)
+{
+  if(d_stop || bins != d_bins || (int)counts.size() < d_nplots) {
+    return;
+  }
+
+  _updateXScales(numDataPoints);
+
+  if(left != d_left || binWidth != d_width) {
+    _setXAxisPoints(left, left + binWidth * bins);
+  }
+
+  for(int n = 0; n < d_nplots; n++) {
+    memcpy(d_ydata[n], counts[n], d_bins*sizeof(double));
+    d_histograms[n]->setValues(d_xdata, d_ydata[n], d_bins);
+  }
+
+  _updateHeights(numDataPoints);
+}
+
+void
+HistogramDisplayPlot::_updateHeights(const int64_t numDataPoints)
+{
+  double height = 0;
+  double histogramHeights[d_nplots];
+  for(int n = 0; n < d_nplots; n++) {
 		histogramHeights[n] = *std::max_element(d_ydata[n], d_ydata[n]+d_bins);
-      }
-      for (int n = 0; n < d_nplots - 1; n++) {
+  }
+  for (int n = 0; n < d_nplots - 1; n++) {
 	      if (histogramHeights[n] != 0) {
 		  height = histogramHeights[n];
 		  break;
 	      }
-      }
-      for (int n = 0; n < d_nplots; n++) {
+  }
+  for (int n = 0; n < d_nplots; n++) {
 	      if (d_histograms[n]->plot()) {
 		  height = std::min(height, histogramHeights[n]);
 	      }
-      }
+  }
 
-      d_height = height;
+  d_height = height;
 
-      if (d_orientation == Qt::Vertical) {
+  if (d_orientation == Qt::Vertical) {
 	      for (size_t i = 0; i < d_histograms.size(); ++i) {
 		      double h = histogramHeights[i] + (0.2 * histogramHeights[i]);
 		      if (h > numDataPoints) {
@@ -559,18 +588,15 @@ HistogramDisplayPlot::plotNewData(const std::vector<double*> dataPoints,
 			setAxisScale(QwtAxisId(QwtAxis::YLeft, i), 0, h);
 		      }
 	      }
-      }
+  }
 
-      if(d_autoscale_state) {
+  if(d_autoscale_state) {
 	_autoScaleY(0, height);
-      }
-
-	setXaxisSpan(-d_height, 0);
+  }
 
-	replot();
+  setXaxisSpan(-d_height, 0);
 
-    }
-  }
+  replot();
 }
 
 void
@@ -585,11 +611,32 @@ HistogramDisplayPlot::newData(const QEvent* updateEvent)
 		 0);
 }
 
+void
+HistogramDisplayPlot::newFrame(const QEvent* updateEvent)
+{
+  FrameReadyEvent *fevent = (FrameReadyEvent*)updateEvent;
+  const adiscope::FrameExchange::Slot *slot = fevent->exchange()->take();
+
+  if(!slot) {
+    return;
+  }
+
+  // The sink already did the binning, the frame holds the counts
+  std::vector<const double*> counts(slot->frame->numChannels());
+  for(size_t i = 0; i < counts.size(); i++) {
+    counts[i] = slot->frame->channel(i) + slot->offset;
+  }
+
+  plotNewCounts(counts, slot->size, slot->x0, slot->dx, slot->samples);
+}
+
 void
 HistogramDisplayPlot::customEvent(QEvent * e)
 {
   if(e->type() == HistogramUpdateEvent::Type()) {
     newData(e);
+  } else if(e->type() == FrameReadyEvent::Type()) {
+    newFrame(e);
   }
 }
 
@@ -617,8 +664,14 @@ HistogramDisplayPlot::_resetXAxisPoints(double left, double right)
 		d_right = right*(1 + copysign(0.1, right));
 	}
 
-	// when both left & right are 0
+	_setXAxisPoints(d_left, d_right);
+}
 
+void
+HistogramDisplayPlot::_setXAxisPoints(double left, double right)
+{
+  d_left = left;
+  d_right = right;
   d_width = (d_right - d_left)/(d_bins);
   for(long loc = 0; loc < d_bins; loc++){
     d_xdata[loc] = d_left + loc*d_width;
@@ -796,12 +849,6 @@ HistogramDisplayPlot::setSemilogy(bool en)
   }
 }
 
-void
-HistogramDisplayPlot::setAccumulate(bool state)
-{
-  d_accum = state;
-}
-
 void
 HistogramDisplayPlot::setMarkerAlpha(int which, int alpha)
 {
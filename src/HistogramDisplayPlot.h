@@ -94,6 +94,12 @@ public:
   void plotNewData(const std::vector<double*> dataPoints,
 		   const int64_t numDataPoints, const double timeInterval);
 
+  // Shows bin counts computed elsewhere; bin k is centered on
+  // left + k * binWidth
+  void plotNewCounts(const std::vector<const double*> &counts,
+		     int bins, double left, double binWidth,
+		     const int64_t numDataPoints);
+
   void replot();
 
   void setXaxisSpan(double start, double stop);
@@ -107,7 +113,6 @@ public Q_SLOTS:
   void setAutoScaleX();
   void setSemilogx(bool en);
   void setSemilogy(bool en);
-  void setAccumulate(bool en);
 
   void setMarkerAlpha(int which, int alpha);
   int getMarkerAlpha(int which) const;
@@ -124,10 +129,13 @@ public Q_SLOTS:
 
 private Q_SLOTS:
   void newData(const QEvent*);
+  void newFrame(const QEvent*);
 
   void _onZoom(const QRectF &rect);
 private:
   void _resetXAxisPoints(double left, double right);
+  void _setXAxisPoints(double left, double right);
+  void _updateHeights(const int64_t numDataPoints);
   void _autoScaleY(double bottom, double top);
   void _updateXScales(unsigned int totalSamples);
   void _orientationChanged();
@@ -142,7 +150,6 @@ private:
   std::vector<double*> d_ydata;
 
   int d_bins;
-  bool d_accum;
   double d_xmin, d_xmax, d_left, d_right;
   double d_width;
   int d_minPos, d_maxPos;
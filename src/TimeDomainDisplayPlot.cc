@@ -44,6 +44,8 @@
 
 #include <qwt_scale_draw.h>
 #include <qwt_legend.h>
+#include <qwt_color_map.h>
+#include <qwt_matrix_raster_data.h>
 #include <QColor>
 #include <cmath>
 #include <iostream>
@@ -54,6 +56,8 @@
 #include "osc_scale_engine.h"
 
 #include "smoothcurvefitter.h"
+#include "minmax_plot_curve.hpp"
+#include "segment_overlay_item.hpp"
 
 using namespace adiscope;
 
@@ -185,6 +189,8 @@ TimeDomainDisplayPlot::TimeDomainDisplayPlot(QWidget* parent, bool isdBgraph, un
   d_nbPtsXAxis = 0;
 
   d_nb_ref_curves = 0;
+  d_segment_overlay_visible = false;
+  d_persistence_visible = false;
 
   d_autoscale_state = false;
 
@@ -282,7 +288,8 @@ TimeDomainDisplayPlot::plotNewData(const std::string &sender,
 				   const std::vector<double*> &dataPoints,
 				   const int64_t numDataPoints,
 				   const double timeInterval,
-				   const std::vector< std::vector<gr::tag_t> > &tags)
+				   const std::vector< std::vector<gr::tag_t> > &tags,
+				   uint64_t generation)
 {
   int sinkIndex = d_sinkManager.indexOfSink(sender);
 
@@ -293,6 +300,7 @@ TimeDomainDisplayPlot::plotNewData(const std::string &sender,
       unsigned int sinkNumChannels = sink->numChannels();
       unsigned long long sinkNumPoints = sink->channelsDataLength();
       bool reset_x_axis_points = d_sink_reset_x_axis_pts[sinkIndex];
+      int ref_offset = countReferenceWaveform(start);
 
       if(numDataPoints != sinkNumPoints){
 	sinkNumPoints = numDataPoints;
@@ -301,7 +309,6 @@ TimeDomainDisplayPlot::plotNewData(const std::string &sender,
 	delete[] d_xdata[sinkIndex];
 	d_xdata[sinkIndex] = new double[numDataPoints];
 
-	int ref_offset = countReferenceWaveform(start);
 	for(int i = start; i < start + sinkNumChannels; i++) {
 	  delete[] d_ydata[i];
 	  d_ydata[i] = new double[numDataPoints];
@@ -315,6 +322,8 @@ TimeDomainDisplayPlot::plotNewData(const std::string &sender,
 	  reset_x_axis_points = false;
       }
 
+      // This is the one copy a frame still goes through: the curves,
+      // measurements, cursors and export all keep pointers into d_ydata.
       for(int i = 0; i < sinkNumChannels; i++) {
 	if(d_semilogy) {
 	  for(int n = 0; n < numDataPoints; n++)
@@ -323,6 +332,20 @@ TimeDomainDisplayPlot::plotNewData(const std::string &sender,
 	else {
 	  memcpy(d_ydata[start + i], dataPoints[i], numDataPoints*sizeof(double));
 	}
+
+	MinMaxPlotCurve *curve = dynamic_cast<MinMaxPlotCurve *>(
+		d_plot_curve[start + i + ref_offset]);
+	if (curve) {
+	  curve->updateMinMax(d_ydata[start + i], numDataPoints, generation);
+	}
+      }
+
+      if (sender == d_segments_sink) {
+	updateSegmentOverlayTimeBase();
+      }
+
+      if (sender == d_persistence_sink) {
+	updatePersistence();
       }
 
       for (size_t i = 0; i < d_plot_curve.size(); i++)
@@ -506,13 +529,43 @@ void TimeDomainDisplayPlot::newData(const QEvent* updateEvent)
 			dataPoints,
 			numDataPoints,
 			0,
-			tags);
+			tags,
+			tevent->getGeneration());
+}
+
+void TimeDomainDisplayPlot::newFrame(const QEvent* updateEvent)
+{
+	FrameReadyEvent *fevent = (FrameReadyEvent*)updateEvent;
+	const adiscope::FrameExchange::Slot *slot = fevent->exchange()->take();
+
+	if (!slot) {
+		return;
+	}
+
+	const std::string sender = fevent->senderName();
+	std::vector<double*> dataPoints(slot->frame->numChannels());
+	for (size_t i = 0; i < dataPoints.size(); i++) {
+		dataPoints[i] = slot->frame->channel(i) + slot->offset;
+	}
+
+	if ((d_nbPtsXAxis != 0) && (d_nbPtsXAxis <= slot->size)
+			&& sender == "Osc Time") {
+		Q_EMIT filledScreen(true, slot->size);
+	}
+
+	this->plotNewData(sender,
+			dataPoints,
+			slot->size,
+			0,
+			std::vector< std::vector<gr::tag_t> >());
 }
 
 void TimeDomainDisplayPlot::customEvent(QEvent * e)
 {
   if(e->type() == TimeUpdateEvent::Type()) {
     newData(e);
+  } else if(e->type() == FrameReadyEvent::Type()) {
+    newFrame(e);
   }
 }
 
@@ -1287,7 +1340,7 @@ bool TimeDomainDisplayPlot::registerSink(std::string sinkUniqueNme, unsigned int
 
 			QColor color = getChannelColor();
 
-			QwtPlotCurve *curve = new QwtPlotCurve(QString("Data %1").arg(n));
+			QwtPlotCurve *curve = new MinMaxPlotCurve(QString("Data %1").arg(n));
 			curve->setPen(QPen(color));
 			curve->setRenderHint(QwtPlotItem::RenderAntialiased);
 			d_plot_curve.push_back(curve);
@@ -1330,6 +1383,209 @@ bool TimeDomainDisplayPlot::unregisterMathWaveform(const std::string &sinkName)
 	return ret;
 }
 
+void TimeDomainDisplayPlot::setSegmentBuffer(const std::string &sinkName,
+		const std::shared_ptr<SegmentBuffer> &segments)
+{
+	for (SegmentOverlayItem *item : qAsConst(d_segment_overlays)) {
+		item->detach();
+		delete item;
+	}
+	d_segment_overlays.clear();
+
+	d_segments = segments;
+	d_segments_sink = segments ? sinkName : "";
+
+	int sinkIndex = d_sinkManager.indexOfSink(sinkName);
+	if (!segments || sinkIndex < 0) {
+		replot();
+		return;
+	}
+
+	int start = d_sinkManager.sinkFirstChannelPos(sinkName);
+	int ref_offset = countReferenceWaveform(start);
+	unsigned int numChannels = d_sinkManager.sink(sinkIndex)->numChannels();
+
+	for (unsigned int i = 0; i < numChannels; i++) {
+		QwtPlotCurve *curve = d_plot_curve[start + i + ref_offset];
+		SegmentOverlayItem *item = new SegmentOverlayItem(segments, i);
+
+		// Fade the segments so that the current capture stands out
+		QPen pen = curve->pen();
+		QColor color = pen.color();
+		color.setAlpha(60);
+		pen.setColor(color);
+		pen.setWidthF(1);
+
+		item->setPen(pen);
+		item->setAxes(curve->xAxis(), curve->yAxis());
+		item->setVisible(d_segment_overlay_visible);
+		item->attach(this);
+		d_segment_overlays.push_back(item);
+	}
+
+	updateSegmentOverlayTimeBase();
+	replot();
+}
+
+void TimeDomainDisplayPlot::updateSegmentOverlayTimeBase()
+{
+	for (SegmentOverlayItem *item : qAsConst(d_segment_overlays)) {
+		item->setTimeBase(d_data_starting_point / d_sample_rate,
+				  1.0 / d_sample_rate);
+	}
+}
+
+void TimeDomainDisplayPlot::setSegmentOverlayVisible(bool visible)
+{
+	d_segment_overlay_visible = visible;
+
+	for (SegmentOverlayItem *item : qAsConst(d_segment_overlays)) {
+		item->setVisible(visible);
+	}
+
+	replot();
+}
+
+bool TimeDomainDisplayPlot::segmentOverlayVisible() const
+{
+	return d_segment_overlay_visible;
+}
+
+bool TimeDomainDisplayPlot::showSegment(unsigned int index)
+{
+	int sinkIndex = d_sinkManager.indexOfSink(d_segments_sink);
+	if (!d_segments || sinkIndex < 0 || index >= d_segments->count()) {
+		return false;
+	}
+
+	const unsigned int numChannels = d_segments->numChannels();
+	if (numChannels != d_sinkManager.sink(sinkIndex)->numChannels()) {
+		return false;
+	}
+
+	const size_t size = d_segments->segmentSize();
+	std::vector<std::vector<double>> data(numChannels,
+					      std::vector<double>(size));
+	std::vector<double *> channels;
+
+	for (unsigned int i = 0; i < numChannels; i++) {
+		if (!d_segments->copySegment(index, i, data[i].data())) {
+			return false;
+		}
+		channels.push_back(data[i].data());
+	}
+
+	// Segments are usually browsed once the acquisition was stopped
+	bool stopped = d_stop;
+	d_stop = false;
+	plotNewData(d_segments_sink, channels, size, 0);
+	d_stop = stopped;
+
+	return true;
+}
+
+void TimeDomainDisplayPlot::setPersistenceRaster(const std::string &sinkName,
+		const std::shared_ptr<PersistenceRaster> &raster)
+{
+	for (QwtPlotSpectrogram *item : qAsConst(d_persistence_items)) {
+		item->detach();
+		delete item;
+	}
+	d_persistence_items.clear();
+
+	d_persistence = raster;
+	d_persistence_sink = raster ? sinkName : "";
+
+	int sinkIndex = d_sinkManager.indexOfSink(sinkName);
+	if (!raster || sinkIndex < 0) {
+		replot();
+		return;
+	}
+
+	int start = d_sinkManager.sinkFirstChannelPos(sinkName);
+	int ref_offset = countReferenceWaveform(start);
+	unsigned int numChannels = d_sinkManager.sink(sinkIndex)->numChannels();
+
+	for (unsigned int i = 0; i < numChannels; i++) {
+		QwtPlotCurve *curve = d_plot_curve[start + i + ref_offset];
+		QColor color = curve->pen().color();
+		QColor none = color;
+		none.setAlpha(0);
+
+		// Rarely hit cells fade into the background, the most hit
+		// ones are drawn in the channel colour turning into white
+		QwtLinearColorMap *colorMap = new QwtLinearColorMap(none,
+								    Qt::white);
+		colorMap->addColorStop(0.6, color);
+
+		QwtPlotSpectrogram *item = new QwtPlotSpectrogram();
+		item->setColorMap(colorMap);
+		item->setDisplayMode(QwtPlotSpectrogram::ImageMode, true);
+		item->setItemAttribute(QwtPlotItem::AutoScale, false);
+		item->setItemAttribute(QwtPlotItem::Legend, false);
+		item->setAxes(curve->xAxis(), curve->yAxis());
+		item->setZ(curve->z() - 1);
+		item->setVisible(d_persistence_visible);
+		item->attach(this);
+		d_persistence_items.push_back(item);
+	}
+
+	updatePersistence();
+	replot();
+}
+
+void TimeDomainDisplayPlot::updatePersistence()
+{
+	if (!d_persistence || !d_persistence_visible) {
+		return;
+	}
+
+	const unsigned int width = d_persistence->width();
+	const size_t frameSize = d_persistence->frameSize();
+	const double x0 = d_data_starting_point / d_sample_rate;
+	const double x1 = x0 + frameSize / d_sample_rate;
+
+	for (int i = 0; i < d_persistence_items.size(); i++) {
+		QwtPlotSpectrogram *item = d_persistence_items[i];
+
+		// The rows follow the vertical range of the channel; a change
+		// of scale or offset starts the accumulation over
+		QwtInterval range = axisInterval(item->yAxis()).normalized();
+		if (range.minValue() != d_persistence->verticalMin(i) ||
+				range.maxValue() != d_persistence->verticalMax(i)) {
+			d_persistence->setVerticalRange(i, range.minValue(),
+							range.maxValue());
+		}
+
+		d_persistence->snapshot(i, d_persistence_snapshot);
+
+		QwtMatrixRasterData *data = new QwtMatrixRasterData();
+		data->setValueMatrix(QVector<double>::fromStdVector(
+				d_persistence_snapshot), width);
+		data->setInterval(Qt::XAxis, QwtInterval(x0, x1));
+		data->setInterval(Qt::YAxis, range);
+		data->setInterval(Qt::ZAxis, QwtInterval(0.0, 1.0));
+		item->setData(data);
+	}
+}
+
+void TimeDomainDisplayPlot::setPersistenceVisible(bool visible)
+{
+	d_persistence_visible = visible;
+
+	for (QwtPlotSpectrogram *item : qAsConst(d_persistence_items)) {
+		item->setVisible(visible);
+	}
+
+	updatePersistence();
+	replot();
+}
+
+bool TimeDomainDisplayPlot::persistenceVisible() const
+{
+	return d_persistence_visible;
+}
+
 bool TimeDomainDisplayPlot::unregisterSink(std::string sinkName)
 {
 	bool ret = false;
@@ -1337,6 +1593,14 @@ bool TimeDomainDisplayPlot::unregisterSink(std::string sinkName)
 	int sinkIndex = d_sinkManager.indexOfSink(sinkName);
 	if (sinkIndex >= 0) {
 
+		if (sinkName == d_segments_sink) {
+			setSegmentBuffer(sinkName, nullptr);
+		}
+
+		if (sinkName == d_persistence_sink) {
+			setPersistenceRaster(sinkName, nullptr);
+		}
+
 		// Remove X axis associated with the channels of the sink
 		delete[] d_xdata[sinkIndex];
 		d_xdata.erase(d_xdata.begin() + sinkIndex);
@@ -47,11 +47,17 @@
 #include <vector>
 #include <gnuradio/tags.h>
 
+#include <qwt_plot_spectrogram.h>
+
 #include "DisplayPlot.h"
 #include "spectrumUpdateEvents.h"
+#include "segment_buffer.hpp"
+#include "persistence_raster.hpp"
 
 namespace adiscope {
 
+class SegmentOverlayItem;
+
 class Sink{
 public:
 	Sink(const std::string &name, unsigned int numChannels, unsigned long long channelsDataLength):
@@ -108,7 +114,8 @@ public:
 		   const std::vector<double*> &dataPoints,
 		   const int64_t numDataPoints, const double timeInterval,
                    const std::vector< std::vector<gr::tag_t> > &tags \
-		   = std::vector< std::vector<gr::tag_t> >());
+		   = std::vector< std::vector<gr::tag_t> >(),
+		   uint64_t generation = 0);
   void replot();
 
   void stemPlot(bool en);
@@ -159,6 +166,20 @@ public:
   void enableDigitalPlotCurve(int curveId, bool enable);
   QwtPlotCurve *getDigitalPlotCurve(int curveId);
   int getNrDigitalPlotCurves() const;
+
+  /* Segmented memory filled by the given sink; nullptr removes it */
+  void setSegmentBuffer(const std::string &sinkName,
+			const std::shared_ptr<SegmentBuffer> &segments);
+  void setSegmentOverlayVisible(bool visible);
+  bool segmentOverlayVisible() const;
+  /* Plots one stored segment as if the sink had just sent it */
+  bool showSegment(unsigned int index);
+
+  /* Persistence raster filled by the given sink; nullptr removes it */
+  void setPersistenceRaster(const std::string &sinkName,
+			    const std::shared_ptr<PersistenceRaster> &raster);
+  void setPersistenceVisible(bool visible);
+  bool persistenceVisible() const;
 Q_SIGNALS:
   void channelAdded(int);
   void newData();
@@ -212,6 +233,7 @@ protected:
 
 private Q_SLOTS:
   void newData(const QEvent*);
+  void newFrame(const QEvent*);
 
 protected:
   std::vector<double*> d_ydata;
@@ -257,6 +279,19 @@ private:
 
   QColor getChannelColor();
 
+  std::shared_ptr<SegmentBuffer> d_segments;
+  std::string d_segments_sink;
+  QVector<SegmentOverlayItem *> d_segment_overlays;
+  bool d_segment_overlay_visible;
+  void updateSegmentOverlayTimeBase();
+
+  std::shared_ptr<PersistenceRaster> d_persistence;
+  std::string d_persistence_sink;
+  QVector<QwtPlotSpectrogram *> d_persistence_items;
+  bool d_persistence_visible;
+  std::vector<double> d_persistence_snapshot;
+  void updatePersistence();
+
   QMap<QString, QwtPlotCurve *> d_ref_curves;
   QMap<QString, QwtPlotCurve *> d_math_curves;
   int d_nb_ref_curves;
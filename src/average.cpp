@@ -20,6 +20,7 @@
 
 #include "average.h"
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <boost/make_shared.hpp>
 
@@ -93,15 +94,14 @@ void AverageHistoryOne::reset()
  * class AverageHistoryN
  */
 AverageHistoryN::AverageHistoryN(unsigned int data_width, unsigned int history):
-	SpectrumAverage(data_width, history, true), m_insert_index(0),
-	m_inserted_count(0)
+	SpectrumAverage(data_width, history, true),
+	m_history((size_t)m_history_size * m_data_width),
+	m_insert_index(0), m_inserted_count(0)
 {
-	alloc_history(m_data_width, m_history_size);
 }
 
 AverageHistoryN::~AverageHistoryN()
 {
-	free_history();
 }
 
 void AverageHistoryN::reset()
@@ -110,73 +110,44 @@ void AverageHistoryN::reset()
 	m_insert_index = 0;
 }
 
-void AverageHistoryN::alloc_history(unsigned int data_width,
-	unsigned int history_size)
+double *AverageHistoryN::historyRow(unsigned int index)
 {
-	boost::unique_lock<boost::mutex> lock(m_history_mutex);
-	m_history = new double*[history_size];
-	for (unsigned int i = 0; i < history_size; i++)
-		m_history[i] = new double[data_width];
-
-}
-
-void AverageHistoryN::free_history()
-{
-	boost::unique_lock<boost::mutex> lock(m_history_mutex);
-	for (unsigned int i = 0; i < m_history_size; i++)
-		delete[] m_history[i];
-	delete[] m_history;
+	return &m_history[(size_t)index * m_data_width];
 }
 
 void AverageHistoryN::setHistory(unsigned int history)
 {
-	double **tmp_history;
-	tmp_history = new double*[history];
-
-	for (unsigned int i = 0; i < history; i++) {
-		tmp_history[i] = new double[m_data_width];
+	if (history < 1)
+		history = 1;
+
+	// Keep the newest frames, oldest first, and push them again so that
+	// whatever a subclass derives from the history is rebuilt as well
+	unsigned int kept = std::min(m_inserted_count, history);
+	std::vector<double> frames((size_t)kept * m_data_width);
+
+	for (unsigned int i = 0; i < kept; i++) {
+		unsigned int row = (m_insert_index + m_history_size - kept + i)
+			% m_history_size;
+		std::memcpy(&frames[(size_t)i * m_data_width], historyRow(row),
+			    m_data_width * sizeof(double));
 	}
 
-	if (history > m_history_size) {
-		for (unsigned int i = 0; i < m_history_size; i++) {
-			std::memcpy(tmp_history[i], m_history[i],
-				    m_data_width * sizeof(double));
-		}
-	} else {
-		int start_index = (m_insert_index > history) ? (m_insert_index - history) : 0;
-		int remaining_samples = std::min(m_inserted_count, history);
-		int tmp_i = 0;
-
-		for (unsigned int i = start_index; i < m_insert_index; i++) {
-			std::memcpy(tmp_history[tmp_i], m_history[i],
-				    m_data_width * sizeof(double));
-			remaining_samples--;
-			tmp_i++;
-		}
-
-		for (unsigned int i = m_history_size - remaining_samples; i < m_history_size; i++) {
-			std::memcpy(tmp_history[tmp_i], m_history[i],
-				    m_data_width * sizeof(double));
-			tmp_i++;
-		}
-
-		if (m_insert_index > history) {
-			m_insert_index = 0;
-		}
-		m_inserted_count = std::min(m_inserted_count, history);
+	{
+		boost::unique_lock<boost::mutex> lock(m_history_mutex);
+		m_history.assign((size_t)history * m_data_width, 0.0);
+		SpectrumAverage::setHistory(history);
 	}
 
-	free_history();
+	reset();
 
-	boost::unique_lock<boost::mutex> lock(m_history_mutex);
-	m_history = tmp_history;
-	SpectrumAverage::setHistory(history);
+	for (unsigned int i = 0; i < kept; i++)
+		pushNewData(&frames[(size_t)i * m_data_width]);
 }
 
 void AverageHistoryN::pushNewData(double *data)
 {
 	boost::unique_lock<boost::mutex> lock(m_history_mutex);
-	std::memcpy(m_history[m_insert_index], data,
+	std::memcpy(historyRow(m_insert_index), data,
 		m_data_width * sizeof(double));
 	m_insert_index = (m_insert_index + 1) % m_history_size;
 	m_inserted_count = std::min(m_inserted_count + 1, m_history_size);
@@ -262,101 +233,94 @@ void ExponentialAverage::pushNewData(double *data)
 }
 
 /*
- * class PeakHold
+ * class SlidingHold
  */
-PeakHold::PeakHold(unsigned int data_width, unsigned int history):
-	AverageHistoryN(data_width, history)
+SlidingHold::SlidingHold(unsigned int data_width, unsigned int history,
+	bool keep_max): AverageHistoryN(data_width, history),
+	m_keep_max(keep_max), m_prefix(m_data_width),
+	m_suffix((size_t)m_history_size * m_data_width)
 {
 }
 
-void PeakHold::pushNewData(double *data)
+void SlidingHold::pushNewData(double *data)
 {
-	double *peaks = m_average;
-
-	if (m_inserted_count == 0 || m_history_size == 1) {
-		std::memcpy(peaks, data, m_data_width * sizeof(double));
-	} else {
-		for (unsigned int i = 0; i < m_data_width; i++) {
-			if (data[i] > peaks[i])
-				peaks[i] = data[i];
-
-			if (m_inserted_count != m_history_size)
-				continue;
-
-			// If the value that we're about to drop (overwrite) is
-			// currently the peak we need to find a new peak
-			if (m_history[m_insert_index][i] == peaks[i])
-				peaks[i] = getPeakFromHistoryColumn(i);
-		}
-	}
+	unsigned int row = m_insert_index;
 
 	// Let the base class handle the data storing
 	AverageHistoryN::pushNewData(data);
-}
-
-double PeakHold::getPeakFromHistoryColumn(unsigned int col)
-{
-	if (m_inserted_count < 2)
-		return m_history[0][col];
 
-	unsigned int start = (m_insert_index != 0) ? 0 : 1;
-	double peak = m_history[start][col];
-
-	for (unsigned int i = start + 1; i < m_inserted_count; i++) {
-		if (i != m_insert_index && m_history[i][col] > peak)
-			peak = m_history[i][col];
-	}
-
-	return peak;
+	if (m_keep_max)
+		update<true>(row);
+	else
+		update<false>(row);
 }
 
-/*
- * class MinHold
- */
-MinHold::MinHold(unsigned int data_width, unsigned int history):
-	AverageHistoryN(data_width, history)
+template <bool MAX>
+static inline double pick(double a, double b)
 {
+	return MAX ? (a > b ? a : b) : (a < b ? a : b);
 }
 
-void MinHold::pushNewData(double *data)
+template <bool MAX>
+void SlidingHold::update(unsigned int row)
 {
-	double *mins = m_average;
+	const unsigned int width = m_data_width;
+	const unsigned int size = m_history_size;
+	const double *in = historyRow(row);
+	double *prefix = m_prefix.data();
+	double *out = m_average;
+
+	m_suffix.resize((size_t)size * width);
 
-	if (m_inserted_count == 0 || m_history_size == 1) {
-		std::memcpy(mins, data, m_data_width * sizeof(double));
+	if (row == 0) {
+		std::memcpy(prefix, in, width * sizeof(double));
 	} else {
-		for (unsigned int i = 0; i < m_data_width; i++) {
-			if (data[i] < mins[i])
-				mins[i] = data[i];
+		for (unsigned int i = 0; i < width; i++)
+			prefix[i] = pick<MAX>(prefix[i], in[i]);
+	}
 
-			if (m_inserted_count != m_history_size)
-				continue;
+	if (row == size - 1) {
+		// The block is complete: its suffix extremes cover the
+		// older part of the window during the next size frames
+		double *suffix = m_suffix.data();
 
-			// If the value that we're about to drop (overwrite) is
-			// currently the min we need to find a new min
-			if (m_history[m_insert_index][i] == mins[i])
-				mins[i] = getMinFromHistoryColumn(i);
-		}
-	}
+		std::memcpy(&suffix[(size_t)row * width], in,
+			width * sizeof(double));
 
-	// Let the base class handle the data storing
-	AverageHistoryN::pushNewData(data);
-}
+		for (unsigned int r = row; r-- > 0;) {
+			const double *h = historyRow(r);
+			const double *next = &suffix[(size_t)(r + 1) * width];
+			double *cur = &suffix[(size_t)r * width];
 
-double MinHold::getMinFromHistoryColumn(unsigned int col)
-{
-	if (m_inserted_count < 2)
-		return m_history[0][col];
+			for (unsigned int i = 0; i < width; i++)
+				cur[i] = pick<MAX>(h[i], next[i]);
+		}
 
-	unsigned int start = (m_insert_index != 0) ? 0 : 1;
-	double min = m_history[start][col];
+		std::memcpy(out, prefix, width * sizeof(double));
+	} else if (m_inserted_count < size) {
+		std::memcpy(out, prefix, width * sizeof(double));
+	} else {
+		const double *tail = &m_suffix[(size_t)(row + 1) * width];
 
-	for (unsigned int i = start + 1; i < m_inserted_count; i++) {
-		if (i != m_insert_index && m_history[i][col] < min)
-			min = m_history[i][col];
+		for (unsigned int i = 0; i < width; i++)
+			out[i] = pick<MAX>(tail[i], prefix[i]);
 	}
+}
 
-	return min;
+/*
+ * class PeakHold
+ */
+PeakHold::PeakHold(unsigned int data_width, unsigned int history):
+	SlidingHold(data_width, history, true)
+{
+}
+
+/*
+ * class MinHold
+ */
+MinHold::MinHold(unsigned int data_width, unsigned int history):
+	SlidingHold(data_width, history, false)
+{
 }
 
 /*
@@ -435,32 +399,51 @@ void LinearAverageOne::pushNewData(double *data)
 
 
 /*
- * class LinearRMS
+ * Adds add[i] - sub[i] (or their squares) to sum[i] with Kahan
+ * compensation, so that the window sums don't drift after many frames
+ * went in and out. sub can be null.
  */
-LinearRMS::LinearRMS(unsigned int data_width, unsigned int history):
-	AverageHistoryN(data_width, history)
-{
-	m_sqr_sums = new double[data_width]();
+template <bool SQUARE>
+static void compensatedUpdate(double *sum, double *comp, const double *add,
+	const double *sub, unsigned int size)
+{
+	if (sub) {
+		for (unsigned int i = 0; i < size; i++) {
+			double y = (SQUARE ? add[i] * add[i] - sub[i] * sub[i] :
+				add[i] - sub[i]) - comp[i];
+			double t = sum[i] + y;
+
+			comp[i] = (t - sum[i]) - y;
+			sum[i] = t;
+		}
+	} else {
+		for (unsigned int i = 0; i < size; i++) {
+			double y = (SQUARE ? add[i] * add[i] : add[i]) - comp[i];
+			double t = sum[i] + y;
+
+			comp[i] = (t - sum[i]) - y;
+			sum[i] = t;
+		}
+	}
 }
 
-LinearRMS::~LinearRMS()
+/*
+ * class LinearRMS
+ */
+LinearRMS::LinearRMS(unsigned int data_width, unsigned int history):
+	AverageHistoryN(data_width, history),
+	m_sqr_sums(m_data_width, 0.0), m_compensation(m_data_width, 0.0)
 {
-	delete[] m_sqr_sums;
 }
 
 void LinearRMS::pushNewData(double *data)
 {
-	if (m_inserted_count != m_history_size) {
-		for (unsigned int i = 0; i < m_data_width; i++) {
-			m_sqr_sums[i] += (data[i] * data[i]);
-		}
-	} else {
-		for (unsigned int i = 0; i < m_data_width; i++) {
-			m_sqr_sums[i] -= (m_history[m_insert_index][i] *
-				m_history[m_insert_index][i]);
-			m_sqr_sums[i] += (data[i] * data[i]);
-		}
-	}
+	// Once the window is full, the frame about to be overwritten leaves it
+	const double *old = (m_inserted_count == m_history_size) ?
+		historyRow(m_insert_index) : nullptr;
+
+	compensatedUpdate<true>(m_sqr_sums.data(), m_compensation.data(),
+		data, old, m_data_width);
 
 	// Let the base class handle the data storing
 	AverageHistoryN::pushNewData(data);
@@ -471,12 +454,14 @@ void LinearRMS::getAverage(double *out_data, unsigned int num_samples) const
 	unsigned int num = std::min(m_data_width, num_samples);
 
 	for (unsigned int i = 0; i < num; i++)
-		out_data[i] = sqrt(m_sqr_sums[i] / m_inserted_count);
+		out_data[i] = sqrt(std::max(m_sqr_sums[i], 0.0) /
+			m_inserted_count);
 }
 
 void LinearRMS::reset()
 {
-	std::fill_n(m_sqr_sums, m_data_width, 0);
+	std::fill(m_sqr_sums.begin(), m_sqr_sums.end(), 0);
+	std::fill(m_compensation.begin(), m_compensation.end(), 0);
 	AverageHistoryN::reset();
 }
 
@@ -484,28 +469,19 @@ void LinearRMS::reset()
  * class LinearAverage
  */
 LinearAverage::LinearAverage(unsigned int data_width, unsigned int history):
-	AverageHistoryN(data_width, history)
+	AverageHistoryN(data_width, history),
+	m_sums(m_data_width, 0.0), m_compensation(m_data_width, 0.0)
 {
-	m_sums = new double[data_width]();
-}
-
-LinearAverage::~LinearAverage()
-{
-	delete[] m_sums;
 }
 
 void LinearAverage::pushNewData(double *data)
 {
-	if (m_inserted_count != m_history_size) {
-		for (unsigned int i = 0; i < m_data_width; i++) {
-			m_sums[i] += data[i];
-		}
-	} else {
-		for (unsigned int i = 0; i < m_data_width; i++) {
-			m_sums[i] -= m_history[m_insert_index][i];
-			m_sums[i] += data[i];
-		}
-	}
+	// Once the window is full, the frame about to be overwritten leaves it
+	const double *old = (m_inserted_count == m_history_size) ?
+		historyRow(m_insert_index) : nullptr;
+
+	compensatedUpdate<false>(m_sums.data(), m_compensation.data(),
+		data, old, m_data_width);
 
 	// Let the base class handle the data storing
 	AverageHistoryN::pushNewData(data);
@@ -521,6 +497,7 @@ void LinearAverage::getAverage(double *out_data, unsigned int num_samples) const
 
 void LinearAverage::reset()
 {
-	std::fill_n(m_sums, m_data_width, 0);
+	std::fill(m_sums.begin(), m_sums.end(), 0);
+	std::fill(m_compensation.begin(), m_compensation.end(), 0);
 	AverageHistoryN::reset();
 }
@@ -22,6 +22,7 @@
 #define AVERAGE_H
 
 #include <boost/thread/mutex.hpp>
+#include <vector>
 
 namespace adiscope {
 
@@ -56,6 +57,10 @@ protected:
 	bool m_anyDataPushed;
 };
 
+/*
+ * Keeps the last history() frames in one contiguous ring, frame i being
+ * the row that starts at historyRow(i).
+ */
 class AverageHistoryN: public SpectrumAverage
 {
 public:
@@ -65,14 +70,14 @@ public:
 	virtual void reset();
 
 protected:
-	double **m_history;
+	double *historyRow(unsigned int index);
+
+	std::vector<double> m_history;
 	unsigned int m_insert_index;
 	unsigned int m_inserted_count;
 	boost::mutex m_history_mutex;
 
 private:
-	void alloc_history(unsigned int data_width, unsigned int history_size);
-	void free_history();
 	void setHistory(unsigned int) override;
 };
 
@@ -128,52 +133,68 @@ private:
 	unsigned int m_inserted_count;
 };
 
-class PeakHold: public AverageHistoryN
+/*
+ * Max or min of every bin over the last history() frames, in O(1)
+ * amortized per bin and frame. The ring is split in blocks of history()
+ * frames (van Herk / Gil-Werman): the window is the tail of the previous
+ * block, whose suffix extremes are computed once when it completes,
+ * plus the head of the current one, tracked by a running extreme.
+ */
+class SlidingHold: public AverageHistoryN
 {
 public:
-	PeakHold(unsigned int data_width, unsigned int history);
+	SlidingHold(unsigned int data_width, unsigned int history,
+		bool keep_max);
 	virtual void pushNewData(double *data);
 
 private:
-	double getPeakFromHistoryColumn(unsigned int col);
+	template <bool MAX> void update(unsigned int row);
+
+	bool m_keep_max;
+	std::vector<double> m_prefix;
+	std::vector<double> m_suffix;
 };
 
-class MinHold: public AverageHistoryN
+class PeakHold: public SlidingHold
 {
 public:
-	MinHold(unsigned int data_width, unsigned int history);
-	virtual void pushNewData(double *data);
+	PeakHold(unsigned int data_width, unsigned int history);
+};
 
-private:
-	double getMinFromHistoryColumn(unsigned int col);
+class MinHold: public SlidingHold
+{
+public:
+	MinHold(unsigned int data_width, unsigned int history);
 };
 
 class LinearRMS: public AverageHistoryN
 {
 public:
 	LinearRMS(unsigned int data_width, unsigned int history);
-	~LinearRMS();
 	virtual void pushNewData(double *data);
 	virtual void getAverage(double *out_data,
 		unsigned int num_samples) const;
 	virtual void reset();
 
 private:
-	double *m_sqr_sums;
+	/* Kahan compensated running sums of the window */
+	std::vector<double> m_sqr_sums;
+	std::vector<double> m_compensation;
 };
 
 class LinearAverage: public AverageHistoryN
 {
 public:
 	LinearAverage(unsigned int data_width, unsigned int history);
-	~LinearAverage();
 	virtual void pushNewData(double *data);
 	virtual void getAverage(double *out_data,
 		unsigned int num_samples) const;
 	virtual void reset();
 
 private:
-	double *m_sums;
+	/* Kahan compensated running sums of the window */
+	std::vector<double> m_sums;
+	std::vector<double> m_compensation;
 };
 
 } // namespace adiscope
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "band_power.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace adiscope;
+
+BandPower::BandPower():
+	d_start(0),
+	d_binWidth(0)
+{
+}
+
+void BandPower::update(const double *power, size_t size, double start,
+		       double stop, double scale)
+{
+	if (size == 0 || !(stop > start)) {
+		clear();
+		return;
+	}
+
+	d_binWidth = (stop - start) / size;
+	d_start = start - d_binWidth / 2;
+
+	d_prefix.resize(size + 1);
+	double *prefix = d_prefix.data();
+	double sum = 0;
+
+	prefix[0] = 0;
+	for (size_t i = 0; i < size; i++) {
+		sum += power[i] * scale;
+		prefix[i + 1] = sum;
+	}
+}
+
+void BandPower::clear()
+{
+	d_prefix.clear();
+}
+
+bool BandPower::empty() const
+{
+	return d_prefix.size() < 2;
+}
+
+double BandPower::cumulative(double freq) const
+{
+	const size_t size = d_prefix.size() - 1;
+	const double pos = (freq - d_start) / d_binWidth;
+
+	if (!(pos > 0)) {
+		return 0;
+	}
+
+	if (pos >= size) {
+		return d_prefix[size];
+	}
+
+	const size_t bin = pos;
+
+	return d_prefix[bin] + (pos - bin) *
+		(d_prefix[bin + 1] - d_prefix[bin]);
+}
+
+double BandPower::power(double from, double to) const
+{
+	if (empty()) {
+		return 0;
+	}
+
+	if (to < from) {
+		std::swap(from, to);
+	}
+
+	return cumulative(to) - cumulative(from);
+}
+
+double BandPower::totalPower() const
+{
+	return empty() ? 0 : d_prefix.back();
+}
+
+/* Inverse of cumulative(), by a binary search of the prefix sums */
+double BandPower::frequencyAt(double value) const
+{
+	auto it = std::lower_bound(d_prefix.begin() + 1, d_prefix.end(),
+				   value);
+
+	if (it == d_prefix.end()) {
+		--it;
+	}
+
+	const size_t bin = it - d_prefix.begin() - 1;
+	const double binPower = d_prefix[bin + 1] - d_prefix[bin];
+	const double part = binPower > 0 ?
+		(value - d_prefix[bin]) / binPower : 0;
+
+	return d_start + (bin + std::min(std::max(part, 0.0), 1.0)) *
+		d_binWidth;
+}
+
+bool BandPower::occupiedBandwidth(double fraction, double &low,
+				  double &high) const
+{
+	const double total = totalPower();
+
+	if (!(total > 0) || !(fraction > 0) || fraction > 1) {
+		return false;
+	}
+
+	low = frequencyAt(total * (1 - fraction) / 2);
+	high = frequencyAt(total * (1 + fraction) / 2);
+
+	return true;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BAND_POWER_HPP
+#define BAND_POWER_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace adiscope {
+
+/*
+ * Integrated power over arbitrary frequency bands of a spectrum. Each
+ * spectrum is turned into a prefix sum of its bins once; the power of a
+ * band is then the difference of two interpolated prefix values, so any
+ * number of bands (channel power, adjacent channels, occupied bandwidth)
+ * cost O(1) each, or O(log n) for the occupied bandwidth.
+ *
+ * Bin i is centred on start + i * (stop - start) / size and its power
+ * is spread evenly over the bin.
+ */
+class BandPower
+{
+public:
+	BandPower();
+
+	/* Linear power of size bins spanning [start, stop), times scale */
+	void update(const double *power, size_t size, double start,
+		    double stop, double scale);
+	void clear();
+	bool empty() const;
+
+	/* Power between two frequencies */
+	double power(double from, double to) const;
+	double totalPower() const;
+
+	/*
+	 * Band holding the given fraction of the total power, with half of
+	 * the rest below and half above it. Returns false without a
+	 * spectrum or power.
+	 */
+	bool occupiedBandwidth(double fraction, double &low,
+			       double &high) const;
+
+private:
+	double cumulative(double freq) const;
+	double frequencyAt(double cumulative) const;
+
+	std::vector<double> d_prefix;
+	double d_start;
+	double d_binWidth;
+};
+
+} /* namespace adiscope */
+
+#endif /* BAND_POWER_HPP */
@@ -0,0 +1,335 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "down_converter.hpp"
+
+#include <volk/volk.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace adiscope;
+
+/* Attenuation of everything that would alias into the kept band */
+static const double ATTENUATION_DB = 90.0;
+
+/* Half width of the kept band, relative to the output rate */
+static const double PASSBAND = 0.4;
+
+static const unsigned int MAX_STAGE_DECIMATION = 8;
+
+/* Modified Bessel function of the first kind, order 0 */
+static double bessel_i0(double x)
+{
+	double sum = 1.0;
+	double term = 1.0;
+
+	for (int k = 1; k < 50; k++) {
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+
+		if (term < sum * 1e-12) {
+			break;
+		}
+	}
+
+	return sum;
+}
+
+DownConverter::DownConverter():
+	d_center(0.0),
+	d_decimation(0),
+	d_phase(0.0),
+	d_phaseStep(0.0)
+{
+	configure(0.0, 1);
+}
+
+/*
+ * Kaiser windowed low pass for one stage. The passband is relative to
+ * the stage input rate; the stopband starts where the first alias of
+ * the passband edge lands after decimation.
+ */
+std::vector<float> DownConverter::lowPass(unsigned int decimation,
+					  double passband)
+{
+	const double stopband = 1.0 / decimation - passband;
+	const double transition = std::max(stopband - passband, 1e-3);
+	const double cutoff = 0.5 / decimation;
+	const double beta = 0.1102 * (ATTENUATION_DB - 8.7);
+	const size_t ntaps = (size_t)std::ceil((ATTENUATION_DB - 8.0) /
+			(2.285 * 2 * M_PI * transition)) + 1;
+	const double mid = (ntaps - 1) / 2.0;
+	const double norm = bessel_i0(beta);
+
+	std::vector<double> h(ntaps);
+	double sum = 0.0;
+
+	for (size_t i = 0; i < ntaps; i++) {
+		const double x = i - mid;
+		const double r = mid > 0 ? x / mid : 0.0;
+		const double sinc = x == 0.0 ? 2 * cutoff :
+			std::sin(2 * M_PI * cutoff * x) / (M_PI * x);
+
+		h[i] = sinc * bessel_i0(beta * std::sqrt(
+				std::max(1.0 - r * r, 0.0))) / norm;
+		sum += h[i];
+	}
+
+	// Unity gain at 0 Hz
+	std::vector<float> taps(ntaps);
+	for (size_t i = 0; i < ntaps; i++) {
+		taps[i] = h[i] / sum;
+	}
+
+	return taps;
+}
+
+void DownConverter::configure(double center, unsigned int decimation)
+{
+	d_center = center;
+	d_decimation = std::max(decimation, 1u);
+
+	// Largest stages first, so the widest transitions run at the
+	// highest rate
+	std::vector<unsigned int> factors;
+	unsigned int rest = d_decimation;
+
+	do {
+		unsigned int f = std::min(rest, MAX_STAGE_DECIMATION);
+
+		while (f > 1 && rest % f) {
+			f--;
+		}
+
+		if (f <= 1) {
+			f = rest;
+		}
+
+		factors.push_back(f);
+		rest /= f;
+	} while (rest > 1);
+
+	const double passband = PASSBAND / d_decimation;
+	double rate = 1.0;
+
+	d_mixer.decimation = factors[0];
+	d_mixer.taps = lowPass(factors[0], passband);
+
+	// Shift the taps to the center of the band. The taps are stored
+	// reversed, with the newest input multiplied by the last one.
+	const size_t ntaps = d_mixer.taps.size();
+	const double w = 2 * M_PI * center;
+
+	d_tapsRe.resize(ntaps);
+	d_tapsIm.resize(ntaps);
+
+	for (size_t j = 0; j < ntaps; j++) {
+		const double k = ntaps - 1 - j;
+		const double h = 2.0 * d_mixer.taps[k];
+
+		d_tapsRe[j] = h * std::cos(w * k);
+		d_tapsIm[j] = h * std::sin(w * k);
+	}
+
+	d_phaseStep = -w * factors[0];
+	rate /= factors[0];
+
+	d_stages.clear();
+	for (size_t i = 1; i < factors.size(); i++) {
+		Stage stage;
+
+		stage.next = 0;
+		stage.decimation = factors[i];
+		stage.taps = lowPass(factors[i], passband / rate);
+		std::reverse(stage.taps.begin(), stage.taps.end());
+		d_stages.push_back(stage);
+		rate /= factors[i];
+	}
+
+	d_buffers.resize(d_stages.size());
+	reset();
+}
+
+void DownConverter::reset()
+{
+	// Start from a zero history, the first output comes with the
+	// first input
+	d_mixerBuffer.assign(d_mixer.taps.size() - 1, 0.0f);
+	d_mixer.next = d_mixerBuffer.size();
+	d_phase = 0.0;
+
+	for (size_t i = 0; i < d_stages.size(); i++) {
+		d_buffers[i].assign(d_stages[i].taps.size() - 1, 0.0f);
+		d_stages[i].next = d_buffers[i].size();
+	}
+}
+
+double DownConverter::center() const
+{
+	return d_center;
+}
+
+unsigned int DownConverter::decimation() const
+{
+	return d_decimation;
+}
+
+size_t DownConverter::stageOutputs(const Stage &stage, size_t buffered,
+				   size_t size)
+{
+	const size_t total = buffered + size;
+
+	return total > stage.next ?
+		(total - stage.next - 1) / stage.decimation + 1 : 0;
+}
+
+size_t DownConverter::stageInputs(const Stage &stage, size_t buffered,
+				  size_t count)
+{
+	return count ? stage.next + (count - 1) * stage.decimation + 1 -
+		buffered : 0;
+}
+
+size_t DownConverter::outputsFor(size_t size) const
+{
+	size_t n = stageOutputs(d_mixer, d_mixerBuffer.size(), size);
+
+	for (size_t i = 0; i < d_stages.size(); i++) {
+		n = stageOutputs(d_stages[i], d_buffers[i].size(), n);
+	}
+
+	return n;
+}
+
+size_t DownConverter::inputsFor(size_t count) const
+{
+	for (size_t i = d_stages.size(); i > 0; i--) {
+		count = stageInputs(d_stages[i - 1], d_buffers[i - 1].size(),
+				    count);
+	}
+
+	return stageInputs(d_mixer, d_mixerBuffer.size(), count);
+}
+
+size_t DownConverter::settlingOutputs() const
+{
+	// Output j of a stage reads inputs j * decimation - ntaps + 1 to
+	// j * decimation, so it is clean once that window is past the
+	// zero history and the unsettled outputs of the stage before
+	size_t n = (d_mixer.taps.size() - 1 + d_mixer.decimation - 1) /
+		d_mixer.decimation;
+
+	for (const Stage &stage : d_stages) {
+		n = (n + stage.taps.size() - 1 + stage.decimation - 1) /
+			stage.decimation;
+	}
+
+	return n;
+}
+
+/* Keeps only the history that the next output still needs */
+template <typename T>
+void DownConverter::trim(Stage &stage, std::vector<T> &buffer)
+{
+	const size_t history = stage.taps.size() - 1;
+	const size_t drop = std::min(stage.next - history, buffer.size());
+
+	buffer.erase(buffer.begin(), buffer.begin() + drop);
+	stage.next -= drop;
+}
+
+size_t DownConverter::mix(const float *in, size_t size,
+			  std::complex<float> *out)
+{
+	d_mixerBuffer.insert(d_mixerBuffer.end(), in, in + size);
+
+	const size_t ntaps = d_tapsRe.size();
+	const float *re = d_tapsRe.data();
+	const float *im = d_tapsIm.data();
+	const float *buffer = d_mixerBuffer.data();
+	size_t n = 0;
+
+	for (; d_mixer.next < d_mixerBuffer.size();
+			d_mixer.next += d_mixer.decimation) {
+		const float *x = buffer + d_mixer.next + 1 - ntaps;
+		float accRe;
+		float accIm;
+
+		volk_32f_x2_dot_prod_32f(&accRe, x, re, ntaps);
+		volk_32f_x2_dot_prod_32f(&accIm, x, im, ntaps);
+
+		out[n++] = std::complex<float>(accRe, accIm) *
+			std::polar(1.0f, (float)d_phase);
+
+		d_phase = std::remainder(d_phase + d_phaseStep, 2 * M_PI);
+	}
+
+	trim(d_mixer, d_mixerBuffer);
+	return n;
+}
+
+size_t DownConverter::filter(Stage &stage,
+			     std::vector<std::complex<float>> &buffer,
+			     const std::complex<float> *in, size_t size,
+			     std::complex<float> *out)
+{
+	buffer.insert(buffer.end(), in, in + size);
+
+	const size_t ntaps = stage.taps.size();
+	const float *taps = stage.taps.data();
+	size_t n = 0;
+
+	for (; stage.next < buffer.size(); stage.next += stage.decimation) {
+		volk_32fc_32f_dot_prod_32fc(&out[n++],
+				&buffer[stage.next + 1 - ntaps], taps, ntaps);
+	}
+
+	trim(stage, buffer);
+	return n;
+}
+
+size_t DownConverter::process(const float *in, size_t size,
+			      std::complex<float> *out)
+{
+	if (d_stages.empty()) {
+		return mix(in, size, out);
+	}
+
+	size_t n = stageOutputs(d_mixer, d_mixerBuffer.size(), size);
+	d_scratch[0].resize(n);
+	n = mix(in, size, d_scratch[0].data());
+
+	for (size_t i = 0; i < d_stages.size(); i++) {
+		const bool last = i + 1 == d_stages.size();
+		std::vector<std::complex<float>> &src = d_scratch[i % 2];
+		std::vector<std::complex<float>> &dst = d_scratch[(i + 1) % 2];
+
+		if (!last) {
+			dst.resize(stageOutputs(d_stages[i],
+						d_buffers[i].size(), n));
+		}
+
+		n = filter(d_stages[i], d_buffers[i], src.data(), n,
+			   last ? out : dst.data());
+	}
+
+	return n;
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DOWN_CONVERTER_HPP
+#define DOWN_CONVERTER_HPP
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+namespace adiscope {
+
+/*
+ * Digital down converter: shifts a band of a real signal to 0 Hz and
+ * decimates it, giving a complex signal that only holds that band.
+ *
+ * The decimation runs in stages of at most 8, each a FIR low pass that
+ * only computes the samples it keeps. The first stage also does the
+ * mixing: its taps are shifted to the band center, so the signal is
+ * only rotated back at the decimated rate.
+ *
+ * Frequencies within 0.4 of the output rate around the center are kept
+ * flat; anything that would alias into them is attenuated by 90 dB. The
+ * output has a gain of 2, so that a tone keeps the amplitude it had in
+ * the one sided spectrum of the real input.
+ */
+class DownConverter
+{
+public:
+	DownConverter();
+
+	/*
+	 * Center is relative to the input sample rate, in [0, 0.5].
+	 * Resets the filter state.
+	 */
+	void configure(double center, unsigned int decimation);
+	void reset();
+
+	double center() const;
+	unsigned int decimation() const;
+
+	/* Number of outputs the next size inputs will produce */
+	size_t outputsFor(size_t size) const;
+
+	/* Number of inputs needed for the next count outputs */
+	size_t inputsFor(size_t count) const;
+
+	/* Outputs after a reset that still depend on the zero history */
+	size_t settlingOutputs() const;
+
+	/* Returns the number of outputs written, i.e. outputsFor(size) */
+	size_t process(const float *in, size_t size,
+		       std::complex<float> *out);
+
+private:
+	struct Stage {
+		unsigned int decimation;
+		std::vector<float> taps;
+
+		/* Position in the buffer of the newest input of next output */
+		size_t next;
+	};
+
+	static std::vector<float> lowPass(unsigned int decimation,
+					  double passband);
+	static size_t stageOutputs(const Stage &stage, size_t buffered,
+				   size_t size);
+	static size_t stageInputs(const Stage &stage, size_t buffered,
+				  size_t count);
+	template <typename T>
+	static void trim(Stage &stage, std::vector<T> &buffer);
+
+	size_t mix(const float *in, size_t size, std::complex<float> *out);
+	static size_t filter(Stage &stage,
+			     std::vector<std::complex<float>> &buffer,
+			     const std::complex<float> *in, size_t size,
+			     std::complex<float> *out);
+
+	double d_center;
+	unsigned int d_decimation;
+
+	/* The first stage works on the real input, with complex taps */
+	Stage d_mixer;
+	std::vector<float> d_mixerBuffer;
+	std::vector<float> d_tapsRe;
+	std::vector<float> d_tapsIm;
+	double d_phase;
+	double d_phaseStep;
+
+	std::vector<Stage> d_stages;
+	std::vector<std::vector<std::complex<float>>> d_buffers;
+	std::vector<std::complex<float>> d_scratch[2];
+};
+
+} /* namespace adiscope */
+
+#endif /* DOWN_CONVERTER_HPP */
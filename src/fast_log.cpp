@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fast_log.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+using namespace adiscope;
+
+/* Largest |t| = (m - 1) / (m + 1) for m in [sqrt(1/2), sqrt(2)) */
+static const double MAX_T = (M_SQRT2 - 1) / (M_SQRT2 + 1);
+
+FastLog::FastLog(double maxError):
+	d_maxError(0),
+	d_terms(0)
+{
+	setMaxError(maxError);
+}
+
+/*
+ * The terms left out fall by more than t^2 each, so they add up to less
+ * than the first of them, 2 / ln(2) * t^(2n + 1) / (2n + 1), over
+ * 1 - t^2.
+ */
+double FastLog::seriesError(unsigned int terms)
+{
+	const unsigned int power = 2 * terms + 1;
+
+	return 2 / M_LN2 * std::pow(MAX_T, power) / power /
+		(1 - MAX_T * MAX_T);
+}
+
+void FastLog::setMaxError(double maxError)
+{
+	d_maxError = std::max(maxError, 0.0);
+	d_terms = 0;
+
+	// Past MAX_TERMS the series is as good as a float gets
+	for (unsigned int n = 1; d_maxError > 0 && n <= MAX_TERMS; n++) {
+		if (seriesError(n) <= d_maxError || n == MAX_TERMS) {
+			d_terms = n;
+			break;
+		}
+	}
+}
+
+double FastLog::maxError() const
+{
+	return d_maxError;
+}
+
+double FastLog::errorBound() const
+{
+	return d_terms ? seriesError(d_terms) : 0.0;
+}
+
+unsigned int FastLog::terms() const
+{
+	return d_terms;
+}
+
+namespace {
+
+/* Horner form of sum(2 / ln(2) / (2j + 1) * t2^j), j in [J, TERMS) */
+template <unsigned int J, unsigned int TERMS>
+struct Horner {
+	static inline float eval(float t2)
+	{
+		return (float)(2 / M_LN2 / (2 * J + 1)) +
+			t2 * Horner<J + 1, TERMS>::eval(t2);
+	}
+};
+
+template <unsigned int TERMS>
+struct Horner<TERMS, TERMS> {
+	static inline float eval(float)
+	{
+		return 0.0f;
+	}
+};
+
+} /* namespace */
+
+template <unsigned int TERMS>
+void FastLog::series(const float *in, float *out, size_t size)
+{
+	// Bits of sqrt(2) as a float
+	const int32_t sqrt2 = 0x3fb504f3;
+
+	// Integer only folding, so that the compiler can vectorize it
+	for (size_t i = 0; i < size; i++) {
+		int32_t bits;
+		std::memcpy(&bits, &in[i], sizeof(bits));
+
+		int32_t mbits = (bits & 0x7fffff) | 0x3f800000;
+		const int32_t fold = mbits > sqrt2;
+		const int32_t e = ((bits >> 23) & 0xff) - 127 + fold;
+
+		// Halve the mantissa by taking one off its exponent
+		mbits -= fold << 23;
+
+		float m;
+		std::memcpy(&m, &mbits, sizeof(m));
+
+		const float t = (m - 1.0f) / (m + 1.0f);
+
+		out[i] = (float)e + t * Horner<0, TERMS>::eval(t * t);
+	}
+}
+
+void FastLog::log2(const float *in, float *out, size_t size) const
+{
+	switch (d_terms) {
+	case 1:
+		series<1>(in, out, size);
+		break;
+	case 2:
+		series<2>(in, out, size);
+		break;
+	case 3:
+		series<3>(in, out, size);
+		break;
+	case 4:
+		series<4>(in, out, size);
+		break;
+	default:
+		for (size_t i = 0; i < size; i++) {
+			out[i] = std::log2(in[i]);
+		}
+		break;
+	}
+}
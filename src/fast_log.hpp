@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAST_LOG_HPP
+#define FAST_LOG_HPP
+
+#include <cstddef>
+
+namespace adiscope {
+
+/*
+ * Base 2 logarithm of float buffers with a chosen accuracy, in loops
+ * the compiler can vectorize.
+ *
+ * The exponent is taken from the bits of each value and the mantissa,
+ * folded to [sqrt(1/2), sqrt(2)), goes through the odd series of
+ * log((1 + t) / (1 - t)), cut after as few terms as the accuracy
+ * allows. The bound is on the series; rounding the result to a float
+ * adds its half ulp, as it does for std::log2. Zero and denormals give
+ * about -127 instead of -inf.
+ */
+class FastLog
+{
+public:
+	/* Largest error allowed, in log2 units; 0 takes std::log2 */
+	explicit FastLog(double maxError = 0);
+
+	void setMaxError(double maxError);
+	double maxError() const;
+
+	/*
+	 * Largest error of the terms in use. It stays within maxError()
+	 * down to seriesError(MAX_TERMS), about 4.3e-8; below that the
+	 * series stops at MAX_TERMS, where the float rounding of the
+	 * result is the larger error anyway.
+	 */
+	double errorBound() const;
+	unsigned int terms() const;
+
+	/* in and out may be the same buffer */
+	void log2(const float *in, float *out, size_t size) const;
+
+	static const unsigned int MAX_TERMS = 4;
+
+	/* Error of the series cut after the given number of terms */
+	static double seriesError(unsigned int terms);
+
+private:
+	template <unsigned int TERMS>
+	static void series(const float *in, float *out, size_t size);
+
+	double d_maxError;
+	unsigned int d_terms;
+};
+
+} /* namespace adiscope */
+
+#endif /* FAST_LOG_HPP */
@@ -18,64 +18,580 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <gnuradio/blocks/stream_to_vector.h>
-#include <gnuradio/blocks/vector_to_stream.h>
-#include <gnuradio/fft/fft_vcc.h>
-#include <gnuradio/fft/fft_vfc.h>
+#include <gnuradio/fft/fft.h>
 #include <gnuradio/fft/window.h>
-#include "stream_to_vector_overlap.h"
+#include <gnuradio/io_signature.h>
 
 #include "fft_block.hpp"
 
+#include <algorithm>
+#include <list>
+#include <string.h>
+
 using namespace adiscope;
 using namespace gr;
 
+struct fft_block::Transform {
+	size_t size;
+	bool complex;
+	std::unique_ptr<fft::fft_real_fwd> real;
+	std::unique_ptr<fft::fft_complex> cplx;
+};
+
+/*
+ * Transforms not in use by any fft_block, newest first. Planning a large
+ * FFT takes long, so switching back to a recently used size reuses the
+ * existing plan. Only the most recent few are kept, as each one holds
+ * its own buffers.
+ */
+static const size_t MAX_CACHED_TRANSFORMS = 16;
+static std::mutex cache_mutex;
+static std::list<std::unique_ptr<fft_block::Transform>> cache;
+
+static std::unique_ptr<fft_block::Transform> get_transform(size_t size,
+							     bool complex)
+{
+	{
+		std::lock_guard<std::mutex> lock(cache_mutex);
+
+		for (auto it = cache.begin(); it != cache.end(); ++it) {
+			if ((*it)->size == size && (*it)->complex == complex) {
+				std::unique_ptr<fft_block::Transform> t =
+					std::move(*it);
+				cache.erase(it);
+				return t;
+			}
+		}
+	}
+
+	std::unique_ptr<fft_block::Transform> t(new fft_block::Transform);
+	t->size = size;
+	t->complex = complex;
+
+	if (complex) {
+		t->cplx.reset(new fft::fft_complex(size, true));
+	} else {
+		t->real.reset(new fft::fft_real_fwd(size));
+	}
+
+	return t;
+}
+
+static void put_transform(std::unique_ptr<fft_block::Transform> t)
+{
+	std::lock_guard<std::mutex> lock(cache_mutex);
+
+	cache.push_front(std::move(t));
+	if (cache.size() > MAX_CACHED_TRANSFORMS) {
+		cache.pop_back();
+	}
+}
+
+/*
+ * Windows one segment and writes its fft_size bins to out. With shift
+ * set, the negative frequencies come first.
+ */
+static void run_transform(fft_block::Transform &t, const char *in,
+			  const std::vector<float> &window, gr_complex *out,
+			  bool shift)
+{
+	const size_t size = t.size;
+	const bool windowed = window.size() == size;
+
+	if (t.complex) {
+		const gr_complex *src = reinterpret_cast<const gr_complex *>(in);
+		gr_complex *dst = t.cplx->get_inbuf();
+
+		if (windowed) {
+			for (size_t i = 0; i < size; i++)
+				dst[i] = src[i] * window[i];
+		} else {
+			memcpy(dst, src, size * sizeof(gr_complex));
+		}
+
+		t.cplx->execute();
+
+		const gr_complex *bins = t.cplx->get_outbuf();
+		const size_t half = shift ? size / 2 : 0;
+
+		memcpy(out, bins + size - half, half * sizeof(gr_complex));
+		memcpy(out + half, bins, (size - half) * sizeof(gr_complex));
+		return;
+	}
+
+	const float *src = reinterpret_cast<const float *>(in);
+	float *dst = t.real->get_inbuf();
+
+	if (windowed) {
+		for (size_t i = 0; i < size; i++)
+			dst[i] = src[i] * window[i];
+	} else {
+		memcpy(dst, src, size * sizeof(float));
+	}
+
+	t.real->execute();
+
+	// The real transform only gives the first half, the rest mirrors it
+	const size_t half = size / 2 + 1;
+	memcpy(out, t.real->get_outbuf(), half * sizeof(gr_complex));
+
+	for (size_t i = half; i < size; i++)
+		out[i] = std::conj(out[size - i]);
+}
+
 fft_block::fft_block(bool use_complex, size_t fft_size, unsigned int nbthreads)
-	: hier_block2("FFT",
+	: block("FFT",
 			io_signature::make(1, 1, use_complex ?
 				sizeof(gr_complex) : sizeof(float)),
 			io_signature::make(1, 1, sizeof(gr_complex))),
-	d_complex(use_complex)
+	d_complex(use_complex),
+	d_zoom(false),
+	d_itemsize(use_complex ? sizeof(gr_complex) : sizeof(float)),
+	d_fft_size(fft_size),
+	d_hop(fft_size),
+	d_overlap_factor(0.0),
+	d_sweep_pos(0),
+	d_sweep_first(0),
+	d_settle(0),
+	d_input_items(0),
+	d_input_offset(0),
+	d_frames_count(0),
+	d_frames_pos(0),
+	d_job(nullptr),
+	d_job_count(0),
+	d_job_next(0),
+	d_job_busy(0),
+	d_job_generation(0),
+	d_quit(false)
 {
-	auto v2s = blocks::vector_to_stream::make(sizeof(gr_complex), fft_size);
-
-	d_s2v_overlap = adiscope::stream_to_vector_overlap::make(
-				use_complex ? sizeof(gr_complex) : sizeof(float),
-				fft_size, 0.0);
+	/* Tags are moved to the first segment that starts after them */
+	set_tag_propagation_policy(TPP_DONT);
 
 	/* We use a Hamming window for now */
-	auto window = fft::window::hamming(fft_size);
+	d_window = fft::window::hamming(fft_size);
 
-	//basic_block_sptr fft;
-	if (use_complex)
-		d_fft = fft::fft_vcc::make(fft_size, true,
-				window, false, nbthreads);
-	else
-		d_fft = fft::fft_vfc::make(fft_size, true,
-				window, nbthreads);
+	for (unsigned int i = 1; i < nbthreads; i++) {
+		d_workers.emplace_back(&fft_block::worker_loop, this, i - 1);
+	}
 
-	/* Connect everything */
-	hier_block2::connect(this->self(), 0, d_s2v_overlap, 0);
-	hier_block2::connect(d_s2v_overlap, 0, d_fft, 0);
-	hier_block2::connect(d_fft, 0, v2s, 0);
-	hier_block2::connect(v2s, 0, this->self(), 0);
+	acquire_transforms();
 }
 
 fft_block::~fft_block()
 {
+	{
+		std::lock_guard<std::mutex> lock(d_work_mutex);
+		d_quit = true;
+	}
+
+	d_work_cond.notify_all();
+
+	for (std::thread &worker : d_workers) {
+		worker.join();
+	}
+
+	release_transforms();
+}
+
+void fft_block::acquire_transforms()
+{
+	for (size_t i = 0; i <= d_workers.size(); i++) {
+		d_transforms.push_back(get_transform(d_fft_size,
+						     d_complex || d_zoom));
+	}
+}
+
+void fft_block::release_transforms()
+{
+	for (auto &t : d_transforms) {
+		put_transform(std::move(t));
+	}
+
+	d_transforms.clear();
 }
 
 void fft_block::set_overlap_factor(double overlap_factor)
 {
-	boost::dynamic_pointer_cast<adiscope::stream_to_vector_overlap>(
-				d_s2v_overlap)->set_overlap_factor(overlap_factor);
+	gr::thread::scoped_lock lock(d_setlock);
+
+	d_overlap_factor = overlap_factor;
+	d_hop = d_fft_size - (size_t)(d_fft_size * overlap_factor);
+	d_hop = std::max<size_t>(std::min(d_hop, d_fft_size), 1);
 }
 
 void fft_block::set_window(const std::vector<float>& window)
 {
-	if (d_complex) {
-		boost::dynamic_pointer_cast<fft::fft_vcc>(d_fft)->set_window(window);
+	gr::thread::scoped_lock lock(d_setlock);
+
+	d_window = window;
+}
+
+void fft_block::set_fft_size(size_t fft_size)
+{
+	gr::thread::scoped_lock lock(d_setlock);
+
+	if (fft_size == d_fft_size || fft_size == 0) {
+		return;
+	}
+
+	release_transforms();
+	d_fft_size = fft_size;
+	acquire_transforms();
+
+	d_window = fft::window::hamming(fft_size);
+
+	// Partial segments and spectra of the old size are dropped
+	drop_pending();
+
+	d_hop = fft_size - (size_t)(fft_size * d_overlap_factor);
+	d_hop = std::max<size_t>(std::min(d_hop, fft_size), 1);
+}
+
+size_t fft_block::fft_size() const
+{
+	return d_fft_size;
+}
+
+void fft_block::set_zoom(double center, unsigned int decimation)
+{
+	gr::thread::scoped_lock lock(d_setlock);
+
+	const bool sweeping = !d_sweep.empty();
+
+	d_sweep.clear();
+	configure_zoom(center, decimation, sweeping);
+}
+
+void fft_block::set_sweep(const std::vector<double> &centers,
+			  unsigned int decimation)
+{
+	gr::thread::scoped_lock lock(d_setlock);
+
+	// Only a float stream goes through the down converter
+	if (d_complex || (centers == d_sweep && (centers.empty() ||
+			decimation == d_ddc.decimation()))) {
+		return;
+	}
+
+	d_sweep = centers;
+	d_sweep_pos = 0;
+
+	if (centers.empty()) {
+		configure_zoom(0.0, 1, true);
+	} else {
+		configure_zoom(centers[0], decimation, true);
+	}
+}
+
+unsigned int fft_block::sweep_segments() const
+{
+	return d_sweep.size();
+}
+
+void fft_block::configure_zoom(double center, unsigned int decimation,
+			       bool force)
+{
+	const bool zoom = decimation > 1 && !d_complex;
+
+	if (!force && zoom == d_zoom && (!zoom || (center == d_ddc.center() &&
+			decimation == d_ddc.decimation()))) {
+		return;
+	}
+
+	if (zoom != d_zoom) {
+		release_transforms();
+		d_zoom = zoom;
+		acquire_transforms();
+	}
+
+	if (zoom) {
+		d_ddc.configure(center, decimation);
+	}
+
+	d_itemsize = d_complex || d_zoom ? sizeof(gr_complex) : sizeof(float);
+	drop_pending();
+}
+
+unsigned int fft_block::zoom_decimation() const
+{
+	return d_zoom ? d_ddc.decimation() : 1;
+}
+
+void fft_block::drop_pending()
+{
+	d_input_offset += d_input_items;
+	d_input_items = 0;
+	d_tags.clear();
+	d_frames_count = 0;
+	d_frames_pos = 0;
+	d_ddc.reset();
+
+	// A sweep restarts the segment it was gathering
+	d_sweep_first = d_sweep_pos;
+	d_settle = d_sweep.empty() ? 0 : d_ddc.settlingOutputs();
+}
+
+/* Sweep segments are gathered one after the other, without overlap */
+size_t fft_block::hop() const
+{
+	return d_sweep.empty() ? d_hop : d_fft_size;
+}
+
+/*
+ * Runs input through the retuned down converter, dropping what it gives
+ * until its filters are past the zero history. Returns the items taken.
+ */
+size_t fft_block::settle(const char *in, size_t size)
+{
+	const size_t n = std::min(size, d_ddc.inputsFor(d_settle));
+
+	d_settle_buffer.resize(d_ddc.outputsFor(n));
+	d_settle -= d_ddc.process(reinterpret_cast<const float *>(in), n,
+				  d_settle_buffer.data());
+	return n;
+}
+
+void fft_block::next_sweep_segment()
+{
+	d_sweep_pos = (d_sweep_pos + 1) % d_sweep.size();
+	d_ddc.configure(d_sweep[d_sweep_pos], d_ddc.decimation());
+	d_settle = d_ddc.settlingOutputs();
+}
+
+void fft_block::forecast(int noutput_items,
+			 gr_vector_int &ninput_items_required)
+{
+	// Queued spectra can go out without any new input
+	const bool pending = d_frames_pos < d_frames_count * d_fft_size;
+
+	ninput_items_required[0] = pending ? 0 : 1;
+}
+
+void fft_block::run_parallel(size_t count,
+		const std::function<void(unsigned int, size_t)> &fn)
+{
+	if (d_workers.empty() || count < 2) {
+		for (size_t i = 0; i < count; i++) {
+			fn(0, i);
+		}
+
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(d_work_mutex);
+
+	d_job = &fn;
+	d_job_count = count;
+	d_job_next = 0;
+	d_job_busy = d_workers.size();
+	d_job_generation++;
+	d_work_cond.notify_all();
+
+	// The calling thread takes part with transform 0
+	while (d_job_next < d_job_count) {
+		const size_t i = d_job_next++;
+
+		lock.unlock();
+		fn(0, i);
+		lock.lock();
+	}
+
+	d_done_cond.wait(lock, [this] { return d_job_busy == 0; });
+	d_job = nullptr;
+}
+
+void fft_block::worker_loop(unsigned int index)
+{
+	uint64_t generation = 0;
+	std::unique_lock<std::mutex> lock(d_work_mutex);
+
+	for (;;) {
+		d_work_cond.wait(lock, [&] {
+			return d_quit || d_job_generation != generation;
+		});
+
+		if (d_quit) {
+			return;
+		}
+
+		generation = d_job_generation;
+
+		while (d_job_next < d_job_count) {
+			const size_t i = d_job_next++;
+
+			lock.unlock();
+			(*d_job)(index + 1, i);
+			lock.lock();
+		}
+
+		if (--d_job_busy == 0) {
+			d_done_cond.notify_all();
+		}
+	}
+}
+
+void fft_block::transform_segments(size_t count)
+{
+	const size_t itemsize = d_itemsize;
+	const size_t step = hop();
+	const bool shift = d_zoom;
+
+	d_frames.resize(count * d_fft_size);
+	d_frame_tags.assign(count, std::vector<tag_t>());
+
+	for (size_t s = 0; s < count; s++) {
+		const uint64_t start = d_input_offset + s * step;
+
+		while (!d_tags.empty() && d_tags.front().offset <= start) {
+			d_frame_tags[s].push_back(d_tags.front());
+			d_tags.pop_front();
+		}
+
+		if (!d_sweep.empty()) {
+			tag_t tag;
+
+			tag.key = pmt::intern("sweep_segment");
+			tag.value = pmt::from_uint64((d_sweep_first + s) %
+						     d_sweep.size());
+			d_frame_tags[s].push_back(tag);
+		}
+	}
+
+	if (!d_sweep.empty()) {
+		d_sweep_first = (d_sweep_first + count) % d_sweep.size();
+	}
+
+	const char *input = d_input.data();
+
+	run_parallel(count, [&](unsigned int t, size_t s) {
+		run_transform(*d_transforms[t], input + s * step * itemsize,
+			      d_window, &d_frames[s * d_fft_size], shift);
+	});
+
+	const size_t used = count * step;
+
+	memmove(d_input.data(), d_input.data() + used * itemsize,
+		(d_input_items - used) * itemsize);
+	d_input_items -= used;
+	d_input_offset += used;
+
+	d_frames_count = count;
+	d_frames_pos = 0;
+}
+
+/*
+ * Takes up to size items starting at the given stream offset, as many as
+ * it takes to buffer wanted more segment samples. Tag offsets are turned
+ * into positions in the segment samples. Returns the items taken.
+ */
+size_t fft_block::gather(const char *in, size_t size, size_t wanted,
+			 uint64_t offset)
+{
+	const size_t n = std::min(size, d_zoom ?
+				  d_ddc.inputsFor(wanted) : wanted);
+	const uint64_t base = d_input_offset + d_input_items;
+	std::vector<tag_t> tags;
+
+	get_tags_in_range(tags, 0, offset, offset + n);
+	for (tag_t &tag : tags) {
+		const size_t pos = tag.offset - offset;
+
+		tag.offset = base + (d_zoom ? d_ddc.outputsFor(pos) : pos);
+		d_tags.push_back(tag);
+	}
+
+	const size_t count = d_zoom ? d_ddc.outputsFor(n) : n;
+	char *dst;
+
+	d_input.resize((d_input_items + count) * d_itemsize);
+	dst = d_input.data() + d_input_items * d_itemsize;
+
+	if (d_zoom) {
+		d_ddc.process(reinterpret_cast<const float *>(in), n,
+			      reinterpret_cast<gr_complex *>(dst));
 	} else {
-		boost::dynamic_pointer_cast<fft::fft_vfc>(d_fft)->set_window(window);
+		memcpy(dst, in, n * d_itemsize);
 	}
+
+	d_input_items += count;
+	return n;
+}
+
+int fft_block::general_work(int noutput_items,
+			    gr_vector_int &ninput_items,
+			    gr_vector_const_void_star &input_items,
+			    gr_vector_void_star &output_items)
+{
+	gr::thread::scoped_lock lock(d_setlock);
+
+	const size_t itemsize = input_signature()->sizeof_stream_item(0);
+	const char *in = static_cast<const char *>(input_items[0]);
+	gr_complex *out = static_cast<gr_complex *>(output_items[0]);
+	const size_t available = ninput_items[0];
+	const size_t batch = d_transforms.size();
+	size_t consumed = 0;
+	int produced = 0;
+
+	while (produced < noutput_items) {
+		if (d_frames_pos < d_frames_count * d_fft_size) {
+			const size_t frame = d_frames_pos / d_fft_size;
+			const size_t offset = d_frames_pos % d_fft_size;
+			const size_t n = std::min<size_t>(d_fft_size - offset,
+							  noutput_items - produced);
+
+			if (offset == 0) {
+				for (tag_t tag : d_frame_tags[frame]) {
+					tag.offset = nitems_written(0) + produced;
+					add_item_tag(0, tag);
+				}
+			}
+
+			memcpy(out + produced, &d_frames[d_frames_pos],
+			       n * sizeof(gr_complex));
+			produced += n;
+			d_frames_pos += n;
+			continue;
+		}
+
+		// Only take in what the next batch of segments needs, so
+		// that a slow consumer holds back the input
+		const size_t step = hop();
+		const size_t needed = d_fft_size + (batch - 1) * step;
+
+		if (d_input_items < needed && consumed < available) {
+			if (d_settle > 0) {
+				consumed += settle(in + consumed * itemsize,
+						   available - consumed);
+				continue;
+			}
+
+			// A sweep segment ends where the next center begins
+			const size_t before = d_input_items;
+			size_t wanted = needed - d_input_items;
+
+			if (!d_sweep.empty()) {
+				wanted = std::min(wanted, d_fft_size -
+						  d_input_items % d_fft_size);
+			}
+
+			consumed += gather(in + consumed * itemsize,
+					   available - consumed, wanted,
+					   nitems_read(0) + consumed);
+
+			if (!d_sweep.empty() && d_input_items > before &&
+					d_input_items % d_fft_size == 0) {
+				next_sweep_segment();
+			}
+		}
+
+		if (d_input_items < d_fft_size) {
+			break;
+		}
+
+		transform_segments(std::min(batch,
+				(d_input_items - d_fft_size) / step + 1));
+	}
+
+	consume_each(consumed);
+	return produced;
 }
@@ -21,10 +21,37 @@
 #ifndef FFT_BLOCK_HPP
 #define FFT_BLOCK_HPP
 
-#include <gnuradio/hier_block2.h>
+#include <gnuradio/block.h>
+#include <gnuradio/gr_complex.h>
+
+#include "down_converter.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace adiscope {
-	class fft_block : public gr::hier_block2
+	/*
+	 * Windowed FFT of overlapping segments of a float (or complex)
+	 * stream; every segment produces fft_size complex bins.
+	 *
+	 * Input is gathered internally, so the FFT size, window and overlap
+	 * can all change while the block stays in the flowgraph. Transforms
+	 * come from a cache shared by every fft_block, so going back to a
+	 * size does not plan it again. Up to nbthreads segments are
+	 * transformed in parallel.
+	 *
+	 * A float stream can also be zoomed: a down converter in front of
+	 * the FFT keeps only a band around a center frequency, and the
+	 * bins then run from the lower to the upper edge of that band.
+	 * The zoom can also sweep over a list of centers, one spectrum at
+	 * each.
+	 */
+	class fft_block : public gr::block
 	{
 	public:
 		fft_block(bool use_complex, size_t fft_size,
@@ -34,10 +61,100 @@ namespace adiscope {
 		void set_window(const std::vector<float>& window);
 		void set_overlap_factor(double overlap_factor);
 
+		/* Also resets the window to a Hamming one of the new size */
+		void set_fft_size(size_t fft_size);
+		size_t fft_size() const;
+
+		/*
+		 * Center is relative to the sample rate; a decimation of 1
+		 * turns the zoom off. Pending segments are dropped.
+		 */
+		void set_zoom(double center, unsigned int decimation);
+		unsigned int zoom_decimation() const;
+
+		/*
+		 * After every spectrum the zoom moves to the next center,
+		 * wrapping around, and the down converter settles on new
+		 * input before the next segment starts; segments do not
+		 * overlap. Every spectrum gets a "sweep_segment" tag with
+		 * the index of its center. An empty list ends a sweep along
+		 * with its zoom. Complex streams cannot sweep.
+		 */
+		void set_sweep(const std::vector<double> &centers,
+			       unsigned int decimation);
+		unsigned int sweep_segments() const;
+
+		void forecast(int noutput_items,
+			      gr_vector_int &ninput_items_required);
+		int general_work(int noutput_items,
+				 gr_vector_int &ninput_items,
+				 gr_vector_const_void_star &input_items,
+				 gr_vector_void_star &output_items);
+
+		struct Transform;
+
 	private:
+		void acquire_transforms();
+		void release_transforms();
+		void drop_pending();
+		void configure_zoom(double center, unsigned int decimation,
+				    bool force);
+		size_t hop() const;
+		size_t settle(const char *in, size_t size);
+		void next_sweep_segment();
+		size_t gather(const char *in, size_t size, size_t wanted,
+			      uint64_t offset);
+		void transform_segments(size_t count);
+		void run_parallel(size_t count,
+				  const std::function<void(unsigned int, size_t)> &fn);
+		void worker_loop(unsigned int index);
+
 		bool d_complex;
-		gr::basic_block_sptr d_fft;
-		gr::basic_block_sptr d_s2v_overlap;
+		bool d_zoom;
+		size_t d_itemsize;
+		size_t d_fft_size;
+		size_t d_hop;
+		double d_overlap_factor;
+		std::vector<float> d_window;
+
+		DownConverter d_ddc;
+
+		/* Sweep centers, the one being gathered and the one of the
+		 * first buffered segment */
+		std::vector<double> d_sweep;
+		size_t d_sweep_pos;
+		size_t d_sweep_first;
+
+		/* Converter outputs still to drop after a retune */
+		size_t d_settle;
+		std::vector<gr_complex> d_settle_buffer;
+
+		/* Input, down converted when zoomed, not yet covered by a
+		 * whole segment */
+		std::vector<char> d_input;
+		size_t d_input_items;
+		uint64_t d_input_offset;
+		std::deque<gr::tag_t> d_tags;
+
+		/* Transformed segments waiting for output space */
+		std::vector<gr_complex> d_frames;
+		std::vector<std::vector<gr::tag_t>> d_frame_tags;
+		size_t d_frames_count;
+		size_t d_frames_pos;
+
+		std::vector<std::unique_ptr<Transform>> d_transforms;
+
+		/* Helper threads, each one owning transform index + 1 */
+		std::vector<std::thread> d_workers;
+		std::mutex d_work_mutex;
+		std::condition_variable d_work_cond;
+		std::condition_variable d_done_cond;
+		const std::function<void(unsigned int, size_t)> *d_job;
+		size_t d_job_count;
+		size_t d_job_next;
+		unsigned int d_job_busy;
+		uint64_t d_job_generation;
+		bool d_quit;
 	};
 }
 
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frame_exchange.hpp"
+
+using namespace adiscope;
+
+void FrameCounters::reset()
+{
+	produced = 0;
+	delivered = 0;
+	dropped = 0;
+}
+
+FrameExchange::FrameExchange():
+	d_latest(1),
+	d_back(0),
+	d_front(2)
+{
+}
+
+TimeFrame &FrameExchange::back(unsigned int nchannels, size_t size)
+{
+	// Only the producer ever touches the back slot
+	std::shared_ptr<TimeFrame> &frame = d_slots[d_back].frame;
+
+	if (!frame || frame->numChannels() != nchannels
+			|| frame->size() != size) {
+		frame = std::make_shared<TimeFrame>(nchannels, size);
+	}
+
+	return *frame;
+}
+
+bool FrameExchange::publish(size_t offset, size_t size)
+{
+	return publish(offset, size, 0, 1, size);
+}
+
+bool FrameExchange::publish(size_t offset, size_t size, double x0, double dx,
+			    size_t samples)
+{
+	Slot &slot = d_slots[d_back];
+	slot.offset = offset;
+	slot.size = size;
+	slot.x0 = x0;
+	slot.dx = dx;
+	slot.samples = samples;
+
+	const unsigned int prev = d_latest.exchange(d_back | FRESH,
+						    std::memory_order_acq_rel);
+	d_back = prev & INDEX_MASK;
+	d_counters.produced++;
+
+	if (prev & FRESH) {
+		// The GUI never saw the previous frame; it was already
+		// notified about the slot, so don't notify again
+		d_counters.dropped++;
+		return false;
+	}
+
+	return true;
+}
+
+void FrameExchange::drop()
+{
+	d_counters.produced++;
+	d_counters.dropped++;
+}
+
+const FrameExchange::Slot *FrameExchange::take()
+{
+	if (!(d_latest.load(std::memory_order_acquire) & FRESH)) {
+		return nullptr;
+	}
+
+	const unsigned int prev = d_latest.exchange(d_front,
+						    std::memory_order_acq_rel);
+	d_front = prev & INDEX_MASK;
+	d_counters.delivered++;
+
+	const Slot &slot = d_slots[d_front];
+
+	return slot.frame ? &slot : nullptr;
+}
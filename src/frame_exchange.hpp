@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAME_EXCHANGE_HPP
+#define FRAME_EXCHANGE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "time_frame_pool.hpp"
+
+namespace adiscope {
+
+/*
+ * Frame statistics of a sink. A frame is produced once the sink has a full
+ * buffer for the plot; it is then either delivered to the GUI or dropped
+ * because the plot was throttled or a newer frame replaced it.
+ */
+struct FrameCounters
+{
+	FrameCounters(): produced(0), delivered(0), dropped(0) {}
+
+	void reset();
+
+	std::atomic<unsigned long long> produced;
+	std::atomic<unsigned long long> delivered;
+	std::atomic<unsigned long long> dropped;
+};
+
+/*
+ * Lock-free hand-over of TimeFrames between one sink thread (producer) and
+ * the GUI thread (consumer), built as a triple buffer: the producer fills
+ * its back frame, the consumer reads its front frame and the third one is
+ * the "latest frame" slot in between. Publishing swaps the back frame into
+ * that slot; if the consumer did not pick up the previous one yet, it gets
+ * replaced and counts as dropped. No frame is allocated or copied after
+ * the first three.
+ *
+ * publish() returns true only when the slot was empty, so the producer
+ * posts at most one notification event for any number of frames the GUI
+ * is lagging behind.
+ */
+class FrameExchange
+{
+public:
+	struct Slot {
+		Slot(): offset(0), size(0), x0(0), dx(1), samples(0) {}
+
+		std::shared_ptr<TimeFrame> frame;
+		size_t offset;
+		size_t size;
+
+		/*
+		 * For frames that hold values derived from the samples
+		 * (e.g. bin counts): abscissa of the first value, spacing
+		 * of the values and number of samples they came from
+		 */
+		double x0;
+		double dx;
+		size_t samples;
+	};
+
+	FrameExchange();
+
+	FrameExchange(const FrameExchange&) = delete;
+	FrameExchange& operator=(const FrameExchange&) = delete;
+
+	/*
+	 * Producer: the frame to fill, reallocated if its geometry differs.
+	 * It keeps its contents until the next publish().
+	 */
+	TimeFrame &back(unsigned int nchannels, size_t size);
+
+	/* Producer: hands over samples [offset, offset + size) of back() */
+	bool publish(size_t offset, size_t size);
+	bool publish(size_t offset, size_t size, double x0, double dx,
+		     size_t samples);
+
+	/* Producer: counts a frame that was not published at all */
+	void drop();
+
+	/*
+	 * Consumer: the newest published frame, or nullptr if there is
+	 * nothing new. It stays valid until the next call.
+	 */
+	const Slot *take();
+
+	const FrameCounters &counters() const { return d_counters; }
+	void resetCounters() { d_counters.reset(); }
+
+private:
+	static const unsigned int FRESH = 4;
+	static const unsigned int INDEX_MASK = 3;
+
+	Slot d_slots[3];
+
+	/* Index of the latest frame slot, with FRESH set until it is taken */
+	std::atomic<unsigned int> d_latest;
+	unsigned int d_back;
+	unsigned int d_front;
+
+	FrameCounters d_counters;
+};
+
+} /* namespace adiscope */
+
+#endif /* FRAME_EXCHANGE_HPP */
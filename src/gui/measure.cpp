@@ -19,6 +19,7 @@
  */
 
 #include "measure.h"
+#include "sample_statistics.h"
 #include <cmath>
 #include "adc_sample_conv.hpp"
 #include <qmath.h>
@@ -29,6 +30,9 @@
 
 using namespace adiscope;
 
+/* Samples processed per block by measureTimeDomain() */
+static const ssize_t MEASURE_BLOCK_SIZE = 4096;
+
 namespace adiscope {
 	class CrossPoint
 	{
@@ -810,6 +814,21 @@ void Measure::setConversionFunction(const std::function<double(unsigned int, dou
 
 }
 
+void Measure::copySettings(const Measure &other)
+{
+	setChannel(other.m_channel);
+	m_sample_rate = other.m_sample_rate;
+	m_adc_bit_count = other.m_adc_bit_count;
+	m_cross_level = other.m_cross_level;
+	m_hysteresis_span = other.m_hysteresis_span;
+	m_startIndex = other.m_startIndex;
+	m_endIndex = other.m_endIndex;
+	m_gatingEnabled = other.m_gatingEnabled;
+	m_harmonics_number = other.m_harmonics_number;
+	m_mask = other.m_mask;
+	m_conversion_function = other.m_conversion_function;
+}
+
 bool Measure::highLowFromHistogram(double &low, double &high,
 		double min, double max)
 {
@@ -867,6 +886,16 @@ void Measure::setDataSource(double *buffer, size_t length)
 	m_buf_length = length;
 }
 
+const double *Measure::dataSource() const
+{
+	return m_buffer;
+}
+
+size_t Measure::dataLength() const
+{
+	return m_buf_length;
+}
+
 void Measure::measure()
 {
 	clearMeasurements();
@@ -935,21 +964,11 @@ void Measure::measureTimeDomain()
 			m_endIndex = m_buf_length;
 		}
 
-		max = data[m_startIndex];
-		min = data[m_startIndex];
-		sum = data[m_startIndex];
-		sqr_sum = data[m_startIndex] * data[m_startIndex];
-		startIndex = m_startIndex+1;
+		startIndex = m_startIndex;
 		endIndex = m_endIndex;
-
-		count = (m_endIndex - m_startIndex) ?: 1;
 	}
 	else{
-		max = data[0];
-		min = data[0];
-		sum = data[0];
-		sqr_sum = data[0] * data[0];
-		startIndex = 1;
+		startIndex = 0;
 		endIndex = data_length;
 	}
 
@@ -958,35 +977,41 @@ void Measure::measureTimeDomain()
 	if (using_histogram_method)
 		m_histogram = new int[adc_span]{};
 
-	for (ssize_t i = startIndex; i < endIndex; i++) {
+	// Walk the buffer in cache sized blocks: the vectorized statistics,
+	// the crossing detection and the histogram all run on a block while
+	// it is still in cache, so the whole buffer is read from memory once.
+	SampleStatistics stats;
 
-		if (qIsNaN(data[i])) {
-			count--;
-			continue;
-		}
-		// Find level crossings (period detection)
-		m_cross_detect->crossDetectStep(data, i);
+	for (ssize_t blockStart = startIndex; blockStart < endIndex;
+			blockStart += MEASURE_BLOCK_SIZE) {
+		const ssize_t blockEnd = std::min<ssize_t>(blockStart +
+				MEASURE_BLOCK_SIZE, endIndex);
 
-		// Min
-		if (data[i] < min) {
-			min = data[i];
-		}
+		stats.accumulate(data + blockStart, blockEnd - blockStart);
 
-		// Max
-		if (data[i] > max) {
-			max = data[i];
-		}
+		for (ssize_t i = std::max<ssize_t>(blockStart, startIndex + 1);
+				i < blockEnd; i++) {
+			if (qIsNaN(data[i])) {
+				continue;
+			}
 
-		// Sum of values
-		sum += data[i];
+			// Find level crossings (period detection)
+			m_cross_detect->crossDetectStep(data, i);
+		}
 
-		// Sum of the squares of values
-		sqr_sum += data[i] * data[i];
+		if (!using_histogram_method) {
+			continue;
+		}
 
 		// Build histogram
-		if (using_histogram_method) {
+		for (ssize_t i = std::max<ssize_t>(blockStart, startIndex + 1);
+				i < blockEnd; i++) {
 			double rawTmp = data[i];
 			int raw = 0;
+
+			if (qIsNaN(rawTmp)) {
+				continue;
+			}
 			if (m_conversion_function) {
 				raw = (int)m_conversion_function(m_channel, rawTmp, false);
 			}
@@ -997,6 +1022,25 @@ void Measure::measureTimeDomain()
 		}
 	}
 
+	// Nothing to measure (empty gate or only NaN samples): publish NaN
+	// rather than leaving the previous results on display
+	if (stats.count() == 0) {
+		for (int i = 0; i < m_measurements.size(); i++)
+			m_measurements[i]->setValue(qQNaN());
+
+		delete[] m_histogram;
+		m_histogram = NULL;
+		delete m_cross_detect;
+		m_cross_detect = NULL;
+		return;
+	}
+
+	count = stats.count();
+	min = stats.min();
+	max = stats.max();
+	sum = stats.sum();
+	sqr_sum = stats.sqrSum();
+
 	m_measurements[MIN]->setValue(min);
 	m_measurements[MAX]->setValue(max);
 
@@ -119,6 +119,8 @@ namespace adiscope {
 			const std::function<double(unsigned int, double, bool)> &conversion = nullptr, bool isTimeDomain = true);
 
 		void setDataSource(double *buffer, size_t length);
+		const double *dataSource() const;
+		size_t dataLength() const;
 		void measure();
 
 		void measureTimeDomain();
@@ -147,6 +149,9 @@ namespace adiscope {
 
 		void setConversionFunction(const std::function<double (unsigned int, double, bool)> &fp);
 
+		/* Copies everything that affects measure() except the data source */
+		void copySettings(const Measure &other);
+
 		std::vector<int> LoadMaskfromFile(std::string file_name);
 
 	private:
@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sample_statistics.h"
+
+#include <limits>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define SAMPLE_STATISTICS_AVX
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SAMPLE_STATISTICS_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SAMPLE_STATISTICS_NEON
+#endif
+
+using namespace adiscope;
+
+const int SampleStatistics::LANES;
+
+SampleStatistics::SampleStatistics()
+{
+	clear();
+}
+
+void SampleStatistics::clear()
+{
+	for (int lane = 0; lane < LANES; lane++) {
+		m_min[lane] = std::numeric_limits<double>::infinity();
+		m_max[lane] = -std::numeric_limits<double>::infinity();
+		m_sum[lane] = 0.0;
+		m_sqr_sum[lane] = 0.0;
+	}
+
+	m_count = 0;
+	m_pushed = 0;
+}
+
+void SampleStatistics::accumulate(const double *data, size_t length)
+{
+	size_t i = 0;
+
+	// Realign on lane 0 so that the vector kernel can take over
+	while (i < length && (m_pushed % LANES) != 0) {
+		accumulateScalar(data + i, 1);
+		i++;
+	}
+
+	const size_t body = (length - i) / LANES * LANES;
+
+	accumulateVector(data + i, body);
+	i += body;
+
+	accumulateScalar(data + i, length - i);
+}
+
+/*
+ * Reference implementation. Every expression mirrors what the vector
+ * kernels compute per lane: NaN samples add 0 to the sums and +/-inf to
+ * the extremes, and min/max keep the accumulator unless strictly beaten.
+ */
+void SampleStatistics::accumulateScalar(const double *data, size_t length)
+{
+	const double inf = std::numeric_limits<double>::infinity();
+
+	for (size_t i = 0; i < length; i++) {
+		const int lane = m_pushed % LANES;
+		const double v = data[i];
+		const bool valid = (v == v);
+		const double s = valid ? v : 0.0;
+		const double lo = valid ? v : inf;
+		const double hi = valid ? v : -inf;
+
+		m_sum[lane] = m_sum[lane] + s;
+		m_sqr_sum[lane] = m_sqr_sum[lane] + s * s;
+		m_min[lane] = (m_min[lane] < lo) ? m_min[lane] : lo;
+		m_max[lane] = (m_max[lane] > hi) ? m_max[lane] : hi;
+
+		m_count += valid;
+		m_pushed++;
+	}
+}
+
+#if defined(SAMPLE_STATISTICS_AVX)
+
+void SampleStatistics::accumulateVector(const double *data, size_t length)
+{
+	const __m256d inf = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+	const __m256d ninf = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+	const __m256d zero = _mm256_setzero_pd();
+	__m256d sum = _mm256_loadu_pd(m_sum);
+	__m256d sqr = _mm256_loadu_pd(m_sqr_sum);
+	__m256d lo = _mm256_loadu_pd(m_min);
+	__m256d hi = _mm256_loadu_pd(m_max);
+	size_t invalid = 0;
+
+	for (size_t i = 0; i < length; i += LANES) {
+		const __m256d v = _mm256_loadu_pd(data + i);
+		const __m256d valid = _mm256_cmp_pd(v, v, _CMP_ORD_Q);
+		const __m256d s = _mm256_blendv_pd(zero, v, valid);
+		const int mask = _mm256_movemask_pd(valid);
+
+		sum = _mm256_add_pd(sum, s);
+		sqr = _mm256_add_pd(sqr, _mm256_mul_pd(s, s));
+		lo = _mm256_min_pd(lo, _mm256_blendv_pd(inf, v, valid));
+		hi = _mm256_max_pd(hi, _mm256_blendv_pd(ninf, v, valid));
+
+		invalid += 4 - ((mask & 1) + ((mask >> 1) & 1) +
+				((mask >> 2) & 1) + ((mask >> 3) & 1));
+	}
+
+	_mm256_storeu_pd(m_sum, sum);
+	_mm256_storeu_pd(m_sqr_sum, sqr);
+	_mm256_storeu_pd(m_min, lo);
+	_mm256_storeu_pd(m_max, hi);
+
+	m_count += length - invalid;
+	m_pushed += length;
+}
+
+#elif defined(SAMPLE_STATISTICS_SSE2)
+
+void SampleStatistics::accumulateVector(const double *data, size_t length)
+{
+	const __m128d inf = _mm_set1_pd(std::numeric_limits<double>::infinity());
+	const __m128d ninf = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+	__m128d sum[2], sqr[2], lo[2], hi[2];
+	size_t invalid = 0;
+
+	for (int k = 0; k < 2; k++) {
+		sum[k] = _mm_loadu_pd(m_sum + 2 * k);
+		sqr[k] = _mm_loadu_pd(m_sqr_sum + 2 * k);
+		lo[k] = _mm_loadu_pd(m_min + 2 * k);
+		hi[k] = _mm_loadu_pd(m_max + 2 * k);
+	}
+
+	for (size_t i = 0; i < length; i += LANES) {
+		for (int k = 0; k < 2; k++) {
+			const __m128d v = _mm_loadu_pd(data + i + 2 * k);
+			const __m128d valid = _mm_cmpord_pd(v, v);
+			const __m128d s = _mm_and_pd(valid, v);
+			const int mask = _mm_movemask_pd(valid);
+
+			sum[k] = _mm_add_pd(sum[k], s);
+			sqr[k] = _mm_add_pd(sqr[k], _mm_mul_pd(s, s));
+			lo[k] = _mm_min_pd(lo[k], _mm_or_pd(s,
+					_mm_andnot_pd(valid, inf)));
+			hi[k] = _mm_max_pd(hi[k], _mm_or_pd(s,
+					_mm_andnot_pd(valid, ninf)));
+
+			invalid += 2 - ((mask & 1) + ((mask >> 1) & 1));
+		}
+	}
+
+	for (int k = 0; k < 2; k++) {
+		_mm_storeu_pd(m_sum + 2 * k, sum[k]);
+		_mm_storeu_pd(m_sqr_sum + 2 * k, sqr[k]);
+		_mm_storeu_pd(m_min + 2 * k, lo[k]);
+		_mm_storeu_pd(m_max + 2 * k, hi[k]);
+	}
+
+	m_count += length - invalid;
+	m_pushed += length;
+}
+
+#elif defined(SAMPLE_STATISTICS_NEON)
+
+void SampleStatistics::accumulateVector(const double *data, size_t length)
+{
+	const float64x2_t inf = vdupq_n_f64(std::numeric_limits<double>::infinity());
+	const float64x2_t ninf = vdupq_n_f64(-std::numeric_limits<double>::infinity());
+	const float64x2_t zero = vdupq_n_f64(0.0);
+	float64x2_t sum[2], sqr[2], lo[2], hi[2];
+	size_t invalid = 0;
+
+	for (int k = 0; k < 2; k++) {
+		sum[k] = vld1q_f64(m_sum + 2 * k);
+		sqr[k] = vld1q_f64(m_sqr_sum + 2 * k);
+		lo[k] = vld1q_f64(m_min + 2 * k);
+		hi[k] = vld1q_f64(m_max + 2 * k);
+	}
+
+	for (size_t i = 0; i < length; i += LANES) {
+		for (int k = 0; k < 2; k++) {
+			const float64x2_t v = vld1q_f64(data + i + 2 * k);
+			const uint64x2_t valid = vceqq_f64(v, v);
+			const float64x2_t s = vbslq_f64(valid, v, zero);
+			const float64x2_t vlo = vbslq_f64(valid, v, inf);
+			const float64x2_t vhi = vbslq_f64(valid, v, ninf);
+
+			// vminq/vmaxq treat signed zeros differently from the
+			// scalar reference, so select explicitly
+			sum[k] = vaddq_f64(sum[k], s);
+			sqr[k] = vaddq_f64(sqr[k], vmulq_f64(s, s));
+			lo[k] = vbslq_f64(vcltq_f64(lo[k], vlo), lo[k], vlo);
+			hi[k] = vbslq_f64(vcgtq_f64(hi[k], vhi), hi[k], vhi);
+
+			invalid += 2 - ((vgetq_lane_u64(valid, 0) & 1) +
+					(vgetq_lane_u64(valid, 1) & 1));
+		}
+	}
+
+	for (int k = 0; k < 2; k++) {
+		vst1q_f64(m_sum + 2 * k, sum[k]);
+		vst1q_f64(m_sqr_sum + 2 * k, sqr[k]);
+		vst1q_f64(m_min + 2 * k, lo[k]);
+		vst1q_f64(m_max + 2 * k, hi[k]);
+	}
+
+	m_count += length - invalid;
+	m_pushed += length;
+}
+
+#else
+
+void SampleStatistics::accumulateVector(const double *data, size_t length)
+{
+	accumulateScalar(data, length);
+}
+
+#endif
+
+size_t SampleStatistics::count() const
+{
+	return m_count;
+}
+
+double SampleStatistics::min() const
+{
+	const double a = (m_min[0] < m_min[1]) ? m_min[0] : m_min[1];
+	const double b = (m_min[2] < m_min[3]) ? m_min[2] : m_min[3];
+
+	return (a < b) ? a : b;
+}
+
+double SampleStatistics::max() const
+{
+	const double a = (m_max[0] > m_max[1]) ? m_max[0] : m_max[1];
+	const double b = (m_max[2] > m_max[3]) ? m_max[2] : m_max[3];
+
+	return (a > b) ? a : b;
+}
+
+double SampleStatistics::sum() const
+{
+	return (m_sum[0] + m_sum[1]) + (m_sum[2] + m_sum[3]);
+}
+
+double SampleStatistics::sqrSum() const
+{
+	return (m_sqr_sum[0] + m_sqr_sum[1]) + (m_sqr_sum[2] + m_sqr_sum[3]);
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SAMPLE_STATISTICS_H
+#define SAMPLE_STATISTICS_H
+
+#include <cstddef>
+
+namespace adiscope {
+
+	/*
+	 * Running min / max / sum / sum of squares over a sample stream,
+	 * skipping NaN samples.
+	 *
+	 * Samples are spread over LANES interleaved accumulators by their
+	 * position in the stream and the lanes are only combined when a
+	 * result is read. The SSE2, AVX and NEON kernels and the scalar
+	 * fallback all follow this exact order, so every build produces
+	 * bit-identical results regardless of the instruction set used.
+	 */
+	class SampleStatistics
+	{
+	public:
+		static const int LANES = 4;
+
+		SampleStatistics();
+
+		void accumulate(const double *data, size_t length);
+		void clear();
+
+		size_t count() const;
+		double min() const;
+		double max() const;
+		double sum() const;
+		double sqrSum() const;
+
+	private:
+		void accumulateScalar(const double *data, size_t length);
+		void accumulateVector(const double *data, size_t length);
+
+		double m_min[LANES];
+		double m_max[LANES];
+		double m_sum[LANES];
+		double m_sqr_sum[LANES];
+		size_t m_count;
+		size_t m_pushed;
+	};
+}
+
+#endif // SAMPLE_STATISTICS_H
@@ -45,6 +45,8 @@
 #include <gnuradio/sync_block.h>
 #include <qapplication.h>
 
+#include "frame_exchange.hpp"
+
 namespace adiscope {
 
     /*!
@@ -68,11 +70,6 @@ namespace adiscope {
      * and maximum values represented in the histogram. It resets any
      * values currently displayed because the location and width of
      * the bins may have changed.
-     *
-     * The histogram also has an accumulate function that simply
-     * accumulates the data between calls to work. When accumulate is
-     * activated, the y-axis autoscaling is turned on by default as
-     * the values will quickly grow in the this direction.
      */
     class histogram_sink_f : virtual public gr::sync_block
     {
@@ -110,6 +107,18 @@ namespace adiscope {
       virtual void set_update_time(double t) = 0;
       virtual void set_nsamps(const int newsize) = 0;
       virtual void set_bins(const int bins) = 0;
+
+      /*!
+       * \brief Only bin the samples in [first, last) of each buffer
+       */
+      virtual void set_data_interval(int first, int last) = 0;
+
+      /*!
+       * \brief Fit the bins to the range of the next buffer
+       */
+      virtual void autoscale_x() = 0;
+
+      virtual const FrameCounters &frame_counters() const = 0;
     };
 
 } /* namespace adiscope */
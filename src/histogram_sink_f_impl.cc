@@ -46,6 +46,8 @@
 #include "histogram_sink_f_impl.h"
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
 
 #include <gnuradio/io_signature.h>
 #include <gnuradio/prefs.h>
@@ -78,15 +80,16 @@ namespace adiscope {
                    io_signature::make(nconnections, nconnections, sizeof(float)),
                    io_signature::make(0, 0, 0)),
 	d_size(size), d_bins(bins), d_xmin(xmin), d_xmax(xmax), d_name(name),
-	d_nconnections(nconnections)
+	d_nconnections(nconnections),
+	d_samples(nconnections, std::vector<float>(size)),
+	d_exchange(std::make_shared<FrameExchange>()),
+	d_histogram(nconnections, bins),
+	d_first(0), d_last(size),
+	d_autoscale_x(false),
+	d_data_min(xmin), d_data_max(xmax)
     {
       d_index = 0;
-
-      for(int i = 0; i < d_nconnections; i++) {
-	d_residbufs.push_back((double*)volk_malloc(d_size*sizeof(double),
-                                                   volk_get_alignment()));
-	memset(d_residbufs[i], 0, d_size*sizeof(double));
-      }
+      _fit_range(xmin, xmax);
 
       // Set alignment properties for VOLK
       const int alignment_multiple =
@@ -99,9 +102,6 @@ namespace adiscope {
 
     histogram_sink_f_impl::~histogram_sink_f_impl()
     {
-      for(int i = 0; i < d_nconnections; i++) {
-	volk_free(d_residbufs[i]);
-      }
     }
 
     bool
@@ -145,13 +145,8 @@ namespace adiscope {
       gr::thread::scoped_lock lock(d_setlock);
 
       if(newsize != d_size) {
-	// Resize residbuf and replace data
 	for(int i = 0; i < d_nconnections; i++) {
-	  volk_free(d_residbufs[i]);
-	  d_residbufs[i] = (double*)volk_malloc(newsize*sizeof(double),
-                                                volk_get_alignment());
-
-	  memset(d_residbufs[i], 0, newsize*sizeof(double));
+	  d_samples[i].assign(newsize, 0.0f);
 	}
 
 	// Set new size and reset buffer index
@@ -160,7 +155,8 @@ namespace adiscope {
 	d_index = 0;
 
       }
-      plot->setDataInterval(0, d_size);
+      d_first = 0;
+      d_last = d_size;
     }
 
     void
@@ -168,9 +164,82 @@ namespace adiscope {
     {
       gr::thread::scoped_lock lock(d_setlock);
       d_bins = bins;
+      d_histogram.configure(d_nconnections, d_bins);
       plot->setNumBins(d_bins);
     }
 
+    void
+    histogram_sink_f_impl::set_data_interval(int first, int last)
+    {
+      gr::thread::scoped_lock lock(d_setlock);
+      d_first = first;
+      d_last = last;
+    }
+
+    void
+    histogram_sink_f_impl::autoscale_x()
+    {
+      d_autoscale_x = true;
+    }
+
+    void
+    histogram_sink_f_impl::_fit_range(double min, double max)
+    {
+      // Something's wrong with the data (NaN, Inf, or something else)
+      if((min == 0 && max == 0) || (min > max)) {
+	// assume some default values
+	min = -0.01;
+	max = 0.01;
+      } else {
+	min = min * (1 - copysign(0.1, min));
+	max = max * (1 + copysign(0.1, max));
+      }
+
+      d_histogram.setRange(min, max);
+    }
+
+    void
+    histogram_sink_f_impl::_bin_buffer()
+    {
+      int first = std::max(d_first, 0);
+      int last = (d_last <= 0 || d_last > d_size) ? d_size : d_last;
+      if(first > last) {
+	first = 0;
+	last = d_size;
+      }
+      const int count = last - first;
+
+      float min = std::numeric_limits<float>::infinity();
+      float max = -std::numeric_limits<float>::infinity();
+      for(int n = 0; n < d_nconnections; n++) {
+	float lo, hi;
+	StreamingHistogram::minMax(&d_samples[n][first], count, lo, hi);
+	min = std::min(min, lo);
+	max = std::max(max, hi);
+      }
+
+      // Fit the bins again when the signal moved, as long as the whole
+      // buffer is looked at
+      const double EPS = 0.1;
+      if(std::abs(min - d_data_min) > EPS || std::abs(max - d_data_max) > EPS) {
+	if(first == 0 && last == d_size) {
+	  d_autoscale_x = true;
+	}
+      }
+      d_data_min = min;
+      d_data_max = max;
+
+      if(d_autoscale_x.exchange(false)) {
+	_fit_range(min, max);
+      } else {
+	d_histogram.clear();
+      }
+
+      for(int n = 0; n < d_nconnections; n++) {
+	d_histogram.add(n, &d_samples[n][first], count);
+      }
+    }
+
     int
     histogram_sink_f_impl::nsamps() const
     {
@@ -189,11 +258,19 @@ namespace adiscope {
       d_index = 0;
     }
 
+    const FrameCounters &
+    histogram_sink_f_impl::frame_counters() const
+    {
+      return d_exchange->counters();
+    }
+
     int
     histogram_sink_f_impl::work(int noutput_items,
 			   gr_vector_const_void_star &input_items,
 			   gr_vector_void_star &output_items)
     {
+      gr::thread::scoped_lock lock(d_setlock);
+
       int n=0, j=0, idx=0;
       const float *in = (const float*)input_items[idx];
 
@@ -205,31 +282,41 @@ namespace adiscope {
 	// If we have enough input for one full plot, do it
 	if(datasize >= resid) {
 
-	  // Fill up residbufs with d_size number of items
+	  // Fill up the buffer with d_size number of items
 	  for(n = 0; n < d_nconnections; n++) {
 	    in = (const float*)input_items[idx++];
-	    volk_32f_convert_64f_u(&d_residbufs[n][d_index],
-				   &in[j], resid);
+	    memcpy(&d_samples[n][d_index], &in[j], resid * sizeof(float));
 	  }
 
-	  // Update the plot if its time
+	  // Only the buffers that get plotted are binned; send the counts
+	  // to the plot if its time
 	  if(gr::high_res_timer_now() - d_last_time > d_update_time) {
 	    d_last_time = gr::high_res_timer_now();
-	    if (d_qApplication)
+	    _bin_buffer();
+
+	    TimeFrame &frame = d_exchange->back(d_nconnections, d_bins);
+	    for(n = 0; n < d_nconnections; n++) {
+	      d_histogram.copyCounts(n, frame.channel(n));
+	    }
+
+	    if (d_exchange->publish(0, d_bins, d_histogram.left(),
+				    d_histogram.binWidth(), d_size)
+			    && d_qApplication)
 	      d_qApplication->postEvent(this->plot,
-				      new HistogramUpdateEvent(d_residbufs, d_size));
+				      new FrameReadyEvent(d_exchange));
+	  } else {
+	    d_exchange->drop();
 	  }
 
 	  d_index = 0;
 	  j += resid;
 	}
-	// Otherwise, copy what we received into the residbufs for next time
+	// Otherwise, copy what we received into the buffer for next time
 	// because we set the output_multiple, this should never need to be called
 	else {
 	  for(n = 0; n < d_nconnections; n++) {
 	    in = (const float*)input_items[idx++];
-	    volk_32f_convert_64f_u(&d_residbufs[n][d_index],
-				   &in[j], datasize);
+	    memcpy(&d_samples[n][d_index], &in[j], datasize * sizeof(float));
 	  }
 	  d_index += datasize;
 	  j += datasize;
@@ -42,9 +42,11 @@
 #ifndef M2K_HISTOGRAM_SINK_F_IMPL_H
 #define M2K_HISTOGRAM_SINK_F_IMPL_H
 
+#include <atomic>
 #include <gnuradio/high_res_timer.h>
 
 #include "histogram_sink_f.h"
+#include "streaming_histogram.hpp"
 #include "HistogramDisplayPlot.h"
 
 namespace adiscope {
@@ -61,10 +63,20 @@ namespace adiscope {
       int d_nconnections;
 
       int d_index;
-      std::vector<double*> d_residbufs;
+      std::vector<std::vector<float>> d_samples;
+      std::shared_ptr<FrameExchange> d_exchange;
+
+      // Binning happens here, the plot only gets the counts
+      StreamingHistogram d_histogram;
+      int d_first, d_last;
+      std::atomic<bool> d_autoscale_x;
+      double d_data_min, d_data_max;
 
       HistogramDisplayPlot *plot;
 
+      void _bin_buffer();
+      void _fit_range(double min, double max);
+
       gr::high_res_timer_type d_update_time;
       gr::high_res_timer_type d_last_time;
 
@@ -84,10 +96,15 @@ namespace adiscope {
       void set_nsamps(const int newsize);
       void set_bins(const int bins);
 
+      void set_data_interval(int first, int last);
+      void autoscale_x();
+
       int  nsamps() const;
       int  bins() const;
       void reset();
 
+      const FrameCounters &frame_counters() const;
+
       int work(int noutput_items,
 	       gr_vector_const_void_star &input_items,
 	       gr_vector_void_star &output_items);
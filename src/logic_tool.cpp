@@ -28,12 +28,20 @@ adiscope::logic::LogicTool::LogicTool(iio_context *ctx, adiscope::ToolMenuItem *
                                       adiscope::ApiObject *api, const QString &name,
                                       adiscope::ToolLauncher *parent)
         : Tool(ctx, toolMenuItem, api, name, parent)
-        , m_buffer(nullptr)
 {
+	// Connected before any of the curves so that the edges of a chunk
+	// are found once, in the capture thread, before they are drawn
+	connect(this, &LogicTool::dataAvailable, this, [=](uint64_t from, uint64_t to){
+		m_edges.extract(m_capture, from, to);
+	}, Qt::DirectConnection);
+}
 
+const CaptureStore &LogicTool::getCapture() const
+{
+	return m_capture;
 }
 
-uint16_t *LogicTool::getData()
+const EdgeExtractor &LogicTool::getEdges() const
 {
-	return m_buffer;
+	return m_edges;
 }
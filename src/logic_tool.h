@@ -24,6 +24,9 @@
 
 #include "tool.hpp"
 
+#include "logicanalyzer/capturestore.h"
+#include "logicanalyzer/edgeextractor.h"
+
 namespace adiscope {
 namespace logic {
 class LogicTool : public Tool
@@ -35,13 +38,19 @@ public:
 	          ToolLauncher *parent);
 	virtual ~LogicTool() = default;
 
-	uint16_t *getData();
+	const CaptureStore &getCapture() const;
+
+	/* Edges of every channel of the capture, updated before the curves */
+	const EdgeExtractor &getEdges() const;
 
 Q_SIGNALS:
 	void dataAvailable(uint64_t, uint64_t);
 
 protected:
-	uint16_t *m_buffer;
+	CaptureStore m_capture;
+
+private:
+	EdgeExtractor m_edges;
 };
 } // namespace logic
 } // namespace adiscope
@@ -39,31 +39,15 @@
 
 
 #include "annotation.h"
-#include <cassert>
 
-extern "C" {
-#include <libsigrokdecode/libsigrokdecode.h>
-}
-
-#include <vector>
-
-Annotation::Annotation(const srd_proto_data *const pdata, const Row *row) :
-    start_sample_(pdata->start_sample),
-    end_sample_(pdata->end_sample),
+Annotation::Annotation(uint64_t start_sample, uint64_t end_sample,
+                       const std::shared_ptr<const Text> &text,
+                       const Row *row) :
+    start_sample_(start_sample),
+    end_sample_(end_sample),
+    text_(text),
     row_(row)
 {
-    assert(pdata);
-    const srd_proto_data_annotation *const pda =
-        (const srd_proto_data_annotation*)pdata->data;
-    assert(pda);
-
-    ann_class_ = (Class)(pda->ann_class);
-
-    const char *const *annotations = (char**)pda->ann_text;
-    while (*annotations) {
-        annotations_.push_back(QString::fromUtf8(*annotations));
-        annotations++;
-    }
 }
 
 uint64_t Annotation::start_sample() const
@@ -78,12 +62,14 @@ uint64_t Annotation::end_sample() const
 
 Annotation::Class Annotation::ann_class() const
 {
-    return ann_class_;
+    return text_ ? text_->ann_class : 0;
 }
 
 const vector<QString>& Annotation::annotations() const
 {
-    return annotations_;
+    static const vector<QString> none;
+
+    return text_ ? text_->annotations : none;
 }
 
 const Row* Annotation::row() const
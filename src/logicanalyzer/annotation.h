@@ -42,24 +42,35 @@
 #define ANNOTATION_H
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #include <QString>
 
-struct srd_proto_data;
 class Row;
 
 using std::vector;
 
+/*
+ * One decoded annotation. RowData stores annotations in columns and
+ * builds these on demand; the class and texts are shared by all the
+ * annotations of a row that have the same ones.
+ */
 class Annotation
 {
 public:
     typedef uint32_t Class;
 
+    struct Text {
+        Class ann_class;
+        vector<QString> annotations;
+    };
+
 public:
     Annotation() = default;
     Annotation(const Annotation &other) = default;
-    Annotation(const srd_proto_data *const pdata, const Row *row);
+    Annotation(uint64_t start_sample, uint64_t end_sample,
+               const std::shared_ptr<const Text> &text, const Row *row);
 
     uint64_t start_sample() const;
     uint64_t end_sample() const;
@@ -72,8 +83,7 @@ public:
 private:
     uint64_t start_sample_;
     uint64_t end_sample_;
-    Class ann_class_;
-    vector<QString> annotations_;
+    std::shared_ptr<const Text> text_;
     const Row *row_;
 
 };
@@ -178,6 +178,8 @@ void AnnotationCurve::newAnnotations()
 {
     QMetaObject::invokeMethod(plot(), "replot");
     state = 1;
+
+    Q_EMIT throughputChanged(m_annotationDecoder->getThroughput());
 }
 
 void AnnotationCurve::reset()
@@ -855,10 +857,13 @@ void AnnotationCurve::drawOneSampleAnnotation(int row, const Annotation &ann, QP
 
 AnnotationQueryResult AnnotationCurve::annotationAt(const QPointF& p) const
 {
-    if (m_visibleRows == 0) return {0, nullptr};
+    if (m_visibleRows == 0) return {0, Annotation(), false};
+
+    // The decoder thread may be adding annotations
+    std::unique_lock<std::mutex> lock(m_mutex);
 
     const auto plt = plot();
-    if (plt == nullptr) return {0, nullptr};
+    if (plt == nullptr) return {0, Annotation(), false};
     const uint64_t sample = fromTimeToSample(p.x());
 
     const auto &ymap = plt->canvasMap(yAxis().pos);
@@ -881,23 +886,31 @@ AnnotationQueryResult AnnotationCurve::annotationAt(const QPointF& p) const
 			    continue;
 		    }
 		    if (y < minY or y > maxY) continue;
-		    uint64_t prev_end_sample = 0, next_start_sample = 0;
-		    for (uint64_t i = 0; i < data.size(); i++) {
-			    const Annotation *ann = data.annAt(i);
+
+		    // Only the annotations around the sample can be hit
+		    uint64_t first, last;
+		    std::tie(first, last) = data.get_annotation_subset(
+				    sample > 0 ? sample - 1 : 0, sample);
+
+		    uint64_t prev_end_sample = first > 0 ? data.end_sample(first - 1) : 0;
+		    uint64_t next_start_sample = 0;
+		    for (uint64_t i = first; i <= last && i < data.size(); i++) {
+			    const uint64_t start_sample = data.start_sample(i);
+			    const uint64_t end_sample = data.end_sample(i);
 			    next_start_sample = (i + 1 == data.size()) ? sample + (sample - prev_end_sample)/2
-								       : data.annAt(i + 1)->start_sample();
-			    if (ann->end_sample() - ann->start_sample() < 2 &&
-					    sample + (sample - prev_end_sample)/2 >= ann->start_sample() and sample - (next_start_sample - sample)/2 <= ann->end_sample()) {
-				    return {i, ann};
+								       : data.start_sample(i + 1);
+			    if (end_sample - start_sample < 2 &&
+					    sample + (sample - prev_end_sample)/2 >= start_sample and sample - (next_start_sample - sample)/2 <= end_sample) {
+				    return {i, data.getAnnAt(i), true};
 			    }
-			    if (sample >= ann->start_sample() and sample <= ann->end_sample()) {
-				    return {i, ann};
+			    if (sample >= start_sample and sample <= end_sample) {
+				    return {i, data.getAnnAt(i), true};
 			    }
-			    prev_end_sample = ann->end_sample();
+			    prev_end_sample = end_sample;
 		    }
 	    }
     }
-    return {0, nullptr};
+    return {0, Annotation(), false};
 }
 
 bool AnnotationCurve::testHit(const QPointF& p) const
@@ -57,8 +57,9 @@ class AnnotationDecoder;
 
 struct AnnotationQueryResult {
     uint64_t index;
-    const Annotation* ann;
-    inline bool isValid() const { return ann != nullptr; }
+    Annotation ann;
+    bool valid;
+    inline bool isValid() const { return valid; }
 };
 
 class AnnotationCurve : public GenericLogicPlotCurve
@@ -74,6 +75,9 @@ Q_SIGNALS:
     // Emitted when an annotation is clicked
     void annotationClicked(AnnotationQueryResult result);
 
+    // Emitted from the decoding thread after every decoded chunk
+    void throughputChanged(double samplesPerSecond);
+
 public:
     static void annotationCallback(srd_proto_data *pdata, void *annotationCurve);
 
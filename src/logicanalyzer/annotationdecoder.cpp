@@ -24,6 +24,7 @@
 #include "logic_analyzer.h"
 #include <QDebug>
 #include <algorithm>
+#include <chrono>
 
 using namespace adiscope;
 
@@ -77,6 +78,7 @@ AnnotationDecoder::AnnotationDecoder(AnnotationCurve *annotationCurve, std::shar
     , m_srdSession(nullptr)
     , m_logic(logic)
     , m_decodeCanceled(false)
+    , m_throughput(0)
     , m_lastSample(0)
 {
     // 1. Get stacked decoder from annotation Curve
@@ -212,10 +214,14 @@ void AnnotationDecoder::startDecode()
     }
 
 
-    if (srd_session_start(m_srdSession) != SRD_OK) {
-	qDebug() << "srd_session_start returned error!";
-    } else {
-//        qDebug() << "srd_session_start returned SRD_OK";
+    {
+        std::lock_guard<std::mutex> srd_lock(g_sessionMutex);
+
+        if (srd_session_start(m_srdSession) != SRD_OK) {
+	    qDebug() << "srd_session_start returned error!";
+        } else {
+//            qDebug() << "srd_session_start returned SRD_OK";
+        }
     }
 
     if (m_decodeThread) {
@@ -456,8 +462,18 @@ void AnnotationDecoder::stackChanged()
                                AnnotationCurve::annotationCallback, m_annotationCurve);
 }
 
+double AnnotationDecoder::getThroughput() const
+{
+    return m_throughput;
+}
+
 void AnnotationDecoder::decodeProc()
 {
+    uint64_t decodedSamples = 0;
+    std::chrono::steady_clock::duration decodeTime(0);
+
+    m_throughput = 0;
+
     while (!m_decodeCanceled) {
 
         std::unique_lock<std::mutex> lock(m_newDataMutex);
@@ -491,23 +507,36 @@ void AnnotationDecoder::decodeProc()
         m_newDataQueue.pop();
         lock.unlock(); // unlock to allow new data to enter the queue
 
-        uint64_t chunkSize = stop - start;
-        std::unique_ptr<uint16_t []> chunk(new uint16_t[chunkSize]);
+        // Decode the samples a slice at a time, so that a long capture
+        // is never held uncompressed in memory
+        const uint64_t sliceSize = std::min(stop - start, MAX_CHUNK_SIZE);
+        std::unique_ptr<uint16_t []> slice(new uint16_t[sliceSize]);
 
-        uint16_t *data = m_logic->getData();
+        for (uint64_t from = start; from < stop; from += sliceSize) {
+            const uint64_t count = std::min(stop - from, sliceSize);
 
-	if (!data) {
-		continue;
-	}
+            if (m_logic->getCapture().read(from, count, slice.get()) != count) {
+                break;
+            }
 
-        memcpy(chunk.get(), data + start, chunkSize * sizeof(uint16_t));
+//            qDebug() << "send data!";
+            // No global lock here: libsigrokdecode takes the Python GIL
+            // only while the decoders run, so the other stacks can decode
+            // their own sessions in the meantime
+            const auto sendStart = std::chrono::steady_clock::now();
 
-//        qDebug() << "send data!";
-        std::lock_guard<std::mutex> srd_lock(g_sessionMutex);
+            if (srd_session_send(m_srdSession, from, from + count, reinterpret_cast<uint8_t*>(
+                                     slice.get()), count, sizeof(uint16_t)) != SRD_OK) {
+//                qDebug() << "No bueno!";
+            }
+
+            decodeTime += std::chrono::steady_clock::now() - sendStart;
+            decodedSamples += count;
+        }
 
-        if (srd_session_send(m_srdSession, start, stop, reinterpret_cast<uint8_t*>(
-                                 chunk.get()), chunkSize, sizeof(uint16_t)) != SRD_OK) {
-//            qDebug() << "No bueno!";
+        const double seconds = std::chrono::duration<double>(decodeTime).count();
+        if (seconds > 0) {
+            m_throughput = decodedSamples / seconds;
         }
 
         // Notify curve that annotations are now available to be drawn on the plot
@@ -63,6 +63,9 @@ public:
     void reset();
 
     int getNrOfChannels() const;
+
+    // Samples decoded per second of decoding since the decode started
+    double getThroughput() const;
 private:
     void stackChanged();
 
@@ -83,8 +86,11 @@ private:
 
     std::thread *m_decodeThread;
     std::atomic<bool> m_decodeCanceled;
+    std::atomic<double> m_throughput;
     std::mutex m_newDataMutex;
     std::condition_variable m_newDataCv;
+    // Only guards creating, starting and destroying sessions; each
+    // stack decodes in its own thread, in parallel with the others
     static std::mutex g_sessionMutex;
     std::queue<std::pair<uint64_t, uint64_t>> m_newDataQueue;
     void initDecoderChannels();
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "capturestore.h"
+
+#include <string.h>
+
+using namespace adiscope::logic;
+
+const uint64_t CaptureStore::CHUNK_SIZE;
+
+CaptureStore::CaptureStore()
+	: m_size(0)
+{
+}
+
+void CaptureStore::reset()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_chunks.clear();
+	m_size = 0;
+}
+
+void CaptureStore::append(const uint16_t *data, uint64_t count)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	while (count) {
+		const uint64_t offset = m_size % CHUNK_SIZE;
+
+		if (offset == 0) {
+			m_chunks.emplace_back();
+			m_chunks.back().values.reserve(CHUNK_SIZE);
+		}
+
+		Chunk &chunk = m_chunks.back();
+		const uint64_t n = std::min(count, CHUNK_SIZE - offset);
+
+		chunk.values.insert(chunk.values.end(), data, data + n);
+		data += n;
+		count -= n;
+		m_size += n;
+
+		if (offset + n == CHUNK_SIZE) {
+			encode(chunk);
+		}
+	}
+}
+
+void CaptureStore::assign(const uint16_t *data, uint64_t count)
+{
+	reset();
+	append(data, count);
+}
+
+uint64_t CaptureStore::size() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_size;
+}
+
+void CaptureStore::encode(Chunk &chunk)
+{
+	const std::vector<uint16_t> &samples = chunk.values;
+	uint64_t runs = 1;
+
+	for (uint64_t i = 1; i < samples.size(); i++) {
+		runs += samples[i] != samples[i - 1];
+	}
+
+	// A run costs two words, keep the raw samples if they are smaller
+	if (runs * 2 >= samples.size()) {
+		return;
+	}
+
+	std::vector<uint16_t> values;
+	std::vector<uint16_t> ends;
+	values.reserve(runs);
+	ends.reserve(runs);
+
+	for (uint64_t i = 0; i < samples.size(); i++) {
+		if (i + 1 == samples.size() || samples[i + 1] != samples[i]) {
+			values.push_back(samples[i]);
+			ends.push_back(i);
+		}
+	}
+
+	chunk.values.swap(values);
+	chunk.ends.swap(ends);
+}
+
+uint64_t CaptureStore::runAt(const Chunk &chunk, uint64_t offset)
+{
+	return std::lower_bound(chunk.ends.begin(), chunk.ends.end(), offset)
+		- chunk.ends.begin();
+}
+
+uint16_t CaptureStore::at(uint64_t sample) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (sample >= m_size) {
+		return 0;
+	}
+
+	const Chunk &chunk = m_chunks[sample / CHUNK_SIZE];
+	const uint64_t offset = sample % CHUNK_SIZE;
+
+	if (chunk.ends.empty()) {
+		return chunk.values[offset];
+	}
+
+	return chunk.values[runAt(chunk, offset)];
+}
+
+uint64_t CaptureStore::read(uint64_t from, uint64_t count, uint16_t *out) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (from >= m_size) {
+		return 0;
+	}
+
+	count = std::min(count, m_size - from);
+
+	const uint64_t to = from + count;
+
+	while (from < to) {
+		const Chunk &chunk = m_chunks[from / CHUNK_SIZE];
+		const uint64_t offset = from % CHUNK_SIZE;
+		const uint64_t n = std::min(to - from, CHUNK_SIZE - offset);
+
+		if (chunk.ends.empty()) {
+			memcpy(out, chunk.values.data() + offset, n * sizeof(uint16_t));
+		} else {
+			uint64_t run = runAt(chunk, offset);
+			uint64_t i = offset;
+
+			while (i < offset + n) {
+				const uint64_t end = std::min<uint64_t>(chunk.ends[run] + 1, offset + n);
+				std::fill(out + (i - offset), out + (end - offset), chunk.values[run]);
+				i = end;
+				run++;
+			}
+		}
+
+		out += n;
+		from += n;
+	}
+
+	return count;
+}
+
+/* Runs of [from, to), both in the same chunk */
+void CaptureStore::chunkRuns(uint64_t from, uint64_t to, std::vector<Run> &runs) const
+{
+	const Chunk &chunk = m_chunks[from / CHUNK_SIZE];
+	const uint64_t base = from - from % CHUNK_SIZE;
+
+	runs.clear();
+
+	if (chunk.ends.empty()) {
+		const uint16_t *samples = chunk.values.data();
+		const uint64_t last = to - base;
+		uint64_t start = from - base;
+
+		for (uint64_t i = start + 1; i <= last; i++) {
+			if (i == last || samples[i] != samples[start]) {
+				runs.push_back({base + start, base + i, samples[start]});
+				start = i;
+			}
+		}
+	} else {
+		for (uint64_t run = runAt(chunk, from - base); from < to; run++) {
+			const uint64_t end = std::min(base + chunk.ends[run] + 1, to);
+			runs.push_back({from, end, chunk.values[run]});
+			from = end;
+		}
+	}
+}
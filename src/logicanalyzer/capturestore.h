@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CAPTURESTORE_H
+#define CAPTURESTORE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace adiscope {
+namespace logic {
+
+/*
+ * Samples of a logic capture, kept in chunks of CHUNK_SIZE samples. Every
+ * chunk that gets filled is run-length encoded when this takes less room
+ * than the raw samples, so long captures of slow signals only cost a few
+ * bytes per transition instead of 2 bytes per sample.
+ *
+ * Samples are appended by the acquisition thread while the curves,
+ * decoders and exports read them, so every method takes the internal lock.
+ */
+class CaptureStore
+{
+public:
+	static const uint64_t CHUNK_SIZE = 4096;
+
+	CaptureStore();
+
+	void reset();
+	void append(const uint16_t *data, uint64_t count);
+	void assign(const uint16_t *data, uint64_t count);
+
+	uint64_t size() const;
+
+	/* Returns 0 for samples that were not captured */
+	uint16_t at(uint64_t sample) const;
+
+	/*
+	 * Copies the samples [from, from + count) to out and returns how
+	 * many of them were captured.
+	 */
+	uint64_t read(uint64_t from, uint64_t count, uint16_t *out) const;
+
+	/*
+	 * Calls fn(start, end, value) for every run of equal samples in
+	 * [from, to), in order; consecutive runs may hold the same value.
+	 * The lock is not held while fn runs.
+	 */
+	template<typename F>
+	void forEachRun(uint64_t from, uint64_t to, F fn) const;
+
+private:
+	struct Chunk {
+		// The raw samples, or the value of every run when
+		// ends is not empty
+		std::vector<uint16_t> values;
+		// Offset in the chunk of the last sample of every run
+		std::vector<uint16_t> ends;
+	};
+
+	struct Run {
+		uint64_t start;
+		uint64_t end;
+		uint16_t value;
+	};
+
+	static void encode(Chunk &chunk);
+	static uint64_t runAt(const Chunk &chunk, uint64_t offset);
+	void chunkRuns(uint64_t from, uint64_t to, std::vector<Run> &runs) const;
+
+	std::vector<Chunk> m_chunks;
+	uint64_t m_size;
+	mutable std::mutex m_mutex;
+};
+
+template<typename F>
+void CaptureStore::forEachRun(uint64_t from, uint64_t to, F fn) const
+{
+	std::vector<Run> runs;
+
+	while (from < to) {
+		const uint64_t chunkEnd = std::min(to, (from / CHUNK_SIZE + 1) * CHUNK_SIZE);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			if (from >= m_size) {
+				return;
+			}
+
+			chunkRuns(from, std::min(chunkEnd, m_size), runs);
+		}
+
+		for (const Run &run : runs) {
+			fn(run.start, run.end, run.value);
+		}
+
+		from = chunkEnd;
+	}
+}
+
+} // namespace logic
+} // namespace adiscope
+
+#endif // CAPTURESTORE_H
@@ -226,7 +226,7 @@ bool DecoderTable::exportCsv(QString fileName)
 		last_sample = std::max(last_sample, it->second.get_max_sample());
 
 		auto title = curve->fromTitleToRowType(it->first.title());
-		if (!it->second.get_annotations().empty() && !tableModel->getFiltered()[col].contains(title)) {
+		if (it->second.size() && !tableModel->getFiltered()[col].contains(title)) {
 			if (it->first.index() == tableModel->getPrimaryAnnotationIndex()) {
 				primaryCol = columnNames.size();
 			}
@@ -53,7 +53,7 @@ void DecoderTableModel::setDefaultPrimaryAnnotations()
 		std::map<Row, RowData> decoder(curve->getAnnotationRows());
 
 		for (it = decoder.begin(); it != decoder.end(); it++) {
-			if (!it->second.get_annotations().empty()) {
+			if (it->second.size()) {
 				count = it->first.index();
 				break;
 			}
@@ -254,7 +254,7 @@ void DecoderTableModel::refreshColumn(double column) const
 	std::map<Row, RowData> decoder(curve->getAnnotationRows());
 
 	for (it = decoder.begin(); it != decoder.end(); it++) {
-		if (!it->second.get_annotations().empty()) {
+		if (it->second.size()) {
 			row_count ++;
 		}
 	}
@@ -316,7 +316,7 @@ void DecoderTableModel::populateFilter(int index) const
 					     [row](const std::pair<const Row, RowData> &t) -> bool{
 			return t.first.index() == row;
 		});
-		if (!row_map.second.get_annotations().empty()) {
+		if (row_map.second.size()) {
 			count ++;
 			m_logic->addFilterRow(QIcon(), temp_curve->fromTitleToRowType(row_map.first.title()));
 		}
@@ -454,7 +454,7 @@ void DecoderTableModel::searchTable(QString text)
 			row_index++;
 
 			for (auto row_map: decoder) {
-				if (row_map.second.get_annotations().empty()) continue;
+				if (!row_map.second.size()) continue;
 				QString title = temp_curve->fromTitleToRowType(row_map.first.title());
 				if (m_filteredMessages.value(m_current_column).contains(title)) continue;
 
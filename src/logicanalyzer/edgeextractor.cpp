@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "edgeextractor.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define EDGE_EXTRACTOR_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define EDGE_EXTRACTOR_NEON
+#endif
+
+using namespace adiscope::logic;
+
+const int EdgeExtractor::CHANNELS;
+
+/* Samples compared at once before looking for the channels that changed */
+static const uint64_t BLOCK = 32;
+
+/* Samples decoded from the capture at once */
+static const uint64_t SLICE = 64 * 1024;
+
+void EdgeExtractor::reset()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (int i = 0; i < CHANNELS; i++) {
+		m_edges[i].clear();
+	}
+}
+
+const EdgeExtractor::Edges &EdgeExtractor::edges(uint8_t channel) const
+{
+	return m_edges[channel];
+}
+
+std::mutex &EdgeExtractor::mutex() const
+{
+	return m_mutex;
+}
+
+void EdgeExtractor::extract(const CaptureStore &capture, uint64_t from, uint64_t to)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (from == 0) {
+		for (int i = 0; i < CHANNELS; i++) {
+			m_edges[i].clear();
+		}
+	}
+
+	// Take into account the transition between the last sample of the
+	// previous chunk and the first one of this chunk
+	uint64_t first = from > 0 ? from - 1 : 0;
+
+	// The samples are decoded a slice at a time, each slice starting
+	// with the last sample of the previous one
+	while (first + 1 < to) {
+		const uint64_t count = std::min(to - first, SLICE);
+
+		m_samples.resize(count);
+		if (capture.read(first, count, m_samples.data()) != count) {
+			break;
+		}
+
+		scan(m_samples.data(), first, count - 1);
+		first += count - 1;
+	}
+}
+
+/*
+ * Looks for the transitions from data[i] to data[i + 1], i in [0, count),
+ * data[0] being the sample first of the capture
+ */
+void EdgeExtractor::scan(const uint16_t *data, uint64_t first, uint64_t count)
+{
+	uint64_t i = 0;
+
+#if defined(EDGE_EXTRACTOR_SSE2)
+	for (; i + BLOCK <= count; i += BLOCK) {
+		__m128i changed = _mm_setzero_si128();
+
+		for (uint64_t j = i; j < i + BLOCK; j += 8) {
+			const __m128i a = _mm_loadu_si128((const __m128i *)(data + j));
+			const __m128i b = _mm_loadu_si128((const __m128i *)(data + j + 1));
+			changed = _mm_or_si128(changed, _mm_xor_si128(a, b));
+		}
+
+		const __m128i same = _mm_cmpeq_epi16(changed, _mm_setzero_si128());
+		if (_mm_movemask_epi8(same) != 0xffff) {
+			extractWords(data, first, i, i + BLOCK);
+		}
+	}
+#elif defined(EDGE_EXTRACTOR_NEON)
+	for (; i + BLOCK <= count; i += BLOCK) {
+		uint16x8_t changed = vdupq_n_u16(0);
+
+		for (uint64_t j = i; j < i + BLOCK; j += 8) {
+			changed = vorrq_u16(changed, veorq_u16(vld1q_u16(data + j),
+							      vld1q_u16(data + j + 1)));
+		}
+
+		if (vmaxvq_u16(changed)) {
+			extractWords(data, first, i, i + BLOCK);
+		}
+	}
+#endif
+
+	extractWords(data, first, i, count);
+}
+
+void EdgeExtractor::extractWords(const uint16_t *data, uint64_t first,
+				 uint64_t begin, uint64_t end)
+{
+	for (uint64_t i = begin; i < end; i++) {
+		unsigned int changed = data[i] ^ data[i + 1];
+
+		for (int bit = 0; changed; bit++, changed >>= 1) {
+			if (changed & 1) {
+				m_edges[bit].emplace_back(first + i, (data[i] >> bit) & 1);
+			}
+		}
+	}
+}
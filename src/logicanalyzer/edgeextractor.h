@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EDGEEXTRACTOR_H
+#define EDGEEXTRACTOR_H
+
+#include "capturestore.h"
+
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace adiscope {
+namespace logic {
+
+/*
+ * Transitions of every channel of a logic capture, found in a single
+ * pass over the 16 bit samples as they arrive. Runs of samples where no
+ * channel changes are skipped a vector at a time; only the words that
+ * differ from the next one are looked at bit by bit.
+ *
+ * An edge is stored as the sample it follows and the level before it:
+ * false -> ,,|'' true -> ''|,,
+ */
+class EdgeExtractor
+{
+public:
+	typedef std::vector<std::pair<uint64_t, bool>> Edges;
+
+	static const int CHANNELS = 16;
+
+	/*
+	 * Adds the edges of the samples [from, to) of the capture, from
+	 * being 0 for a new one. Runs in the acquisition thread.
+	 */
+	void extract(const CaptureStore &capture, uint64_t from, uint64_t to);
+	void reset();
+
+	/* The edges of a channel, only to be read with mutex() held */
+	const Edges &edges(uint8_t channel) const;
+	std::mutex &mutex() const;
+
+private:
+	void scan(const uint16_t *data, uint64_t first, uint64_t count);
+	void extractWords(const uint16_t *data, uint64_t first, uint64_t begin,
+			  uint64_t end);
+
+	Edges m_edges[CHANNELS];
+	std::vector<uint16_t> m_samples;
+	mutable std::mutex m_mutex;
+};
+
+} // namespace logic
+} // namespace adiscope
+
+#endif // EDGEEXTRACTOR_H
@@ -285,11 +285,6 @@ LogicAnalyzer::~LogicAnalyzer()
 		delete curve;
 	}
 
-	if (m_buffer) {
-		delete[] m_buffer;
-		m_buffer = nullptr;
-	}
-
 	delete cr_ui;
 	delete ui;
 }
@@ -305,14 +300,7 @@ void LogicAnalyzer::setData(const uint16_t * const data, int size)
 
 	qDebug() << "Set data arrived: ";
 
-	if (m_buffer) {
-		delete m_buffer;
-		m_buffer = nullptr;
-	}
-
-	m_buffer = new uint16_t[size];
-
-	memcpy(m_buffer, data, size * sizeof(uint16_t));
+	m_capture.assign(data, size);
 	Q_EMIT dataAvailable(0, size);
 
 //	if (m_oscPlot) {
@@ -578,6 +566,11 @@ std::vector<QWidget *> LogicAnalyzer::enableMixedSignalView(CapturePlot *osc, in
 		decoderBox->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
 		layout->addWidget(decoderBox);
 
+		connect(curve, &AnnotationCurve::throughputChanged, decoderBox, [=](double samplesPerSecond){
+			decoderBox->setToolTip(tr("Decoding at ") +
+					       MetricPrefixFormatter().format(samplesPerSecond, "Sa/s", 2));
+		});
+
 		QPushButton *deleteBtn = new QPushButton(this);
 		deleteBtn->setFlat(true);
 		deleteBtn->setIcon(QIcon(":/icons/close_hovered.svg"));
@@ -1529,7 +1522,7 @@ bool LogicAnalyzer::setPrimaryAnntations(int column, int index)
 			return t.first.index() == row;
 		});
 
-		if (!it->second.get_annotations().empty()) {
+		if (it->second.size()) {
 			auto title = curve->fromTitleToRowType(it->first.title());
 			ui->primaryAnnotationComboBox->addItem(title, it->first.index());
 		}
@@ -2127,12 +2120,6 @@ void LogicAnalyzer::startStop(bool start)
 
 		m_captureThread = new std::thread([=](){
 
-			if (m_buffer) {
-				delete[] m_buffer;
-				m_buffer = nullptr;
-			}
-
-			m_buffer = new uint16_t[bufferSizeAdjusted];
 			QMetaObject::invokeMethod(this, [=](){
 				m_exportSettings->enableExportButton(true);
 			}, Qt::DirectConnection);
@@ -2240,7 +2227,13 @@ void LogicAnalyzer::startStop(bool start)
 					}
 
 					const uint16_t * const temp = m_m2kDigital->getSamplesP(chunk_size);
-					memcpy(m_buffer + absIndex, temp, sizeof(uint16_t) * captureSize);
+
+					// A new buffer starts, drop the previous one
+					if (absIndex == 0) {
+						m_capture.reset();
+					}
+
+					m_capture.append(temp, captureSize);
 
 					absIndex += captureSize;
 					totalSamples -= captureSize;
@@ -2437,6 +2430,11 @@ void LogicAnalyzer::setupDecoders()
 		decoderBox->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
 		layout->addWidget(decoderBox);
 
+		connect(curve, &AnnotationCurve::throughputChanged, decoderBox, [=](double samplesPerSecond){
+			decoderBox->setToolTip(tr("Decoding at ") +
+					       MetricPrefixFormatter().format(samplesPerSecond, "Sa/s", 2));
+		});
+
 		QPushButton *deleteBtn = new QPushButton(this);
 		deleteBtn->setFlat(true);
 		deleteBtn->setIcon(QIcon(":/icons/close_hovered.svg"));
@@ -2525,7 +2523,7 @@ void LogicAnalyzer::setupDecoders()
 			const auto col = model->indexOfCurve(curve);
 			ui->DecoderComboBox->setCurrentIndex(col);
 
-			std::string title = result.ann->row()->title().toStdString();
+			std::string title = result.ann.row()->title().toStdString();
 			title = title.erase(0, title.find(':') + 1);
 
 			int row_index = ui->primaryAnnotationComboBox->findText(QString::fromStdString(title));
@@ -2939,11 +2937,10 @@ bool LogicAnalyzer::exportTabCsv(const QString &separator, const QString &fileNa
 
 	QVector<QVector<double>> data;
 
-	if (!m_buffer) {
+	if (!m_capture.size()) {
 		return false;
 	} else {
-		for (unsigned int i = 0; i < m_lastCapturedSample; ++i) {
-			uint64_t sample = m_buffer[i];
+		m_capture.forEachRun(0, m_lastCapturedSample, [&](uint64_t start, uint64_t end, uint16_t sample) {
 			QVector<double> line;
 			for (unsigned int ch = 0; ch < DIGITAL_NR_CHANNELS; ++ch) {
 				int bit = (sample >> ch) & 1;
@@ -2951,8 +2948,10 @@ bool LogicAnalyzer::exportTabCsv(const QString &separator, const QString &fileNa
 					line.push_back(bit);
 				}
 			}
-			data.push_back(line);
-		}
+			for (uint64_t i = start; i < end; ++i) {
+				data.push_back(line);
+			}
+		});
 	}
 
 	fm.setSampleRate(m_sampleRate);
@@ -3088,13 +3087,13 @@ bool LogicAnalyzer::exportVcd(const QString &fileName, const QString &startSep,
 	out << startSep << "enddefinitions" << endSep;
 
 	/* Write the values */
-	if (m_buffer) {
-		for (uint64_t i = 0; i < m_lastCapturedSample; i++) {
-			current_sample = m_buffer[i];
+	if (m_capture.size()) {
+		// Nothing changes inside a run, only its first sample is written
+		prev_sample = 0;
+		m_capture.forEachRun(0, m_lastCapturedSample, [&](uint64_t i, uint64_t, uint16_t sample) {
+			current_sample = sample;
 			if (i == 0) {
 				prev_sample = current_sample;
-			} else {
-				prev_sample = m_buffer[i - 1];
 			}
 			timestamp_written = false;
 			p = 0;
@@ -3120,7 +3119,8 @@ bool LogicAnalyzer::exportVcd(const QString &fileName, const QString &startSep,
 			if (timestamp_written) {
 				out << "\n";
 			}
-		}
+			prev_sample = current_sample;
+		});
 	} else {
 		file.close();
 		return false;
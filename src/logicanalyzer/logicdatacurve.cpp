@@ -64,33 +64,13 @@ void LogicDataCurve::dataAvailable(uint64_t from, uint64_t to)
 	    reset();
     }
 
-    m_data = m_logic->getData();
-
-    // Take into account the last pushed edge from the previous chunk of
-    // available data
-    uint64_t currentSample = from;
-    if (from > 0) {
-	    currentSample--;
-    }
-
-    if (from == to) {
-	    return;
-    }
-
-    for (; currentSample < to - 1; ++currentSample) {
-        bool transition = (m_data[currentSample] & (1 << m_bit)) ^ (m_data[currentSample + 1] & (1 << m_bit));
-        bool high = (m_data[currentSample] & (1 << m_bit)) > (m_data[currentSample + 1] & (1 << m_bit));
-        if (transition) {
-            m_edges.emplace_back(currentSample, high);
-        }
-    }
-
+    // The edges of the chunk were already extracted, for every
+    // channel at once, by the logic tool
     m_endSample = to;
 }
 
 void LogicDataCurve::reset()
 {
-	m_edges.clear();
 	m_startSample = 0;
 	m_endSample = 0;
 }
@@ -111,6 +91,14 @@ void LogicDataCurve::drawLines(QPainter *painter, const QwtScaleMap &xMap,
 {
 	std::unique_lock<std::mutex> lock(m_dataAvailableMutex);
 
+	if (m_startSample == m_endSample) {
+		return;
+	}
+
+	const adiscope::logic::EdgeExtractor &extractor = m_logic->getEdges();
+	std::unique_lock<std::mutex> edgesLock(extractor.mutex());
+	const adiscope::logic::EdgeExtractor::Edges &allEdges = extractor.edges(m_bit);
+
 	QwtPointMapper mapper;
 	mapper.setFlag( QwtPointMapper::RoundPoints, QwtPainter::roundingAlignment( painter ) );
 	mapper.setBoundingRect(canvasRect);
@@ -119,29 +107,27 @@ void LogicDataCurve::drawLines(QPainter *painter, const QwtScaleMap &xMap,
 
 	const double heightInPoints = yMap.invTransform(0) - yMap.invTransform(m_traceHeight);
 
-    if (!m_edges.size()) {
-	    if (m_startSample != m_endSample) {
-		const bool logicLevel = (m_logic->getData()[m_startSample] & (1 << m_bit)) >> m_bit;
-		displayedData += QPointF(fromSampleToTime(m_startSample), logicLevel * heightInPoints + m_pixelOffset);
-		displayedData += QPointF(fromSampleToTime(m_endSample), logicLevel * heightInPoints + m_pixelOffset);
+    if (!allEdges.size()) {
+	const bool logicLevel = (m_logic->getCapture().at(m_startSample) & (1 << m_bit)) >> m_bit;
+	displayedData += QPointF(fromSampleToTime(m_startSample), logicLevel * heightInPoints + m_pixelOffset);
+	displayedData += QPointF(fromSampleToTime(m_endSample), logicLevel * heightInPoints + m_pixelOffset);
 
-		painter->save();
-		painter->setPen(m_traceColor);
+	painter->save();
+	painter->setPen(m_traceColor);
 
-		QwtPointSeriesData *d = new QwtPointSeriesData(displayedData);
-		QPolygonF polyline = mapper.toPolygonF(xMap, yMap, d, 0, displayedData.size() - 1);
-		QwtPainter::drawPolyline(painter, polyline);
+	QwtPointSeriesData *d = new QwtPointSeriesData(displayedData);
+	QPolygonF polyline = mapper.toPolygonF(xMap, yMap, d, 0, displayedData.size() - 1);
+	QwtPainter::drawPolyline(painter, polyline);
 
-		painter->restore();
+	painter->restore();
 
-		delete d;
+	delete d;
 
-	    }
         return;
     }
 
     std::vector<std::pair<uint64_t, bool>> edges;
-    getSubsampledEdges(edges, xMap);
+    getSubsampledEdges(edges, allEdges, xMap);
 
 
     if (!edges.size()) {
@@ -197,10 +183,17 @@ void LogicDataCurve::drawLines(QPainter *painter, const QwtScaleMap &xMap,
     start = start < 0 ? 0 : start;
     end = end > (m_endSample - 1) ? (m_endSample - 1) : end;
 
+    if (start > end) {
+	return;
+    }
+
+    std::vector<uint16_t> samples(end - start + 1);
+    samples.resize(m_logic->getCapture().read(start, samples.size(), samples.data()));
+
     QVector<QPointF> points;
-    for (; start <= end; ++start) {
-	double y = ((m_logic->getData()[start] & (1 << m_bit)) >> m_bit) * heightInPoints + m_pixelOffset;
-	points += QPointF(fromSampleToTime(start), y);
+    for (size_t i = 0; i < samples.size(); ++i) {
+	double y = ((samples[i] & (1 << m_bit)) >> m_bit) * heightInPoints + m_pixelOffset;
+	points += QPointF(fromSampleToTime(start + i), y);
     }
 
     QwtPointSeriesData *d2 = new QwtPointSeriesData(points);
@@ -219,58 +212,60 @@ void LogicDataCurve::drawLines(QPainter *painter, const QwtScaleMap &xMap,
 
 }
 
-void LogicDataCurve::getSubsampledEdges(std::vector<std::pair<uint64_t, bool>> &edges, const QwtScaleMap &xMap) const {
+void LogicDataCurve::getSubsampledEdges(std::vector<std::pair<uint64_t, bool>> &edges,
+					const std::vector<std::pair<uint64_t, bool>> &allEdges,
+					const QwtScaleMap &xMap) const {
 
 
 
 	double dist = xMap.transform(fromSampleToTime(1)) - xMap.transform(fromSampleToTime(0));
 
 	QwtInterval interval = plot()->axisInterval(QwtAxis::XBottom);
-	uint64_t firstEdge = edgeAtX(fromTimeToSample(interval.minValue()), m_edges);
-	uint64_t lastEdge = edgeAtX(fromTimeToSample(interval.maxValue()), m_edges);
+	uint64_t firstEdge = edgeAtX(fromTimeToSample(interval.minValue()), allEdges);
+	uint64_t lastEdge = edgeAtX(fromTimeToSample(interval.maxValue()), allEdges);
 
 	if (firstEdge > 0) {
 		firstEdge--;
 	}
 
-	if (lastEdge < m_edges.size() - 1) {
+	if (lastEdge < allEdges.size() - 1) {
 		lastEdge++;
 	}
 
-	if (m_edges.size() == 1) { // corner case
-		edges.emplace_back(m_edges.front());
+	if (allEdges.size() == 1) { // corner case
+		edges.emplace_back(allEdges.front());
 		return;
 	}
 
 	// If plot is zoomed in / not so many edges close together
 	// draw them all
 	if (dist > 0.10) {
-		if (lastEdge == m_edges.size() - 1) {
-			lastEdge = m_edges.size();
+		if (lastEdge == allEdges.size() - 1) {
+			lastEdge = allEdges.size();
 		}
 
 		for (; firstEdge < lastEdge; ++firstEdge) {
-			edges.emplace_back(m_edges[firstEdge]);
+			edges.emplace_back(allEdges[firstEdge]);
 		}
 	} else {
 
 		const uint64_t pointsPerPixel = 1.0 / dist;
 
 		// always add the first edge
-		edges.emplace_back(m_edges[firstEdge]);
+		edges.emplace_back(allEdges[firstEdge]);
 
 		for (; firstEdge < lastEdge; ) {
 			// Find the next edge that is at least "pointsPerPixel" away
 			// from the current one
-			auto next = std::upper_bound(m_edges.begin(), m_edges.end(),
+			auto next = std::upper_bound(allEdges.begin(), allEdges.end(),
 				std::make_pair(edges.back().first + pointsPerPixel - 1, false),
 				[=](const std::pair<uint64_t, bool> &lhs, const std::pair<uint64_t, bool> &rhs) -> bool {
 			return lhs.first < rhs.first;
 			});
 
 			bool didReachEnd = false;
-			if (next == m_edges.end()) {
-				next = m_edges.end() - 1;
+			if (next == allEdges.end()) {
+				next = allEdges.end() - 1;
 				didReachEnd = true;
 			}
 
@@ -289,7 +284,7 @@ void LogicDataCurve::getSubsampledEdges(std::vector<std::pair<uint64_t, bool>> &
 
 			edges.emplace_back(*next);
 
-			firstEdge = std::distance(m_edges.begin(), next);
+			firstEdge = std::distance(allEdges.begin(), next);
 		}
 	}
 }
@@ -306,10 +301,6 @@ uint64_t LogicDataCurve::edgeAtX(int x, const std::vector<std::pair<uint64_t, bo
     while (end >= start) {
         mid = start + (end - start) / 2;
 
-	if (mid >= m_edges.size()) {
-//		qDebug() << "mid: " << mid << " m_edges.size():" << m_edges.size();
-	}
-
         if (edges[mid].first < x) {
             start = mid + 1;
         } else if (edges[mid].first > x) {
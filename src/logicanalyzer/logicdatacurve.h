@@ -47,7 +47,9 @@ protected:
         const QRectF &canvasRect, int from, int to ) const;
 
 private:
-    void getSubsampledEdges(std::vector<std::pair<uint64_t, bool> > &edges, const QwtScaleMap &xMap) const;
+    void getSubsampledEdges(std::vector<std::pair<uint64_t, bool> > &edges,
+                            const std::vector<std::pair<uint64_t, bool> > &allEdges,
+                            const QwtScaleMap &xMap) const;
     uint64_t edgeAtX(int x, const std::vector<std::pair<uint64_t, bool> > &edges) const;
 
 
@@ -55,17 +57,12 @@ private:
 
 	adiscope::logic::LogicTool *m_logic;
 
-    // pointer to data which this curve listens to
-    uint16_t *m_data;
     // bit to watch in each sample from m_data
     uint8_t m_bit;
 
     uint64_t m_startSample;
     uint64_t m_endSample;
 
-    // false -> ,,|'' true -> ''|,,
-    std::vector<std::pair<uint64_t, bool>> m_edges;
-
     bool m_displaySampling;
 
     mutable std::mutex m_dataAvailableMutex;
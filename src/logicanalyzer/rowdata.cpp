@@ -41,82 +41,261 @@
 
 #include <QDebug>
 
+#include <algorithm>
+
+/* Annotations per leaf of the index */
+static const size_t INDEX_BLOCK = 16;
+
 uint64_t RowData::get_max_sample() const
 {
-    if (annotations_.empty())
+    if (starts_.empty())
         return 0;
-    return annotations_.back().end_sample();
-//    return 0;
+
+    // The root of the index holds the largest end sample
+    return max_end_[1];
+}
+
+/*
+ * Annotations starting after end_sample are never part of a subset, the
+ * others only if they end after start_sample.
+ */
+size_t RowData::count_starting_before(uint64_t end_sample) const
+{
+    return std::upper_bound(starts_.begin(), starts_.end(), end_sample)
+        - starts_.begin();
+}
+
+void RowData::find_overlapping(size_t node, size_t node_start, size_t node_end,
+                               size_t count, uint64_t start_sample,
+                               vector<Annotation> &dest) const
+{
+    if (node_start * INDEX_BLOCK >= count || max_end_[node] <= start_sample)
+        return;
+
+    if (node >= capacity_) {
+        const size_t end = std::min(node_end * INDEX_BLOCK, count);
+
+        for (size_t i = node_start * INDEX_BLOCK; i < end; i++)
+            if (ends_[i] > start_sample)
+                dest.push_back(getAnnAt(i));
+        return;
+    }
+
+    const size_t middle = (node_start + node_end) / 2;
+
+    find_overlapping(2 * node, node_start, middle, count, start_sample, dest);
+    find_overlapping(2 * node + 1, middle, node_end, count, start_sample, dest);
+}
+
+/* Index of the first of the count first annotations ending after start_sample */
+size_t RowData::first_overlapping(size_t count, uint64_t start_sample) const
+{
+    size_t node = 1;
+
+    if (!count || max_end_[node] <= start_sample)
+        return count;
+
+    // Down to the first block holding one
+    while (node < capacity_)
+        node = max_end_[2 * node] > start_sample ? 2 * node : 2 * node + 1;
+
+    const size_t begin = (node - capacity_) * INDEX_BLOCK;
+    const size_t end = std::min(begin + INDEX_BLOCK, count);
+
+    for (size_t i = begin; i < end; i++)
+        if (ends_[i] > start_sample)
+            return i;
+
+    // The first one overall is past count
+    return count;
+}
+
+/* Index of the last of the count first annotations ending after start_sample */
+size_t RowData::last_overlapping(size_t count, uint64_t start_sample) const
+{
+    if (!count)
+        return count;
+
+    // The block of the last annotation may hold some past count
+    const size_t block = (count - 1) / INDEX_BLOCK;
+
+    for (size_t i = count; i > block * INDEX_BLOCK; i--)
+        if (ends_[i - 1] > start_sample)
+            return i - 1;
+
+    // Walk up from that block, looking at the left siblings
+    size_t node = capacity_ + block;
+
+    do {
+        // Climb while node is a left child or its left sibling is empty
+        while (node > 1 && (node % 2 == 0 || max_end_[node - 1] <= start_sample))
+            node /= 2;
+
+        if (node <= 1)
+            return count;
+
+        node--;
+    } while (max_end_[node] <= start_sample);
+
+    // Go down to the last block holding one, which is before count
+    while (node < capacity_)
+        node = max_end_[2 * node + 1] > start_sample ? 2 * node + 1 : 2 * node;
+
+    const size_t begin = (node - capacity_) * INDEX_BLOCK;
+
+    for (size_t i = begin + INDEX_BLOCK; i > begin; i--)
+        if (ends_[i - 1] > start_sample)
+            return i - 1;
+
+    return count;
 }
 
 void RowData::get_annotation_subset(
     vector<Annotation> &dest,
     uint64_t start_sample, uint64_t end_sample) const
 {
-    for (const auto& annotation : annotations_)
-        if (annotation.end_sample() > start_sample &&
-            annotation.start_sample() <= end_sample)
-            dest.push_back(annotation);
+    const size_t count = count_starting_before(end_sample);
+
+    if (count)
+        find_overlapping(1, 0, capacity_, count, start_sample, dest);
 }
 
 vector<Annotation> RowData::get_annotations() const {
-	return annotations_;
+	vector<Annotation> annotations;
+
+	annotations.reserve(size());
+	for (size_t i = 0; i < size(); i++)
+		annotations.push_back(getAnnAt(i));
+
+	return annotations;
 }
 
 Annotation RowData::getAnnAt(uint64_t index) const {
 
-    return annotations_[index];
+    return Annotation(starts_[index], ends_[index], texts_[ids_[index]], row_);
 }
 
-const Annotation* RowData::annAt(uint64_t index) const
+uint64_t RowData::start_sample(uint64_t index) const
 {
-    return &annotations_[index];
+    return starts_[index];
+}
+
+uint64_t RowData::end_sample(uint64_t index) const
+{
+    return ends_[index];
 }
 
 void RowData::sort_annotations() {
-    // Use stable_sort to keep the annotations having
-    // the same start sample in the same order as
-    // they came from libsigrokdecode
-    std::stable_sort(annotations_.begin(), annotations_.end(), [](const Annotation &a, const Annotation &b){
-        return a.start_sample() < b.start_sample();
-    });
+    // Nothing to do: emplace_annotation() keeps the
+    // annotations sorted by start sample, those having
+    // the same start sample in the same order as they
+    // came from libsigrokdecode
 }
 
 std::pair<uint64_t, uint64_t> RowData::get_annotation_subset(uint64_t start_sample, uint64_t end_sample) const
 {
+    const size_t count = count_starting_before(end_sample);
+    uint64_t first = first_overlapping(count, start_sample);
+    uint64_t last = last_overlapping(count, start_sample);
 
-//    qDebug() << start_sample << " " << end_sample;
-
-    uint64_t first = 0, last = 0;
-
-    bool found = false;
-    for (size_t i = 0; i < annotations_.size(); ++i) {
-        if (annotations_[i].end_sample() > start_sample &&
-            annotations_[i].start_sample() <= end_sample) {
-            if (!found) {
-                first = i;
-                found = true;
-            } else {
-                last = i;
-            }
-        }
-    }
+    // In a gap, the neighbours are the last annotation starting before
+    // the range and the first one starting after it
+    if (first == count) {
+        first = count > 0 ? count - 1 : 0;
+        last = size() > 0 ? std::min<uint64_t>(count, size() - 1) : 0;
 
-    if (!last && first > 0) {
-	    last = (first < annotations_.size() - 1) ? first + 1
-			    : first;
+        return std::make_pair(first, last);
     }
 
     // let s adjust the edges a bit
     if (first > 0) first--;
-    if (last < annotations_.size() - 1) last++;
+    if (last + 1 < size()) last++;
 
     return std::make_pair(first, last);
 }
 
-void RowData::emplace_annotation(srd_proto_data *pdata, const Row *row)
+/*
+ * Updates the index from the given annotation on, after it was appended
+ * or inserted. The tree doubles when it gets full.
+ */
+void RowData::update_index(size_t from)
+{
+    const size_t count = size();
+    const size_t blocks = (count + INDEX_BLOCK - 1) / INDEX_BLOCK;
+
+    if (blocks > capacity_) {
+        capacity_ = std::max<size_t>(2 * capacity_, 16);
+        max_end_.assign(2 * capacity_, 0);
+        from = 0;
+    }
+
+    const size_t first = from / INDEX_BLOCK;
+
+    for (size_t block = first; block < blocks; block++) {
+        const size_t end = std::min((block + 1) * INDEX_BLOCK, count);
+
+        max_end_[capacity_ + block] = *std::max_element(
+            ends_.begin() + block * INDEX_BLOCK, ends_.begin() + end);
+    }
+
+    // Refresh the parents of the blocks that changed, level by level
+    size_t lo = (capacity_ + first) / 2, hi = (capacity_ + blocks - 1) / 2;
+
+    for (; hi > 0; lo /= 2, hi /= 2) {
+        for (size_t node = lo; node <= hi; node++)
+            max_end_[node] = std::max(max_end_[2 * node],
+                                      max_end_[2 * node + 1]);
+    }
+}
+
+/*
+ * Index of the class and texts of an annotation in texts_. The lookup
+ * key is made of the raw class and UTF-8 texts, so that only new texts
+ * get converted to QString.
+ */
+uint32_t RowData::intern_text(const srd_proto_data_annotation *pda)
 {
-    annotations_.emplace_back(pdata, row);
+    std::string key(reinterpret_cast<const char *>(&pda->ann_class),
+                     sizeof(pda->ann_class));
+
+    for (char **text = pda->ann_text; *text; text++) {
+        key += *text;
+        key += '\0';
+    }
+
+    auto it = text_ids_.find(key);
+    if (it != text_ids_.end())
+        return it->second;
+
+    auto text = std::make_shared<Annotation::Text>();
+    text->ann_class = (Annotation::Class)pda->ann_class;
+
+    for (char **t = pda->ann_text; *t; t++)
+        text->annotations.push_back(QString::fromUtf8(*t));
+
+    const uint32_t id = texts_.size();
+    texts_.push_back(text);
+    text_ids_.emplace(std::move(key), id);
+
+    return id;
 }
 
+void RowData::emplace_annotation(srd_proto_data *pdata, const Row *row)
+{
+    const srd_proto_data_annotation *const pda =
+        (const srd_proto_data_annotation*)pdata->data;
+    const uint32_t id = intern_text(pda);
+
+    row_ = row;
 
+    // Annotations mostly come in order, the others are inserted after
+    // the ones with the same start sample
+    auto it = std::upper_bound(starts_.begin(), starts_.end(),
+                               pdata->start_sample);
+    const size_t index = it - starts_.begin();
+
+    starts_.insert(it, pdata->start_sample);
+    ends_.insert(ends_.begin() + index, pdata->end_sample);
+    ids_.insert(ids_.begin() + index, id);
+    update_index(index);
+}
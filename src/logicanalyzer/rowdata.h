@@ -45,6 +45,9 @@
 
 #include "annotation.h"
 
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <set>
 
@@ -59,13 +62,13 @@ public:
     uint64_t get_max_sample() const;
 
     uint64_t size() const {
-        return annotations_.size();
+        return starts_.size();
     }
 
     /**
-     * Extracts annotations between the given sample range into a vector.
-     * Note: The annotations are unsorted and only annotations that fully
-     * fit into the sample range are considered.
+     * Extracts the annotations that overlap the given sample range, that
+     * is, that end after start_sample and start at or before end_sample,
+     * sorted by their start sample.
      */
     void get_annotation_subset(
         vector<Annotation> &dest,
@@ -75,22 +78,55 @@ public:
 
     void emplace_annotation(srd_proto_data *pdata, const Row *row);
 
+    /**
+     * Index range [first, last] holding the annotations that overlap the
+     * given sample range, widened by one annotation on each side. When
+     * none overlaps, the range holds the two annotations around it.
+     */
     std::pair<uint64_t, uint64_t> get_annotation_subset(uint64_t start_sample,
                                                         uint64_t end_sample) const;
 
     Annotation getAnnAt(uint64_t index) const;
-    const Annotation* annAt(uint64_t index) const;
+    uint64_t start_sample(uint64_t index) const;
+    uint64_t end_sample(uint64_t index) const;
 
     void sort_annotations();
 
 private:
-    struct annotation_compare {
-        bool operator() (const Annotation &a, const Annotation &b) const {
-            return a.start_sample() < b.start_sample();
-        }
-    };
-
-    std::vector<Annotation/*, annotation_compare*/> annotations_;
+    /*
+     * The annotations are stored in columns, sorted by start sample as
+     * they are added. A decoder repeats the same few texts over and over,
+     * so each distinct class and texts pair is kept once, in texts_, and
+     * the annotations only hold its index. text_ids_ finds that index
+     * from the raw class and texts of libsigrokdecode.
+     */
+    std::vector<uint64_t> starts_;
+    std::vector<uint64_t> ends_;
+    std::vector<uint32_t> ids_;
+    std::vector<std::shared_ptr<const Annotation::Text>> texts_;
+    std::unordered_map<std::string, uint32_t> text_ids_;
+    const Row *row_ = nullptr;
+
+    uint32_t intern_text(const srd_proto_data_annotation *pda);
+
+    /*
+     * On top of the columns, max_end_ is a segment tree holding the
+     * largest end sample of every node. Its leaves, from index
+     * capacity_, each cover a block of annotations and the unused ones
+     * are 0. A range query then only descends into the nodes that hold
+     * an annotation ending after the start of the range, so it costs
+     * O(log n) per block of annotations found.
+     */
+    std::vector<uint64_t> max_end_;
+    size_t capacity_ = 0;
+
+    void update_index(size_t from);
+    void find_overlapping(size_t node, size_t node_start, size_t node_end,
+                          size_t count, uint64_t start_sample,
+                          vector<Annotation> &dest) const;
+    size_t first_overlapping(size_t count, uint64_t start_sample) const;
+    size_t last_overlapping(size_t count, uint64_t start_sample) const;
+    size_t count_starting_before(uint64_t end_sample) const;
 };
 
 #endif // ROWDATA_H
@@ -20,12 +20,11 @@
 
 #include "gui/dynamicWidget.hpp"
 #include "math.hpp"
+#include "math_expression.hpp"
 
 #include <QLocale>
 #include <QMenu>
 
-#include <scopy/math.h>
-
 using namespace adiscope;
 
 Math::Math(QWidget *parent, unsigned int num_inputs) : QWidget(parent),
@@ -169,7 +168,7 @@ void Math::validateFunction()
 	QString function = ui.function->text();
 
 	try {
-		gr::scopy::iio_math::make(function.toStdString(), num_inputs);
+		MathProgram::validate(function.toStdString(), num_inputs);
 
 		Q_EMIT functionValid(function);
 
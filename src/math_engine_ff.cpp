@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "math_engine_ff.hpp"
+
+#include <gnuradio/io_signature.h>
+
+#include <cmath>
+
+using namespace adiscope;
+
+math_engine_ff::math_engine_ff(unsigned int ninputs, unsigned int max_outputs) :
+	gr::sync_block("math_engine_ff",
+			gr::io_signature::make(ninputs, ninputs, sizeof(float)),
+			gr::io_signature::make(1, max_outputs, sizeof(float))),
+	d_ninputs(ninputs),
+	d_lo(-INFINITY),
+	d_hi(INFINITY),
+	d_program(ninputs)
+{
+}
+
+math_engine_ff::~math_engine_ff()
+{
+}
+
+void math_engine_ff::set_functions(const std::vector<std::string> &functions)
+{
+	MathProgram program(d_ninputs);
+
+	for (const std::string &function : functions) {
+		program.addExpression(function);
+	}
+
+	program.setRange(d_lo, d_hi);
+
+	gr::thread::scoped_lock lock(d_setlock);
+	d_program = program;
+}
+
+void math_engine_ff::set_range(float lo, float hi)
+{
+	gr::thread::scoped_lock lock(d_setlock);
+
+	d_lo = lo;
+	d_hi = hi;
+	d_program.setRange(lo, hi);
+}
+
+int math_engine_ff::work(int noutput_items,
+		gr_vector_const_void_star &input_items,
+		gr_vector_void_star &output_items)
+{
+	gr::thread::scoped_lock lock(d_setlock);
+
+	d_in.resize(input_items.size());
+	for (size_t i = 0; i < input_items.size(); i++) {
+		d_in[i] = static_cast<const float *>(input_items[i]);
+	}
+
+	d_out.resize(output_items.size());
+	for (size_t i = 0; i < output_items.size(); i++) {
+		d_out[i] = static_cast<float *>(output_items[i]);
+	}
+
+	d_program.run(d_in.data(), d_out.data(), d_out.size(), noutput_items);
+
+	return noutput_items;
+}
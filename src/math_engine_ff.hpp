@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MATH_ENGINE_FF_HPP
+#define MATH_ENGINE_FF_HPP
+
+#include "math_expression.hpp"
+
+#include <gnuradio/sync_block.h>
+
+#include <string>
+#include <vector>
+
+namespace adiscope {
+	/*
+	 * Evaluates every math channel of an instrument in one block:
+	 * output i carries functions[i], computed from all the inputs and
+	 * clamped to the range given with set_range().
+	 */
+	class math_engine_ff : public gr::sync_block
+	{
+	private:
+		unsigned int d_ninputs;
+		float d_lo;
+		float d_hi;
+		MathProgram d_program;
+		std::vector<const float *> d_in;
+		std::vector<float *> d_out;
+
+	public:
+		math_engine_ff(unsigned int ninputs, unsigned int max_outputs);
+		~math_engine_ff();
+
+		/*
+		 * Replaces the compiled program. Throws std::invalid_argument
+		 * and keeps the previous one if any function is not valid.
+		 */
+		void set_functions(const std::vector<std::string> &functions);
+		void set_range(float lo, float hi);
+
+		int work(int noutput_items,
+			 gr_vector_const_void_star &input_items,
+			 gr_vector_void_star &output_items);
+	};
+}
+
+#endif /* MATH_ENGINE_FF_HPP */
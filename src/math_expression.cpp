@@ -0,0 +1,653 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "math_expression.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <locale>
+#include <sstream>
+#include <stdexcept>
+#include <string.h>
+
+using namespace adiscope;
+
+/* Number of samples processed by every instruction in one go */
+static const size_t CHUNK = 512;
+
+/*
+ * Recursive descent parser, one method per precedence level:
+ *   expr    = term { ("+" | "-") term }
+ *   term    = unary { ("*" | "/") unary }
+ *   unary   = ("+" | "-") unary | power
+ *   power   = primary [ "^" unary ]
+ *   primary = number | constant | input | function "(" expr ")"
+ *             | "(" expr ")"
+ */
+class MathProgram::Parser
+{
+public:
+	Parser(MathProgram *program, const std::string &text):
+		d_program(program),
+		d_text(text),
+		d_pos(0)
+	{
+	}
+
+	int parse()
+	{
+		const int result = expr();
+
+		skipSpaces();
+		if (d_pos != d_text.size()) {
+			fail("unexpected '" + d_text.substr(d_pos, 1) + "'");
+		}
+
+		return result;
+	}
+
+private:
+	void fail(const std::string &what) const
+	{
+		throw std::invalid_argument("Invalid math expression: " + what +
+					    " at position " +
+					    std::to_string(d_pos));
+	}
+
+	void skipSpaces()
+	{
+		while (d_pos < d_text.size() && isspace((unsigned char)d_text[d_pos])) {
+			d_pos++;
+		}
+	}
+
+	bool accept(char c)
+	{
+		skipSpaces();
+
+		if (d_pos < d_text.size() && d_text[d_pos] == c) {
+			d_pos++;
+			return true;
+		}
+
+		return false;
+	}
+
+	int expr()
+	{
+		int result = term();
+
+		for (;;) {
+			if (accept('+')) {
+				result = d_program->node(ADD, result, term());
+			} else if (accept('-')) {
+				result = d_program->node(SUB, result, term());
+			} else {
+				return result;
+			}
+		}
+	}
+
+	int term()
+	{
+		int result = unary();
+
+		for (;;) {
+			if (accept('*')) {
+				result = d_program->node(MUL, result, unary());
+			} else if (accept('/')) {
+				result = d_program->node(DIV, result, unary());
+			} else {
+				return result;
+			}
+		}
+	}
+
+	int unary()
+	{
+		if (accept('-')) {
+			return d_program->node(NEG, unary());
+		}
+
+		if (accept('+')) {
+			return unary();
+		}
+
+		return power();
+	}
+
+	int power()
+	{
+		const int base = primary();
+
+		if (accept('^')) {
+			return d_program->node(POW, base, unary());
+		}
+
+		return base;
+	}
+
+	int primary()
+	{
+		skipSpaces();
+
+		if (d_pos == d_text.size()) {
+			fail("unexpected end");
+		}
+
+		const char c = d_text[d_pos];
+
+		if (accept('(')) {
+			const int result = expr();
+
+			if (!accept(')')) {
+				fail("missing ')'");
+			}
+
+			return result;
+		}
+
+		if (isdigit((unsigned char)c) || c == '.' || c == ',') {
+			return number();
+		}
+
+		if (isalpha((unsigned char)c)) {
+			return identifier();
+		}
+
+		fail("unexpected '" + std::string(1, c) + "'");
+		return -1;
+	}
+
+	int number()
+	{
+		std::string digits;
+
+		while (d_pos < d_text.size() && isdigit((unsigned char)d_text[d_pos])) {
+			digits += d_text[d_pos++];
+		}
+
+		// Both separators are accepted, the widget inserts the one
+		// of the current locale
+		if (d_pos < d_text.size() &&
+				(d_text[d_pos] == '.' || d_text[d_pos] == ',')) {
+			digits += '.';
+			d_pos++;
+
+			while (d_pos < d_text.size() &&
+					isdigit((unsigned char)d_text[d_pos])) {
+				digits += d_text[d_pos++];
+			}
+		}
+
+		if (digits == ".") {
+			fail("malformed number");
+		}
+
+		// An exponent only if digits follow. Otherwise the number ends
+		// before the 'e' and "2e" fails as trailing input, since there
+		// is no implicit multiplication; "2*e" uses the constant.
+		if (d_pos < d_text.size() &&
+				(d_text[d_pos] == 'e' || d_text[d_pos] == 'E')) {
+			size_t end = d_pos + 1;
+
+			if (end < d_text.size() &&
+					(d_text[end] == '+' || d_text[end] == '-')) {
+				end++;
+			}
+
+			if (end < d_text.size() && isdigit((unsigned char)d_text[end])) {
+				digits += d_text.substr(d_pos, end - d_pos);
+				d_pos = end;
+
+				while (d_pos < d_text.size() &&
+						isdigit((unsigned char)d_text[d_pos])) {
+					digits += d_text[d_pos++];
+				}
+			}
+		}
+
+		std::istringstream stream(digits);
+		double value = 0;
+
+		stream.imbue(std::locale::classic());
+		stream >> value;
+
+		return d_program->node(CONST, -1, -1, value);
+	}
+
+	int identifier()
+	{
+		const size_t start = d_pos;
+
+		while (d_pos < d_text.size() && isalnum((unsigned char)d_text[d_pos])) {
+			d_pos++;
+		}
+
+		const std::string name = d_text.substr(start, d_pos - start);
+
+		if (name == "e") {
+			return d_program->node(CONST, -1, -1, M_E);
+		}
+
+		if (name == "pi") {
+			return d_program->node(CONST, -1, -1, M_PI);
+		}
+
+		if (name[0] == 't') {
+			const std::string index = name.substr(1);
+			const unsigned int ninputs = d_program->d_ninputs;
+
+			if (index.empty() && ninputs == 1) {
+				return d_program->node(INPUT, 0);
+			}
+
+			if (!index.empty() && index.size() < 4 &&
+					std::all_of(index.begin(), index.end(), ::isdigit) &&
+					(unsigned int)std::stoi(index) < ninputs) {
+				return d_program->node(INPUT, std::stoi(index));
+			}
+		}
+
+		static const struct {
+			const char *name;
+			Op op;
+		} functions[] = {
+			{ "sin", SIN }, { "cos", COS }, { "tan", TAN },
+			{ "asin", ASIN }, { "acos", ACOS }, { "atan", ATAN },
+			{ "sinh", SINH }, { "cosh", COSH }, { "tanh", TANH },
+			{ "log", LOG }, { "log10", LOG10 }, { "exp", EXP },
+			{ "sqrt", SQRT }, { "abs", ABS },
+		};
+
+		for (const auto &f : functions) {
+			if (name != f.name) {
+				continue;
+			}
+
+			if (!accept('(')) {
+				fail("missing '(' after " + name);
+			}
+
+			const int arg = expr();
+
+			if (!accept(')')) {
+				fail("missing ')'");
+			}
+
+			return d_program->node(f.op, arg);
+		}
+
+		d_pos = start;
+		fail("unknown name '" + name + "'");
+		return -1;
+	}
+
+	MathProgram *d_program;
+	const std::string &d_text;
+	size_t d_pos;
+};
+
+MathProgram::MathProgram(unsigned int ninputs):
+	d_ninputs(ninputs),
+	d_lo(-INFINITY),
+	d_hi(INFINITY),
+	d_compiled(false)
+{
+}
+
+unsigned int MathProgram::addExpression(const std::string &expression)
+{
+	const size_t nodes = d_nodes.size();
+
+	try {
+		Parser parser(this, expression);
+		d_outputs.push_back(parser.parse());
+	} catch (...) {
+		// Forget the nodes of the rejected expression
+		for (size_t i = nodes; i < d_nodes.size(); i++) {
+			const Node &n = d_nodes[i];
+			d_lookup.erase(key(n.op, n.a, n.b, n.value));
+		}
+
+		d_nodes.resize(nodes);
+		throw;
+	}
+
+	d_compiled = false;
+	return d_outputs.size() - 1;
+}
+
+void MathProgram::validate(const std::string &expression, unsigned int ninputs)
+{
+	MathProgram program(ninputs);
+	program.addExpression(expression);
+}
+
+void MathProgram::setRange(float lo, float hi)
+{
+	d_lo = lo;
+	d_hi = hi;
+}
+
+unsigned int MathProgram::numInputs() const
+{
+	return d_ninputs;
+}
+
+unsigned int MathProgram::numOutputs() const
+{
+	return d_outputs.size();
+}
+
+unsigned int MathProgram::numInstructions() const
+{
+	return d_code.size();
+}
+
+MathProgram::NodeKey MathProgram::key(Op op, int a, int b, float value)
+{
+	// Compare constants by their bits, NaN included
+	uint32_t bits;
+
+	memcpy(&bits, &value, sizeof(bits));
+	return NodeKey(op, a, b, bits);
+}
+
+float MathProgram::fold(Op op, float a, float b)
+{
+	float result = 0.0f;
+
+	execute(op, &result, &a, &b, 1);
+	return result;
+}
+
+int MathProgram::node(Op op, int a, int b, float value)
+{
+	const bool unary = op >= SIN || op == NEG;
+
+	// Cheaper forms of a few common operations
+	if (op == POW && d_nodes[b].op == CONST) {
+		if (d_nodes[b].value == 1.0f) {
+			return a;
+		}
+
+		if (d_nodes[b].value == 2.0f) {
+			return node(MUL, a, a);
+		}
+
+		if (d_nodes[b].value == 0.5f) {
+			return node(SQRT, a);
+		}
+	} else if (op == DIV && d_nodes[b].op == CONST &&
+			d_nodes[b].value != 0.0f) {
+		return node(MUL, a, node(CONST, -1, -1, 1.0f / d_nodes[b].value));
+	}
+
+	// Constant folding
+	if ((op > INPUT) && d_nodes[a].op == CONST &&
+			(unary || d_nodes[b].op == CONST)) {
+		return node(CONST, -1, -1, fold(op, d_nodes[a].value,
+					unary ? 0.0f : d_nodes[b].value));
+	}
+
+	// Same operands in any order give the same node
+	if ((op == ADD || op == MUL) && a > b) {
+		std::swap(a, b);
+	}
+
+	const NodeKey k = key(op, a, b, value);
+	auto it = d_lookup.find(k);
+
+	if (it != d_lookup.end()) {
+		return it->second;
+	}
+
+	d_nodes.push_back({ op, a, b, value });
+	d_lookup.emplace(k, d_nodes.size() - 1);
+	return d_nodes.size() - 1;
+}
+
+void MathProgram::compile()
+{
+	const size_t count = d_nodes.size();
+	std::vector<bool> used(count, false);
+	std::vector<int> last_use(count, -1);
+
+	for (int out : d_outputs) {
+		used[out] = true;
+		last_use[out] = INT_MAX;
+	}
+
+	// Children always come before their parents
+	for (size_t i = count; i-- > 0;) {
+		const Node &n = d_nodes[i];
+
+		if (used[i] && n.op > INPUT) {
+			used[n.a] = true;
+			if (n.b >= 0) {
+				used[n.b] = true;
+			}
+		}
+	}
+
+	d_code.clear();
+	std::vector<size_t> order;
+
+	for (size_t i = 0; i < count; i++) {
+		const Node &n = d_nodes[i];
+
+		if (!used[i] || n.op <= INPUT) {
+			continue;
+		}
+
+		const int pc = order.size();
+		last_use[n.a] = std::max(last_use[n.a], pc);
+		if (n.b >= 0) {
+			last_use[n.b] = std::max(last_use[n.b], pc);
+		}
+
+		order.push_back(i);
+	}
+
+	// Constants get a buffer filled once; every other value lives in
+	// a buffer that is reused once its last reader has run
+	std::vector<Operand> location(count);
+	std::vector<float> constants;
+	std::vector<unsigned int> free_buffers;
+	unsigned int nbuffers = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		if (!used[i]) {
+			continue;
+		}
+
+		if (d_nodes[i].op == CONST) {
+			location[i] = { false, nbuffers++ };
+			constants.push_back(d_nodes[i].value);
+		} else if (d_nodes[i].op == INPUT) {
+			location[i] = { true, (unsigned int)d_nodes[i].a };
+		}
+	}
+
+	const unsigned int nconstants = nbuffers;
+
+	for (size_t pc = 0; pc < order.size(); pc++) {
+		const int i = order[pc];
+		const Node &n = d_nodes[i];
+		Instruction ins;
+
+		ins.op = n.op;
+		ins.a = location[n.a];
+		ins.b = n.b >= 0 ? location[n.b] : ins.a;
+
+		for (int operand : { n.a, n.b }) {
+			if (operand < 0 || last_use[operand] != (int)pc) {
+				continue;
+			}
+
+			const Operand &o = location[operand];
+
+			if (!o.input && o.index >= nconstants &&
+					std::find(free_buffers.begin(), free_buffers.end(),
+						  o.index) == free_buffers.end()) {
+				free_buffers.push_back(o.index);
+			}
+		}
+
+		if (free_buffers.empty()) {
+			ins.dst = nbuffers++;
+		} else {
+			ins.dst = free_buffers.back();
+			free_buffers.pop_back();
+		}
+
+		location[i] = { false, ins.dst };
+		d_code.push_back(ins);
+	}
+
+	d_results.clear();
+	for (int out : d_outputs) {
+		d_results.push_back(location[out]);
+	}
+
+	d_buffers.assign((size_t)nbuffers * CHUNK, 0.0f);
+	for (unsigned int i = 0; i < nconstants; i++) {
+		std::fill_n(&d_buffers[(size_t)i * CHUNK], CHUNK, constants[i]);
+	}
+
+	d_compiled = true;
+}
+
+const float *MathProgram::operand(const Operand &o, const float * const *inputs,
+				  size_t offset) const
+{
+	if (o.input) {
+		return inputs[o.index] + offset;
+	}
+
+	return &d_buffers[(size_t)o.index * CHUNK];
+}
+
+void MathProgram::execute(Op op, float *dst, const float *a, const float *b,
+			  size_t size)
+{
+	switch (op) {
+	case NEG:
+		for (size_t i = 0; i < size; i++) dst[i] = -a[i];
+		break;
+	case ADD:
+		for (size_t i = 0; i < size; i++) dst[i] = a[i] + b[i];
+		break;
+	case SUB:
+		for (size_t i = 0; i < size; i++) dst[i] = a[i] - b[i];
+		break;
+	case MUL:
+		for (size_t i = 0; i < size; i++) dst[i] = a[i] * b[i];
+		break;
+	case DIV:
+		for (size_t i = 0; i < size; i++) dst[i] = a[i] / b[i];
+		break;
+	case POW:
+		for (size_t i = 0; i < size; i++) dst[i] = std::pow(a[i], b[i]);
+		break;
+	case SIN:
+		for (size_t i = 0; i < size; i++) dst[i] = std::sin(a[i]);
+		break;
+	case COS:
+		for (size_t i = 0; i < size; i++) dst[i] = std::cos(a[i]);
+		break;
+	case TAN:
+		for (size_t i = 0; i < size; i++) dst[i] = std::tan(a[i]);
+		break;
+	case ASIN:
+		for (size_t i = 0; i < size; i++) dst[i] = std::asin(a[i]);
+		break;
+	case ACOS:
+		for (size_t i = 0; i < size; i++) dst[i] = std::acos(a[i]);
+		break;
+	case ATAN:
+		for (size_t i = 0; i < size; i++) dst[i] = std::atan(a[i]);
+		break;
+	case SINH:
+		for (size_t i = 0; i < size; i++) dst[i] = std::sinh(a[i]);
+		break;
+	case COSH:
+		for (size_t i = 0; i < size; i++) dst[i] = std::cosh(a[i]);
+		break;
+	case TANH:
+		for (size_t i = 0; i < size; i++) dst[i] = std::tanh(a[i]);
+		break;
+	case LOG:
+		for (size_t i = 0; i < size; i++) dst[i] = std::log(a[i]);
+		break;
+	case LOG10:
+		for (size_t i = 0; i < size; i++) dst[i] = std::log10(a[i]);
+		break;
+	case EXP:
+		for (size_t i = 0; i < size; i++) dst[i] = std::exp(a[i]);
+		break;
+	case SQRT:
+		for (size_t i = 0; i < size; i++) dst[i] = std::sqrt(a[i]);
+		break;
+	case ABS:
+		for (size_t i = 0; i < size; i++) dst[i] = std::fabs(a[i]);
+		break;
+	default:
+		break;
+	}
+}
+
+void MathProgram::run(const float * const *inputs, float * const *outputs,
+		      unsigned int noutputs, size_t size)
+{
+	if (!d_compiled) {
+		compile();
+	}
+
+	noutputs = std::min<unsigned int>(noutputs, d_outputs.size());
+
+	const float lo = d_lo;
+	const float hi = d_hi;
+
+	for (size_t offset = 0; offset < size; offset += CHUNK) {
+		const size_t n = std::min(CHUNK, size - offset);
+
+		for (const Instruction &ins : d_code) {
+			float *dst = &d_buffers[(size_t)ins.dst * CHUNK];
+
+			execute(ins.op, dst, operand(ins.a, inputs, offset),
+				operand(ins.b, inputs, offset), n);
+		}
+
+		// Same clamping as a rail block, NaNs pass through
+		for (unsigned int k = 0; k < noutputs; k++) {
+			const float *src = operand(d_results[k], inputs, offset);
+			float *dst = outputs[k] + offset;
+
+			for (size_t i = 0; i < n; i++) {
+				const float v = src[i];
+				dst[i] = v > hi ? hi : (v < lo ? lo : v);
+			}
+		}
+	}
+}
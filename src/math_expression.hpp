@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MATH_EXPRESSION_HPP
+#define MATH_EXPRESSION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace adiscope {
+
+/*
+ * Compiled form of one or more math channel expressions over the same
+ * inputs. The grammar is the one offered by the Math widget: numbers,
+ * the constants e and pi, the inputs (t when there is a single one,
+ * t0, t1, ... otherwise), + - * / ^, parentheses and the functions
+ * sin, cos, tan, asin, acos, atan, sinh, cosh, tanh, log, log10, exp,
+ * sqrt and abs.
+ *
+ * Every expression is parsed once into a shared graph of operations;
+ * identical subexpressions, also across expressions, become a single
+ * node and constant subexpressions are folded. The graph is then
+ * scheduled as a list of instructions that each process a whole chunk
+ * of samples, so evaluating a buffer costs one tight loop per operation
+ * instead of one interpreter pass per sample.
+ */
+class MathProgram
+{
+public:
+	explicit MathProgram(unsigned int ninputs = 1);
+
+	/*
+	 * Adds an expression as the next output and returns its index.
+	 * Throws std::invalid_argument if the expression is not valid;
+	 * the program is left unchanged in that case.
+	 */
+	unsigned int addExpression(const std::string &expression);
+
+	/* Throws std::invalid_argument if the expression is not valid */
+	static void validate(const std::string &expression,
+			     unsigned int ninputs);
+
+	/* Every output is clamped to [lo, hi] as it is written */
+	void setRange(float lo, float hi);
+
+	unsigned int numInputs() const;
+	unsigned int numOutputs() const;
+	unsigned int numInstructions() const;
+
+	/*
+	 * Evaluates size samples: reads inputs[0, numInputs()) and writes
+	 * outputs[0, noutputs), noutputs being at most numOutputs().
+	 */
+	void run(const float * const *inputs, float * const *outputs,
+		 unsigned int noutputs, size_t size);
+
+private:
+	enum Op {
+		CONST, INPUT,
+		NEG, ADD, SUB, MUL, DIV, POW,
+		SIN, COS, TAN, ASIN, ACOS, ATAN,
+		SINH, COSH, TANH, LOG, LOG10, EXP, SQRT, ABS,
+	};
+
+	struct Node {
+		Op op;
+		int a;
+		int b;
+		float value;
+	};
+
+	/* Operand of an instruction: an input or one of the buffers */
+	struct Operand {
+		bool input;
+		unsigned int index;
+	};
+
+	struct Instruction {
+		Op op;
+		unsigned int dst;
+		Operand a;
+		Operand b;
+	};
+
+	class Parser;
+	typedef std::tuple<int, int, int, uint32_t> NodeKey;
+
+	static NodeKey key(Op op, int a, int b, float value);
+	int node(Op op, int a = -1, int b = -1, float value = 0.0f);
+	static float fold(Op op, float a, float b);
+	void compile();
+	const float *operand(const Operand &o, const float * const *inputs,
+			     size_t offset) const;
+	static void execute(Op op, float *dst, const float *a,
+			    const float *b, size_t size);
+
+	unsigned int d_ninputs;
+	float d_lo;
+	float d_hi;
+
+	std::vector<Node> d_nodes;
+	std::map<NodeKey, int> d_lookup;
+	std::vector<int> d_outputs;
+
+	bool d_compiled;
+	std::vector<Instruction> d_code;
+	std::vector<Operand> d_results;
+	std::vector<float> d_buffers;
+};
+
+} /* namespace adiscope */
+
+#endif /* MATH_EXPRESSION_HPP */
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "measure_worker.hpp"
+#include "gui/measure.h"
+
+#include <QtConcurrent>
+
+#include <vector>
+
+using namespace adiscope;
+
+struct MeasureWorker::Job {
+	quint64 sequence;
+	size_t count;
+	std::vector<std::unique_ptr<Measure>> measures;
+	std::vector<std::vector<double>> buffers;
+
+	Job(): sequence(0), count(0) {}
+
+	void fill(quint64 seq, const QList<Measure *> &sources)
+	{
+		sequence = seq;
+		count = sources.size();
+
+		if (measures.size() < count) {
+			measures.resize(count);
+			buffers.resize(count);
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			const Measure *src = sources[i];
+			const double *data = src->dataSource();
+			size_t length = data ? src->dataLength() : 0;
+
+			if (!measures[i]) {
+				measures[i].reset(new Measure(src->channel()));
+			}
+
+			buffers[i].assign(data, data + length);
+			measures[i]->copySettings(*src);
+			measures[i]->setDataSource(buffers[i].data(), length);
+		}
+	}
+
+	void run()
+	{
+		for (size_t i = 0; i < count; i++) {
+			measures[i]->measure();
+		}
+	}
+
+	CaptureMeasurements collect() const
+	{
+		CaptureMeasurements results;
+
+		results.sequence = sequence;
+		results.channels.reserve(count);
+
+		for (size_t i = 0; i < count; i++) {
+			const auto data = measures[i]->measurments();
+			ChannelMeasurements chn;
+
+			chn.channel = measures[i]->channel();
+			chn.values.reserve(data.size());
+			chn.measured.reserve(data.size());
+			for (const auto &m : data) {
+				chn.values.push_back(m->value());
+				chn.measured.push_back(m->measured());
+			}
+			results.channels.push_back(chn);
+		}
+
+		return results;
+	}
+};
+
+MeasureWorker::MeasureWorker(QObject *parent):
+	QObject(parent),
+	d_discardRunning(false),
+	d_submitted(0),
+	d_measured(0),
+	d_skipped(0)
+{
+	d_pool.setMaxThreadCount(1);
+
+	connect(&d_watcher, SIGNAL(finished()), SLOT(onJobFinished()));
+}
+
+MeasureWorker::~MeasureWorker()
+{
+	d_watcher.disconnect(this);
+	d_pool.waitForDone();
+}
+
+std::shared_ptr<MeasureWorker::Job> MeasureWorker::takeJob()
+{
+	if (d_spare) {
+		return std::move(d_spare);
+	}
+
+	return std::make_shared<Job>();
+}
+
+void MeasureWorker::submit(quint64 sequence, const QList<Measure *> &measures)
+{
+	d_submitted++;
+
+	if (d_running) {
+		if (d_pending) {
+			d_skipped++;
+		} else {
+			d_pending = takeJob();
+		}
+
+		d_pending->fill(sequence, measures);
+		return;
+	}
+
+	std::shared_ptr<Job> job = takeJob();
+
+	job->fill(sequence, measures);
+	start(job);
+}
+
+void MeasureWorker::start(const std::shared_ptr<Job> &job)
+{
+	d_running = job;
+	d_discardRunning = false;
+
+	Job *raw = job.get();
+	d_watcher.setFuture(QtConcurrent::run(&d_pool, [raw]() {
+		raw->run();
+	}));
+}
+
+void MeasureWorker::onJobFinished()
+{
+	std::shared_ptr<Job> job = std::move(d_running);
+
+	if (!job) {
+		return;
+	}
+
+	const bool discard = d_discardRunning;
+	CaptureMeasurements results;
+
+	if (!discard) {
+		results = job->collect();
+		d_measured++;
+		d_history.push_back(results);
+		if (d_history.size() > HISTORY_SIZE) {
+			d_history.removeFirst();
+		}
+	}
+
+	d_spare = job;
+
+	if (d_pending) {
+		std::shared_ptr<Job> next = std::move(d_pending);
+		start(next);
+	}
+
+	if (!discard) {
+		Q_EMIT resultsReady(results);
+	}
+}
+
+void MeasureWorker::discardPending()
+{
+	if (d_pending) {
+		d_skipped++;
+		d_spare = std::move(d_pending);
+	}
+
+	if (d_running && !d_discardRunning) {
+		d_skipped++;
+		d_discardRunning = true;
+	}
+}
+
+double MeasureWorker::skipRate() const
+{
+	if (d_submitted == 0) {
+		return 0.0;
+	}
+
+	return static_cast<double>(d_skipped) / d_submitted;
+}
+
+quint64 MeasureWorker::lastSequence() const
+{
+	return d_history.isEmpty() ? 0 : d_history.last().sequence;
+}
+
+bool MeasureWorker::results(quint64 sequence, CaptureMeasurements &out) const
+{
+	for (int i = d_history.size() - 1; i >= 0; i--) {
+		if (d_history[i].sequence == sequence) {
+			out = d_history[i];
+			return true;
+		}
+	}
+
+	return false;
+}
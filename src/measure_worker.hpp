@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MEASURE_WORKER_HPP
+#define MEASURE_WORKER_HPP
+
+#include <QFutureWatcher>
+#include <QList>
+#include <QObject>
+#include <QThreadPool>
+#include <QVector>
+
+#include <memory>
+
+namespace adiscope {
+
+class Measure;
+
+/* Results of one channel, indexed by Measure::defaultMeasurements */
+struct ChannelMeasurements {
+	int channel;
+	QVector<double> values;
+	QVector<bool> measured;
+};
+
+/* Results of every measured channel of one capture */
+struct CaptureMeasurements {
+	quint64 sequence;
+	QVector<ChannelMeasurements> channels;
+};
+
+/*
+ * Runs time domain measurements on a single background thread.
+ *
+ * submit() snapshots the data and settings of the given Measure objects so
+ * the caller may overwrite its buffers right away. At most one capture is
+ * measured while one more waits; a newer capture replaces the waiting one,
+ * which is then counted as skipped. Results are delivered on the thread
+ * that owns the worker. All public methods must be called from that thread.
+ */
+class MeasureWorker : public QObject
+{
+	Q_OBJECT
+
+public:
+	static const int HISTORY_SIZE = 32;
+
+	explicit MeasureWorker(QObject *parent = nullptr);
+	~MeasureWorker();
+
+	void submit(quint64 sequence, const QList<Measure *> &measures);
+
+	/* Drops the waiting capture and the results of the one in progress */
+	void discardPending();
+
+	quint64 submittedCount() const { return d_submitted; }
+	quint64 measuredCount() const { return d_measured; }
+	quint64 skippedCount() const { return d_skipped; }
+	double skipRate() const;
+
+	/* Sequence number of the newest measured capture, 0 if none */
+	quint64 lastSequence() const;
+
+	/* Looks up one of the last HISTORY_SIZE measured captures */
+	bool results(quint64 sequence, CaptureMeasurements &out) const;
+
+Q_SIGNALS:
+	void resultsReady(const adiscope::CaptureMeasurements &results);
+
+private Q_SLOTS:
+	void onJobFinished();
+
+private:
+	struct Job;
+
+	std::shared_ptr<Job> takeJob();
+	void start(const std::shared_ptr<Job> &job);
+
+	QThreadPool d_pool;
+	QFutureWatcher<void> d_watcher;
+	std::shared_ptr<Job> d_running;
+	std::shared_ptr<Job> d_pending;
+	std::shared_ptr<Job> d_spare;
+	bool d_discardRunning;
+
+	quint64 d_submitted;
+	quint64 d_measured;
+	quint64 d_skipped;
+	QList<CaptureMeasurements> d_history;
+};
+
+} /* namespace adiscope */
+
+#endif /* MEASURE_WORKER_HPP */
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "minmax_plot_curve.hpp"
+
+#include <qwt_painter.h>
+#include <qwt_scale_map.h>
+#include <qwt_symbol.h>
+
+#include <QPainter>
+#include <cmath>
+
+using namespace adiscope;
+
+MinMaxPlotCurve::MinMaxPlotCurve(const QString &title):
+	QwtPlotCurve(title),
+	d_generation(0)
+{
+}
+
+void MinMaxPlotCurve::updateMinMax(const double *ydata, size_t size,
+				   uint64_t generation)
+{
+	if (generation && generation == d_generation &&
+			size >= d_pyramid.numSamples()) {
+		d_pyramid.append(ydata, size);
+	} else {
+		d_pyramid.rebuild(ydata, size);
+	}
+
+	d_generation = generation;
+}
+
+bool MinMaxPlotCurve::canDecimate() const
+{
+	if (style() != QwtPlotCurve::Lines || testCurveAttribute(Fitted)) {
+		return false;
+	}
+
+	return !symbol() || symbol()->style() == QwtSymbol::NoSymbol;
+}
+
+void MinMaxPlotCurve::drawSeries(QPainter *painter, const QwtScaleMap &xMap,
+				 const QwtScaleMap &yMap, const QRectF &canvasRect,
+				 int from, int to) const
+{
+	const size_t numSamples = dataSize();
+
+	if (to < 0) {
+		to = numSamples - 1;
+	}
+
+	if (numSamples < 2 || !canDecimate() ||
+			d_pyramid.numSamples() != numSamples) {
+		QwtPlotCurve::drawSeries(painter, xMap, yMap, canvasRect, from, to);
+		return;
+	}
+
+	const double x0 = sample(0).x();
+	const double dx = sample(1).x() - x0;
+
+	if (dx <= 0) {
+		QwtPlotCurve::drawSeries(painter, xMap, yMap, canvasRect, from, to);
+		return;
+	}
+
+	// Only the samples inside the visible time window are considered
+	const double left = std::min(xMap.s1(), xMap.s2());
+	const double right = std::max(xMap.s1(), xMap.s2());
+	const int first = std::max<double>(from, std::floor((left - x0) / dx));
+	const int last = std::min<double>(to, std::ceil((right - x0) / dx));
+
+	if (last <= first) {
+		return;
+	}
+
+	const double pixels = std::fabs(xMap.transform(x0 + last * dx) -
+					xMap.transform(x0 + first * dx));
+	const int level = d_pyramid.levelFor((last - first) / std::max(pixels, 1.0));
+
+	if (level < 0) {
+		QwtPlotCurve::drawSeries(painter, xMap, yMap, canvasRect, first, last);
+		return;
+	}
+
+	const size_t bucket = d_pyramid.bucketSize(level);
+	const size_t firstBucket = first / bucket;
+	const size_t lastBucket = std::min(last / bucket,
+					   d_pyramid.numBuckets(level) - 1);
+	const double *mins = d_pyramid.min(level);
+	const double *maxs = d_pyramid.max(level);
+
+	// Zig-zag through the bucket extremes so that every column is drawn
+	// as a vertical span joined to its neighbours
+	QPolygonF polyline;
+	polyline.reserve(2 * (lastBucket - firstBucket + 1));
+
+	for (size_t b = firstBucket; b <= lastBucket; b++) {
+		const double x = xMap.transform(x0 + (b * bucket + bucket / 2.0) * dx);
+		const double lo = yMap.transform(mins[b]);
+		const double hi = yMap.transform(maxs[b]);
+
+		if ((b - firstBucket) % 2) {
+			polyline << QPointF(x, hi) << QPointF(x, lo);
+		} else {
+			polyline << QPointF(x, lo) << QPointF(x, hi);
+		}
+	}
+
+	painter->save();
+	painter->setPen(pen());
+	QwtPainter::drawPolyline(painter, polyline);
+	painter->restore();
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MINMAX_PLOT_CURVE_HPP
+#define MINMAX_PLOT_CURVE_HPP
+
+#include <qwt_plot_curve.h>
+
+#include <cstdint>
+
+#include "minmax_pyramid.hpp"
+
+namespace adiscope {
+
+/*
+ * Curve for uniformly sampled data that, when several samples fall on the
+ * same pixel column, paints the min/max envelope of each column taken from
+ * a MinMaxPyramid instead of every sample. The series data itself is left
+ * untouched, so anything reading samples through data() still sees the
+ * full resolution buffer.
+ */
+class MinMaxPlotCurve : public QwtPlotCurve
+{
+public:
+	explicit MinMaxPlotCurve(const QString &title = QString());
+
+	/*
+	 * Refreshes the envelope after the y data changed. generation
+	 * identifies the content of the producer's buffer (see
+	 * TimeFrame::generation()); when it is the same as on the last call
+	 * only the new samples are added to the summary. 0 always rebuilds.
+	 */
+	void updateMinMax(const double *ydata, size_t size, uint64_t generation);
+
+protected:
+	virtual void drawSeries(QPainter *painter, const QwtScaleMap &xMap,
+				const QwtScaleMap &yMap, const QRectF &canvasRect,
+				int from, int to) const;
+
+private:
+	bool canDecimate() const;
+
+	MinMaxPyramid d_pyramid;
+	uint64_t d_generation;
+};
+
+} /* namespace adiscope */
+
+#endif /* MINMAX_PLOT_CURVE_HPP */
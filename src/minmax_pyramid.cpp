@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "minmax_pyramid.hpp"
+
+#include <algorithm>
+
+using namespace adiscope;
+
+const size_t MinMaxPyramid::BASE_BUCKET;
+const size_t MinMaxPyramid::LEVEL_FACTOR;
+
+MinMaxPyramid::MinMaxPyramid():
+	d_size(0)
+{
+}
+
+void MinMaxPyramid::clear()
+{
+	d_levels.clear();
+	d_size = 0;
+}
+
+void MinMaxPyramid::rebuild(const double *data, size_t size)
+{
+	clear();
+	append(data, size);
+}
+
+void MinMaxPyramid::append(const double *data, size_t size)
+{
+	if (size < d_size) {
+		rebuild(data, size);
+		return;
+	}
+
+	if (size == d_size) {
+		return;
+	}
+
+	// The bucket holding the last summarized sample may be partial
+	size_t fromBucket = d_size / BASE_BUCKET;
+
+	if (d_levels.empty()) {
+		d_levels.push_back(Level());
+	}
+
+	buildBase(data, fromBucket * BASE_BUCKET, size);
+	d_size = size;
+
+	for (size_t level = 1; numBuckets(level - 1) > 1; level++) {
+		if (d_levels.size() == level) {
+			d_levels.push_back(Level());
+		}
+
+		fromBucket /= LEVEL_FACTOR;
+		buildLevel(level, fromBucket);
+	}
+}
+
+void MinMaxPyramid::buildBase(const double *data, size_t from, size_t to)
+{
+	Level &base = d_levels[0];
+	const size_t count = (to + BASE_BUCKET - 1) / BASE_BUCKET;
+
+	base.min.resize(count);
+	base.max.resize(count);
+
+	for (size_t bucket = from / BASE_BUCKET; bucket < count; bucket++) {
+		const size_t start = bucket * BASE_BUCKET;
+		const size_t end = std::min(start + BASE_BUCKET, to);
+		double lo = data[start];
+		double hi = data[start];
+
+		for (size_t i = start + 1; i < end; i++) {
+			lo = std::min(lo, data[i]);
+			hi = std::max(hi, data[i]);
+		}
+
+		base.min[bucket] = lo;
+		base.max[bucket] = hi;
+	}
+}
+
+void MinMaxPyramid::buildLevel(size_t level, size_t fromBucket)
+{
+	const Level &prev = d_levels[level - 1];
+	Level &cur = d_levels[level];
+	const size_t prevCount = prev.min.size();
+	const size_t count = (prevCount + LEVEL_FACTOR - 1) / LEVEL_FACTOR;
+
+	cur.min.resize(count);
+	cur.max.resize(count);
+
+	for (size_t bucket = fromBucket; bucket < count; bucket++) {
+		const size_t start = bucket * LEVEL_FACTOR;
+		const size_t end = std::min(start + LEVEL_FACTOR, prevCount);
+
+		cur.min[bucket] = *std::min_element(&prev.min[start], &prev.min[0] + end);
+		cur.max[bucket] = *std::max_element(&prev.max[start], &prev.max[0] + end);
+	}
+}
+
+size_t MinMaxPyramid::bucketSize(size_t level) const
+{
+	size_t size = BASE_BUCKET;
+
+	for (size_t i = 0; i < level; i++) {
+		size *= LEVEL_FACTOR;
+	}
+
+	return size;
+}
+
+size_t MinMaxPyramid::numBuckets(size_t level) const
+{
+	if (level >= d_levels.size()) {
+		return 0;
+	}
+
+	return d_levels[level].min.size();
+}
+
+int MinMaxPyramid::levelFor(double samplesPerBucket) const
+{
+	int level = -1;
+	double size = BASE_BUCKET;
+
+	while (size <= samplesPerBucket && level + 1 < (int)d_levels.size()) {
+		level++;
+		size *= LEVEL_FACTOR;
+	}
+
+	return level;
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MINMAX_PYRAMID_HPP
+#define MINMAX_PYRAMID_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace adiscope {
+
+/*
+ * Multi-resolution min/max summary of a sample buffer.
+ *
+ * Level 0 holds the min and max of every BASE_BUCKET consecutive samples,
+ * each following level merges LEVEL_FACTOR buckets of the previous one.
+ * The last bucket of a level may be partial; it is recomputed when more
+ * samples are appended.
+ */
+class MinMaxPyramid
+{
+public:
+	static const size_t BASE_BUCKET = 8;
+	static const size_t LEVEL_FACTOR = 4;
+
+	MinMaxPyramid();
+
+	/* Discards everything and summarizes data[0, size) */
+	void rebuild(const double *data, size_t size);
+
+	/*
+	 * Extends the summary with data[numSamples(), size). The samples
+	 * already summarized must not have changed since the last call.
+	 */
+	void append(const double *data, size_t size);
+
+	void clear();
+
+	size_t numSamples() const { return d_size; }
+	size_t numLevels() const { return d_levels.size(); }
+
+	size_t bucketSize(size_t level) const;
+	size_t numBuckets(size_t level) const;
+
+	/*
+	 * Returns the coarsest level whose buckets hold at most
+	 * samplesPerBucket samples, or -1 if even level 0 is too coarse.
+	 */
+	int levelFor(double samplesPerBucket) const;
+
+	const double *min(size_t level) const { return d_levels[level].min.data(); }
+	const double *max(size_t level) const { return d_levels[level].max.data(); }
+
+private:
+	struct Level {
+		std::vector<double> min;
+		std::vector<double> max;
+	};
+
+	void buildBase(const double *data, size_t from, size_t to);
+	void buildLevel(size_t level, size_t fromBucket);
+
+	std::vector<Level> d_levels;
+	size_t d_size;
+};
+
+} /* namespace adiscope */
+
+#endif /* MINMAX_PYRAMID_HPP */
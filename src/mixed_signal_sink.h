@@ -25,6 +25,7 @@
 
 #include "logicanalyzer/logic_analyzer.h"
 #include "TimeDomainDisplayPlot.h"
+#include "frame_exchange.hpp"
 
 class mixed_signal_sink : virtual public gr::sync_block
 {
@@ -39,6 +40,8 @@ public:
 	virtual void set_nsamps(int newsize) = 0;
 	virtual void set_displayOneBuffer(bool display) = 0;
 	virtual void set_update_time(double t) = 0;
+
+	virtual const adiscope::FrameCounters &frame_counters() const = 0;
 };
 
 #endif // MIXED_SIGNAL_SINK_H
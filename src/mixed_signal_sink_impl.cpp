@@ -42,6 +42,7 @@ mixed_signal_sink_impl::mixed_signal_sink_impl(adiscope::logic::LogicAnalyzer *l
 		     io_signature::make(0, 0, 0))
 	, d_logic_analyzer(logicAnalyzer)
 	, d_osc_plot(oscPlot)
+	, d_exchange(std::make_shared<adiscope::FrameExchange>())
 	, d_size(bufferSize)
 	, d_buffer_size(2 * bufferSize)
 	, d_index(0)
@@ -61,10 +62,6 @@ mixed_signal_sink_impl::mixed_signal_sink_impl(adiscope::logic::LogicAnalyzer *l
 		d_analog_buffer.push_back(
 					static_cast<float*>(volk_malloc(d_buffer_size * sizeof(float), volk_get_alignment())));
 		memset(d_analog_buffer[i], 0, d_buffer_size * sizeof(float));
-
-		d_analog_plot_buffers.push_back(
-					static_cast<double*>(volk_malloc(d_buffer_size * sizeof(double), volk_get_alignment())));
-		memset(d_analog_plot_buffers[i], 0, d_buffer_size * sizeof(double));
 	}
 
 	set_update_time(1/60.0);
@@ -113,20 +110,23 @@ int mixed_signal_sink_impl::work(int noutput_items,
 			}
 		}
 
-		for (int i = 0; i < 2; ++i) {
-			volk_32f_convert_64f(d_analog_plot_buffers[i], &d_analog_buffer[i][d_start], nitemsToSend);
-		}
-
 		if (gr::high_res_timer_now() - d_last_time > d_update_time
 				|| !d_cleanBuffers) {
 
 			d_last_time = gr::high_res_timer_now();
 			d_logic_analyzer->setData(d_digital_buffer + d_start, nitemsToSend);
-			qApp->postEvent(d_osc_plot,
-					new IdentifiableTimeUpdateEvent(d_analog_plot_buffers,
-									nitemsToSend,
-									d_tags,
-									"Osc Time"));
+
+			adiscope::TimeFrame &frame = d_exchange->back(2, d_size);
+			for (int i = 0; i < 2; ++i) {
+				volk_32f_convert_64f(frame.channel(i), &d_analog_buffer[i][d_start], nitemsToSend);
+			}
+
+			if (d_exchange->publish(0, nitemsToSend)) {
+				qApp->postEvent(d_osc_plot,
+						new FrameReadyEvent(d_exchange, "Osc Time"));
+			}
+		} else {
+			d_exchange->drop();
 		}
 
 		if (d_display_one_buffer) {
@@ -150,7 +150,6 @@ void mixed_signal_sink_impl::clean_buffers()
 
 	for (int i = 0; i < 2; ++i) {
 		memset(d_analog_buffer[i], 0, d_buffer_size * sizeof(float));
-		memset(d_analog_plot_buffers[i], 0, d_buffer_size * sizeof(double));
 	}
 
 	_reset();
@@ -170,11 +169,8 @@ void mixed_signal_sink_impl::set_nsamps(int newsize)
 		volk_free(d_digital_buffer);
 		for (int i = 0; i < 2; ++i) {
 			volk_free(d_analog_buffer[i]);
-			volk_free(d_analog_plot_buffers[i]);
-
 		}
 		d_analog_buffer.clear();
-		d_analog_plot_buffers.clear();
 
 		// create new buffers
 		d_digital_buffer = static_cast<uint16_t*>(volk_malloc(d_buffer_size * sizeof(uint16_t), volk_get_alignment()));
@@ -184,9 +180,6 @@ void mixed_signal_sink_impl::set_nsamps(int newsize)
 			d_analog_buffer.push_back(
 						static_cast<float*>(volk_malloc(d_buffer_size * sizeof(float), volk_get_alignment())));
 			memset(d_analog_buffer[i], 0, d_buffer_size * sizeof(float));
-			d_analog_plot_buffers.push_back(
-						static_cast<double*>(volk_malloc(d_buffer_size * sizeof(double), volk_get_alignment())));
-			memset(d_analog_plot_buffers[i], 0, d_buffer_size * sizeof(double));
 		}
 
 		_reset();
@@ -201,6 +194,11 @@ void mixed_signal_sink_impl::set_update_time(double t)
   d_last_time = 0;
 }
 
+const adiscope::FrameCounters &mixed_signal_sink_impl::frame_counters() const
+{
+	return d_exchange->counters();
+}
+
 void mixed_signal_sink_impl::set_displayOneBuffer(bool display)
 {
 	if (d_display_one_buffer != display) {
@@ -38,6 +38,8 @@ public:
 	void set_displayOneBuffer(bool display) override;
 	void set_update_time(double t) override;
 
+	const adiscope::FrameCounters &frame_counters() const override;
+
 private:
 	void _adjust_tags(int adj);
 	void _test_trigger_tags(int nitems);
@@ -48,7 +50,7 @@ private:
 	adiscope::TimeDomainDisplayPlot *d_osc_plot;
 
 	std::vector<float*> d_analog_buffer;
-	std::vector<double*> d_analog_plot_buffers;
+	std::shared_ptr<adiscope::FrameExchange> d_exchange;
 	uint16_t *d_digital_buffer;
 
 	int d_size;
@@ -23,7 +23,6 @@
 
 /* GNU Radio includes */
 #include <gnuradio/blocks/float_to_complex.h>
-#include <scopy/math.h>
 #include <gnuradio/blocks/sub.h>
 #include <gnuradio/filter/iir_filter_ffd.h>
 #include <gnuradio/blocks/nlog10_ff.h>
@@ -188,6 +187,7 @@ Oscilloscope::Oscilloscope(struct iio_context *ctx, Filter *filt,
 
 	this->qt_time_block = adiscope::scope_sink_f::make(0, active_sample_rate,
 		"Osc Time", nb_channels, (QObject *)&plot);
+	m_persistence = std::make_shared<PersistenceRaster>(nb_channels);
 
 	this->qt_fft_block = adiscope::scope_sink_f::make(fft_plot_size, active_sample_rate,
 			"Osc Frequency", nb_channels, (QObject *)&fft_plot);
@@ -197,6 +197,9 @@ Oscilloscope::Oscilloscope(struct iio_context *ctx, Filter *filt,
 
 	this->qt_xy_block = adiscope::xy_sink_c::make(
 			400, "Osc XY", nb_channels / 2, (QObject*)&xy_plot);
+	m_xy_density = std::make_shared<PersistenceRaster>(nb_channels / 2,
+							   256, 256);
+	m_xy_density_persistence = false;
 
 	this->qt_time_block->set_trigger_mode(TRIG_MODE_TAG, 0, "buffer_start");
 
@@ -503,6 +506,10 @@ Oscilloscope::Oscilloscope(struct iio_context *ctx, Filter *filt,
 		plot.Curve(i)->setTitle("CH " + QString::number(i + 1));
 	}
 
+	math_engine = gnuradio::get_initial_sptr(
+			new math_engine_ff(nb_channels, MAX_MATH_CHANNELS));
+	math_engine->set_range(MIN_MATH_RANGE, MAX_MATH_RANGE);
+
 	if (started)
 		iio->unlock();
 
@@ -845,12 +852,6 @@ Oscilloscope::Oscilloscope(struct iio_context *ctx, Filter *filt,
 
 		auto max_elem = max_element(probe_attenuation.begin(), probe_attenuation.begin() + nb_channels);
 
-		auto const values = math_rails.values();
-		for (auto rail : values) {
-			rail->set_lo(MIN_MATH_RANGE);
-			rail->set_hi(MAX_MATH_RANGE);
-		}
-
 		if (started)
 			iio->unlock();
 
@@ -1004,7 +1005,7 @@ void Oscilloscope::resetHistogramDataPoints()
 	int posMin = binSearchPointOnXaxis(zoomMinTime);
 	int posMax = binSearchPointOnXaxis(zoomMaxTime);
 
-	hist_plot.setDataInterval(posMin, posMax + 1);
+	qt_hist_block->set_data_interval(posMin, posMax + 1);
 }
 
 bool Oscilloscope::isIioManagerStarted() const
@@ -2127,6 +2128,135 @@ void Oscilloscope::btnExport_clicked(){
 	pause(false);
 }
 
+void Oscilloscope::setSegmentCount(unsigned int count)
+{
+	if (count == segmentCount()) {
+		return;
+	}
+
+	if (count == 0) {
+		m_segments = nullptr;
+	} else {
+		// The sink sizes the segments after its own buffer
+		m_segments = std::make_shared<SegmentBuffer>(nb_channels,
+				active_plot_sample_count, count);
+	}
+
+	qt_time_block->set_segment_buffer(m_segments);
+	plot.setSegmentBuffer(qt_time_block->name(), m_segments);
+}
+
+unsigned int Oscilloscope::segmentCount() const
+{
+	return m_segments ? m_segments->numSegments() : 0;
+}
+
+void Oscilloscope::setPersistenceEnabled(bool en)
+{
+	if (en == persistenceEnabled()) {
+		return;
+	}
+
+	// The raster is kept while disabled so that its settings survive
+	m_persistence->clear();
+	qt_time_block->set_persistence_raster(en ? m_persistence : nullptr);
+	plot.setPersistenceRaster(qt_time_block->name(),
+				  en ? m_persistence : nullptr);
+	plot.setPersistenceVisible(en);
+}
+
+bool Oscilloscope::persistenceEnabled() const
+{
+	return plot.persistenceVisible();
+}
+
+void Oscilloscope::setXyDensityEnabled(bool en)
+{
+	if (en == xyDensityEnabled()) {
+		return;
+	}
+
+	m_xy_density->clear();
+	qt_xy_block->set_density_raster(en ? m_xy_density : nullptr);
+	xy_plot.setDensityRaster(en ? m_xy_density : nullptr);
+	xy_plot.setDensityVisible(en);
+}
+
+bool Oscilloscope::xyDensityEnabled() const
+{
+	return xy_plot.densityVisible();
+}
+
+void Oscilloscope::setXyDensityPersistence(bool en)
+{
+	m_xy_density_persistence = en;
+	m_xy_density->clear();
+	qt_xy_block->set_density_persistence(en);
+}
+
+void Oscilloscope::frameStatistics(unsigned long long &produced,
+				   unsigned long long &delivered,
+				   unsigned long long &dropped) const
+{
+	std::vector<const FrameCounters *> counters = {
+		&qt_time_block->frame_counters(),
+		&qt_fft_block->frame_counters(),
+		&qt_xy_block->frame_counters(),
+		&qt_hist_block->frame_counters(),
+	};
+
+	if (mixed_sink) {
+		counters.push_back(&mixed_sink->frame_counters());
+	}
+
+	produced = 0;
+	delivered = 0;
+	dropped = 0;
+
+	for (const FrameCounters *c : counters) {
+		produced += c->produced;
+		delivered += c->delivered;
+		dropped += c->dropped;
+	}
+}
+
+bool Oscilloscope::exportSegments(const QString &fileName)
+{
+	if (!m_segments || m_segments->count() == 0 || fileName.isEmpty()) {
+		return false;
+	}
+
+	const unsigned int count = m_segments->count();
+	const unsigned int channels = m_segments->numChannels();
+	const size_t size = m_segments->segmentSize();
+	const std::vector<double> timestamps = m_segments->timestamps();
+
+	FileManager fm("Oscilloscope");
+	fm.open(fileName, FileManager::EXPORT);
+
+	QVector<double> time_data;
+	for (size_t i = 0; i < size; i++) {
+		time_data.push_back((plot.dataStartingPoint() + (double)i)
+				    / active_sample_rate);
+	}
+	fm.save(time_data, "Time(S)");
+
+	for (unsigned int seg = 0; seg < count; seg++) {
+		for (unsigned int ch = 0; ch < channels; ch++) {
+			QVector<double> data(size);
+			m_segments->copySegment(seg, ch, data.data());
+
+			fm.save(data, QString("S%1 CH%2(V) @%3s").arg(seg + 1)
+				.arg(ch + 1).arg(timestamps[seg], 0, 'g', 9));
+		}
+	}
+
+	fm.setSampleRate(active_sample_rate);
+	fm.performWrite();
+
+	return true;
+}
+
 void Oscilloscope::create_add_channel_panel()
 {
 	/* Math stuff */
@@ -2462,14 +2592,70 @@ unsigned int Oscilloscope::find_curve_number()
 	return id - 1;
 }
 
+/* The next three are called with the flowgraph locked */
+void Oscilloscope::connectMathEngine()
+{
+	if (math_sinks.isEmpty()) {
+		return;
+	}
+
+	std::vector<std::string> functions;
+	for (const auto &p : qAsConst(math_sinks)) {
+		functions.push_back(p.first);
+	}
+
+	math_engine->set_functions(functions);
+
+	for (unsigned int i = 0; i < nb_channels; i++) {
+		iio->connect(math_probe_atten.at(i), 0, math_engine, i);
+	}
+
+	int port = 0;
+	for (const auto &p : qAsConst(math_sinks)) {
+		iio->connect(math_engine, port++, p.second, 0);
+	}
+}
+
+void Oscilloscope::disconnectMathEngine()
+{
+	if (math_sinks.isEmpty()) {
+		return;
+	}
+
+	for (unsigned int i = 0; i < nb_channels; i++) {
+		iio->disconnect(math_probe_atten.at(i), 0, math_engine, i);
+	}
+
+	int port = 0;
+	for (const auto &p : qAsConst(math_sinks)) {
+		iio->disconnect(math_engine, port++, p.second, 0);
+	}
+}
+
+/* Detaches the XY plot from its sources until setup_xy_channels() is
+ * called again, e.g. before the ports of the math engine move */
+void Oscilloscope::disconnectXyInputs()
+{
+	if (!xy_is_visible || xy_channels.empty()) {
+		return;
+	}
+
+	iio->disconnect(xy_channels.at(index_x).first,
+			xy_channels.at(index_x).second, ftc, 0);
+	iio->disconnect(xy_channels.at(index_y).first,
+			xy_channels.at(index_y).second, ftc, 1);
+	xy_channels.clear();
+}
+
 void Oscilloscope::add_math_channel(const std::string& function)
 {
 	if (nb_math_channels + nb_ref_channels == MAX_MATH_CHANNELS) {
 		return;
 	}
 
-	auto rail = gr::analog::rail_ff::make(MIN_MATH_RANGE, MAX_MATH_RANGE);
-	auto math = gr::scopy::iio_math::make(function, nb_channels);
+	/* Throws before anything changes if the function is not valid */
+	MathProgram::validate(function, nb_channels);
+
 	unsigned int curve_id = nb_channels + nb_math_channels + nb_ref_channels;
 	unsigned int curve_number = find_curve_number();
 
@@ -2485,13 +2671,6 @@ void Oscilloscope::add_math_channel(const std::string& function)
 
 	double targetFps = getScopyPreferences()->getTarget_fps();
 	math_sink->set_update_time(1.0/targetFps);
-	/* Add the math block and the math scope sink into a container, so that
-	 * we can disconnect them when removing the math channel later */
-	auto math_pair = QPair<gr::basic_block_sptr, gr::basic_block_sptr>(
-				math, math_sink);
-	math_sinks.insert(qname, math_pair);
-	math_rails.insert(qname, rail);
-
 	/* Lock the flowgraph if we are already started */
 	bool started = isIioManagerStarted();
 	if (started)
@@ -2499,11 +2678,18 @@ void Oscilloscope::add_math_channel(const std::string& function)
 
 	math_sink->set_trigger_mode(TRIG_MODE_TAG, 0, "buffer_start");
 
-	for (unsigned int i = 0; i < nb_channels; i++) {
-		iio->connect(math_probe_atten.at(i), 0, math, i);
+	/* The new output may shift the ports of the math engine, so the
+	 * engine is rewired with the function added to its program */
+	locked = true;
+	disconnectXyInputs();
+	disconnectMathEngine();
+	math_sinks.insert(qname, QPair<std::string, gr::basic_block_sptr>(
+				  function, math_sink));
+	connectMathEngine();
+	if (xy_is_visible) {
+		setup_xy_channels();
 	}
-	iio->connect(math, 0, rail, 0);
-	iio->connect(rail, 0, math_sink, 0);
+	locked = false;
 
 	if (started)
 		iio->unlock();
@@ -2666,16 +2852,12 @@ void Oscilloscope::onChannelWidgetDeleteClicked()
 		gsettings_ui->cmb_y_channel->blockSignals(false);
 		setup_xy_channels();
 
-		/* Disconnect the blocks from the running flowgraph */
-		auto pair = math_sinks.take(qname);
-		auto rail = math_rails.take(qname);
-
-		for (unsigned int i = 0; i < nb_channels; i++) {
-			iio->disconnect(math_probe_atten.at(i), 0, pair.first, i);
-		}
-
-		iio->disconnect(pair.first, 0, rail, 0);
-		iio->disconnect(rail, 0, pair.second, 0);
+		/* Disconnect the sink from the running flowgraph and
+		 * rewire the math engine without its function */
+		disconnectXyInputs();
+		disconnectMathEngine();
+		math_sinks.remove(qname);
+		connectMathEngine();
 
 		if (xy_is_visible) {
 			setup_xy_channels();
@@ -2921,6 +3103,16 @@ void Oscilloscope::runStopToggled(bool checked)
 
 		setTrigger_input(false);
 
+		m_persistence->clear();
+		m_xy_density->clear();
+
+		if (m_segments) {
+			// A single run stops once every segment was captured
+			m_segments->setOverwrite(
+				!ui->runSingleWidget->singleButtonChecked());
+			m_segments->clear();
+		}
+
 		resetStreamingFlag(symmBufferMode->isEnhancedMemDepth()
 				   || plot_samples_sequentially);
 		toggle_blockchain_flow(true);
@@ -3123,7 +3315,8 @@ void Oscilloscope::onXY_view_toggled(bool visible)
 		iio->lock();
 
 	if (visible) {
-		if(xy_is_visible && index_x == gsettings_ui->cmb_x_channel->currentIndex()
+		if(xy_is_visible && !xy_channels.empty()
+				&& index_x == gsettings_ui->cmb_x_channel->currentIndex()
 				&& index_y == gsettings_ui->cmb_y_channel->currentIndex())
 		{
 			xy_is_visible = visible;
@@ -3162,10 +3355,9 @@ void Oscilloscope::onXY_view_toggled(bool visible)
 								      adc_samp_conv_block, i));
 				}
 			}
-			for(const auto &p : qAsConst(math_sinks)) {
-				auto math = p.first;
+			for(int port = 0; port < math_sinks.size(); port++) {
 				xy_channels.push_back(QPair<gr::basic_block_sptr, int>(
-							      math, 0));
+							      math_engine, port));
 			}
 		}
 
@@ -4209,8 +4401,7 @@ void Oscilloscope::editMathChannelFunction(int id, const std::string& new_functi
 	QString qname = chn_widget->deleteButton()->property("curve_name").toString();
 	std::string name = qname.toStdString();
 
-	auto rail = gr::analog::rail_ff::make(MIN_MATH_RANGE, MAX_MATH_RANGE);
-	auto math = gr::scopy::iio_math::make(new_function, nb_channels);
+	MathProgram::validate(new_function, nb_channels);
 
 	bool started = isIioManagerStarted();
 	if (started)
@@ -4227,25 +4418,10 @@ void Oscilloscope::editMathChannelFunction(int id, const std::string& new_functi
 		gsettings_ui->cmb_y_channel->blockSignals(false);
 		setup_xy_channels();
 	}
-	auto pair = math_sinks.value(qname);
-	auto rail_old = math_rails.value(qname);
-	for (unsigned int i = 0; i < nb_channels; ++i) {
-		iio->disconnect(math_probe_atten.at(i), 0, pair.first, i);
-	}
-	iio->disconnect(pair.first, 0, rail_old, 0);
-	iio->disconnect(rail_old, 0, pair.second, 0);
-
-	auto math_pair = QPair<gr::basic_block_sptr, gr::basic_block_sptr>(
-				math, pair.second);
-
-	math_sinks.insert(qname, math_pair);
-	math_rails.insert(qname, rail);
-
-	for (unsigned int i = 0; i < nb_channels; ++i) {
-		iio->connect(math_probe_atten.at(i), 0, math, i);
-	}
-	iio->connect(math, 0, rail, 0);
-	iio->connect(rail, 0, pair.second, 0);
+	disconnectXyInputs();
+	disconnectMathEngine();
+	math_sinks[qname].first = new_function;
+	connectMathEngine();
 
 	if(xy_is_visible) {
 		gsettings_ui->cmb_x_channel->blockSignals(true);
@@ -4967,7 +5143,8 @@ void Oscilloscope::singleCaptureDone()
 	if (!symmBufferMode->isEnhancedMemDepth()
 			&& !plot_samples_sequentially) {
 		Q_EMIT activateExportButton();
-		if (ui->runSingleWidget->singleButtonChecked()){
+		if (ui->runSingleWidget->singleButtonChecked()
+				&& (!m_segments || m_segments->full())){
 			Q_EMIT startRunning(false);
 		}
 	}
@@ -5000,7 +5177,9 @@ void Oscilloscope::scaleHistogramPlot(bool newData)
 
 		hist_plot.setYaxisSpan(i, min, max);
 	}
-	hist_plot.setAutoScaleX();
+	if (hist_plot.getOrientation() == Qt::Horizontal) {
+		qt_hist_block->autoscale_x();
+	}
 }
 
 void Oscilloscope::onFilledScreen(bool full, unsigned int nb_samples)
@@ -27,7 +27,6 @@
 #include <gnuradio/blocks/short_to_float.h>
 #include <iio/device_source.h>
 #include <gnuradio/blocks/complex_to_mag_squared.h>
-#include <gnuradio/analog/rail_ff.h>
 #include <gnuradio/blocks/keep_one_in_n.h>
 #include <gnuradio/blocks/vector_sink.h>
 #include <gnuradio/blocks/multiply_const.h>
@@ -55,6 +54,7 @@
 #include "scope_sink_f.h"
 #include "xy_sink_c.h"
 #include "histogram_sink_f.h"
+#include "math_engine_ff.hpp"
 #include "ConstellationDisplayPlot.h"
 #include "FftDisplayPlot.h"
 #include "HistogramDisplayPlot.h"
@@ -256,6 +256,24 @@ namespace adiscope {
 		void stop() override;
 
 	private:
+		/* Segmented acquisition; 0 segments turns it off */
+		void setSegmentCount(unsigned int count);
+		unsigned int segmentCount() const;
+		bool exportSegments(const QString &fileName);
+
+		void setPersistenceEnabled(bool en);
+		bool persistenceEnabled() const;
+
+		/* XY view drawn as a density image instead of points */
+		void setXyDensityEnabled(bool en);
+		bool xyDensityEnabled() const;
+		void setXyDensityPersistence(bool en);
+
+		/* Frame counters summed over all the plot sinks */
+		void frameStatistics(unsigned long long &produced,
+				     unsigned long long &delivered,
+				     unsigned long long &dropped) const;
+
 		libm2k::context::M2k* m_m2k_context;
 		libm2k::analog::M2kAnalogIn* m_m2k_analogin;
 		libm2k::digital::M2kDigital* m_m2k_digital;
@@ -336,15 +354,21 @@ namespace adiscope {
 		std::shared_ptr<SymmetricBufferMode> symmBufferMode;
 
 		adiscope::scope_sink_f::sptr qt_time_block;
+		std::shared_ptr<SegmentBuffer> m_segments;
+		std::shared_ptr<PersistenceRaster> m_persistence;
+		std::shared_ptr<PersistenceRaster> m_xy_density;
+		bool m_xy_density_persistence;
 		adiscope::scope_sink_f::sptr qt_fft_block;
 		adiscope::xy_sink_c::sptr qt_xy_block;
 		adiscope::histogram_sink_f::sptr qt_hist_block;
 		boost::shared_ptr<iio_manager> iio;
 		gr::basic_block_sptr adc_samp_conv_block;
 
-		QMap<QString, QPair<gr::basic_block_sptr,
+		/* Function and sink of every math channel; all of them are
+		 * computed by math_engine, output i feeding the i-th sink */
+		QMap<QString, QPair<std::string,
 		gr::basic_block_sptr>> math_sinks;
-		QMap<QString, boost::shared_ptr<gr::analog::rail_ff>> math_rails;
+		boost::shared_ptr<adiscope::math_engine_ff> math_engine;
 		std::vector<boost::shared_ptr<gr::blocks::multiply_const_ff>> math_probe_atten;
 
 		iio_manager::port_id *ids;
@@ -421,6 +445,9 @@ namespace adiscope {
 		void toggleRightMenu(CustomPushButton *, bool checked);
 		void create_add_channel_panel();
 		void add_math_channel(const std::string& function);
+		void connectMathEngine();
+		void disconnectMathEngine();
+		void disconnectXyInputs();
 		unsigned int find_curve_number();
 		ChannelWidget *channelWidgetAtId(int id);
 		void update_measure_for_channel(int ch_idx);
@@ -28,6 +28,9 @@
 #include "ui_channel_settings.h"
 #include "ui_osc_general_settings.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace adiscope
 {
 /*
@@ -393,6 +396,173 @@ void Oscilloscope_API::show()
 	Q_EMIT osc->showTool();
 }
 
+int Oscilloscope_API::getSegments() const
+{
+	return osc->segmentCount();
+}
+
+void Oscilloscope_API::setSegments(int count)
+{
+	osc->setSegmentCount(std::max(count, 0));
+}
+
+bool Oscilloscope_API::getSegmentOverlay() const
+{
+	return osc->plot.segmentOverlayVisible();
+}
+
+void Oscilloscope_API::setSegmentOverlay(bool en)
+{
+	osc->plot.setSegmentOverlayVisible(en);
+}
+
+int Oscilloscope_API::segmentsCaptured() const
+{
+	return osc->m_segments ? osc->m_segments->count() : 0;
+}
+
+QList<double> Oscilloscope_API::segmentTimestamps() const
+{
+	QList<double> list;
+
+	if (osc->m_segments) {
+		for (double t : osc->m_segments->timestamps())
+			list.append(t);
+	}
+
+	return list;
+}
+
+bool Oscilloscope_API::showSegment(int index)
+{
+	if (index < 0)
+		return false;
+
+	return osc->plot.showSegment(index);
+}
+
+bool Oscilloscope_API::exportSegments(const QString &fileName)
+{
+	return osc->exportSegments(fileName);
+}
+
+bool Oscilloscope_API::getPersistence() const
+{
+	return osc->persistenceEnabled();
+}
+
+void Oscilloscope_API::setPersistence(bool en)
+{
+	osc->setPersistenceEnabled(en);
+}
+
+double Oscilloscope_API::getPersistenceDecay() const
+{
+	return osc->m_persistence->decay();
+}
+
+void Oscilloscope_API::setPersistenceDecay(double seconds)
+{
+	osc->m_persistence->setDecay(seconds);
+}
+
+bool Oscilloscope_API::getXyDensity() const
+{
+	return osc->xyDensityEnabled();
+}
+
+void Oscilloscope_API::setXyDensity(bool en)
+{
+	osc->setXyDensityEnabled(en);
+}
+
+bool Oscilloscope_API::getXyPersistence() const
+{
+	return osc->m_xy_density_persistence;
+}
+
+void Oscilloscope_API::setXyPersistence(bool en)
+{
+	osc->setXyDensityPersistence(en);
+}
+
+double Oscilloscope_API::getXyPersistenceDecay() const
+{
+	return osc->m_xy_density->decay();
+}
+
+void Oscilloscope_API::setXyPersistenceDecay(double seconds)
+{
+	osc->m_xy_density->setDecay(seconds);
+}
+
+int Oscilloscope_API::captureSequence() const
+{
+	return osc->plot.captureSequence();
+}
+
+int Oscilloscope_API::measuredSequence() const
+{
+	return osc->plot.measureWorker()->lastSequence();
+}
+
+int Oscilloscope_API::measureSkipped() const
+{
+	return osc->plot.measureWorker()->skippedCount();
+}
+
+double Oscilloscope_API::measureSkipRate() const
+{
+	return osc->plot.measureWorker()->skipRate();
+}
+
+double Oscilloscope_API::framesProduced() const
+{
+	unsigned long long produced, delivered, dropped;
+
+	osc->frameStatistics(produced, delivered, dropped);
+	return produced;
+}
+
+double Oscilloscope_API::framesDelivered() const
+{
+	unsigned long long produced, delivered, dropped;
+
+	osc->frameStatistics(produced, delivered, dropped);
+	return delivered;
+}
+
+double Oscilloscope_API::framesDropped() const
+{
+	unsigned long long produced, delivered, dropped;
+
+	osc->frameStatistics(produced, delivered, dropped);
+	return dropped;
+}
+
+QList<double> Oscilloscope_API::measurementsForCapture(int sequence,
+						       int channel) const
+{
+	QList<double> list;
+	CaptureMeasurements results;
+
+	if (!osc->plot.measureWorker()->results(sequence, results))
+		return list;
+
+	for (const ChannelMeasurements &chn : results.channels) {
+		if (chn.channel != channel)
+			continue;
+
+		for (int i = 0; i < chn.values.size(); i++) {
+			list.append(chn.measured[i] ? chn.values[i] :
+				    std::numeric_limits<double>::quiet_NaN());
+		}
+		break;
+	}
+
+	return list;
+}
+
 bool Oscilloscope_API::running() const
 {
 	return osc->ui->runSingleWidget->runButtonChecked() || osc->ui->runSingleWidget->singleButtonChecked();
@@ -128,6 +128,54 @@ class Oscilloscope_API : public ApiObject
 
 	Q_PROPERTY(QString notes READ getNotes WRITE setNotes)
 
+	/**
+	  * @brief Number of segments kept in segmented acquisition mode,
+	  * 0 disables it
+	  */
+	Q_PROPERTY(int segments READ getSegments WRITE setSegments)
+	Q_PROPERTY(bool segment_overlay READ getSegmentOverlay
+		   WRITE setSegmentOverlay)
+	Q_PROPERTY(int segments_captured READ segmentsCaptured STORED false)
+	Q_PROPERTY(QList<double> segment_timestamps
+		   READ segmentTimestamps STORED false)
+
+	/**
+	  * @brief Accumulates every captured waveform into an intensity
+	  * graded image; hits fade with the given time constant in seconds,
+	  * 0 keeping them until the next run
+	  */
+	Q_PROPERTY(bool persistence READ getPersistence WRITE setPersistence)
+	Q_PROPERTY(double persistence_decay READ getPersistenceDecay
+		   WRITE setPersistenceDecay)
+
+	/**
+	  * @brief Draws the XY view as a density image binned by the sink;
+	  * with persistence the buffers add up, fading with the given time
+	  * constant in seconds (0 keeps them until the next run)
+	  */
+	Q_PROPERTY(bool xy_density READ getXyDensity WRITE setXyDensity)
+	Q_PROPERTY(bool xy_persistence READ getXyPersistence
+		   WRITE setXyPersistence)
+	Q_PROPERTY(double xy_persistence_decay READ getXyPersistenceDecay
+		   WRITE setXyPersistenceDecay)
+
+	/**
+	  * @brief Measurements run in the background and may skip captures
+	  * when they cannot keep up with the acquisition rate
+	  */
+	Q_PROPERTY(int capture_sequence READ captureSequence STORED false)
+	Q_PROPERTY(int measured_sequence READ measuredSequence STORED false)
+	Q_PROPERTY(int measure_skipped READ measureSkipped STORED false)
+	Q_PROPERTY(double measure_skip_rate READ measureSkipRate STORED false)
+
+	/**
+	  * @brief Frames handed from the acquisition to the plots: produced
+	  * ones are either delivered or dropped when the GUI lags behind
+	  */
+	Q_PROPERTY(double frames_produced READ framesProduced STORED false)
+	Q_PROPERTY(double frames_delivered READ framesDelivered STORED false)
+	Q_PROPERTY(double frames_dropped READ framesDropped STORED false)
+
 public:
 	explicit Oscilloscope_API(Oscilloscope *osc) :
 		ApiObject(), osc(osc) {}
@@ -268,8 +316,55 @@ public:
 	QString getNotes();
 	void setNotes(QString);
 
+	int getSegments() const;
+	void setSegments(int count);
+
+	bool getSegmentOverlay() const;
+	void setSegmentOverlay(bool en);
+
+	int segmentsCaptured() const;
+	QList<double> segmentTimestamps() const;
+
+	bool getPersistence() const;
+	void setPersistence(bool en);
+
+	double getPersistenceDecay() const;
+	void setPersistenceDecay(double seconds);
+
+	bool getXyDensity() const;
+	void setXyDensity(bool en);
+
+	bool getXyPersistence() const;
+	void setXyPersistence(bool en);
+
+	double getXyPersistenceDecay() const;
+	void setXyPersistenceDecay(double seconds);
+
+	int captureSequence() const;
+	int measuredSequence() const;
+	int measureSkipped() const;
+	double measureSkipRate() const;
+
+	double framesProduced() const;
+	double framesDelivered() const;
+	double framesDropped() const;
+
 	Q_INVOKABLE void show();
 
+	/**
+	  * @brief Plots a stored segment, 0 being the oldest one
+	  */
+	Q_INVOKABLE bool showSegment(int index);
+	Q_INVOKABLE bool exportSegments(const QString &fileName);
+
+	/**
+	  * @brief Values of all the measurements of a channel for one of the
+	  * recently measured captures, NaN where a value could not be measured.
+	  * Returns an empty list if that capture was skipped or is too old.
+	  */
+	Q_INVOKABLE QList<double> measurementsForCapture(int sequence,
+							 int channel) const;
+
 	private:
 		Oscilloscope *osc;
 	};
@@ -68,6 +68,7 @@ CapturePlot::CapturePlot(QWidget *parent,  bool isdBgraph, unsigned int xNumDivs
 	d_bufferSizeLabelVal(0),
 	d_sampleRateLabelVal(1.0),
 	d_labelsEnabled(false),
+	d_captureSequence(0),
 	d_timeTriggerMinValue(-1),
 	d_timeTriggerMaxValue(1),
 	d_bonusWidth(0),
@@ -352,6 +353,8 @@ CapturePlot::CapturePlot(QWidget *parent,  bool isdBgraph, unsigned int xNumDivs
 	/* Apply measurements for every new batch of data */
 	connect(this, SIGNAL(newData()),
 		SLOT(onNewDataReceived()));
+	connect(&d_measureWorker, &MeasureWorker::resultsReady,
+		this, &CapturePlot::onMeasurementsReady);
 
 	/* Add offset widgets for each new channel */
 	connect(this, SIGNAL(channelAdded(int)),
@@ -738,6 +741,10 @@ int CapturePlot::selectedChannel()
 void CapturePlot::setMeasuremensEnabled(bool en)
 {
 	d_measurementsEnabled = en;
+
+	if (!en) {
+		d_measureWorker.discardPending();
+	}
 }
 
 bool CapturePlot::measurementsEnabled()
@@ -1789,6 +1796,7 @@ void CapturePlot::onChannelAdded(int chnIdx)
 
 	measure->setAdcBitCount(12);
 	d_measureObjs.push_back(measure);
+	d_measureWorker.discardPending();
 }
 
 void CapturePlot::computeMeasurementsForChannel(unsigned int chnIdx, unsigned int sampleRate)
@@ -1824,6 +1832,9 @@ void CapturePlot::cleanUpJustBeforeChannelRemoval(int chnIdx)
 		}
 		d_measureObjs.removeOne(measure);
 		delete measure;
+
+		/* Results in flight refer to the old channel indexes */
+		d_measureWorker.discardPending();
 	}
 }
 
@@ -1901,6 +1912,9 @@ int CapturePlot::activeMeasurementsCount(int chnIdx)
 void CapturePlot::onNewDataReceived()
 {
 	int ref_idx = 0;
+
+	d_captureSequence++;
+
 	if(d_measurementsEnabled) {
 		for (int i = 0; i < d_measureObjs.size(); i++) {
 			Measure *measure = d_measureObjs[i];
@@ -1920,13 +1934,45 @@ void CapturePlot::onNewDataReceived()
 			}
 
 			measure->setSampleRate(this->sampleRate());
-			measure->measure();
 		}
 
-		Q_EMIT measurementsAvailable();
+		/* The worker copies the data; results come back in onMeasurementsReady() */
+		d_measureWorker.submit(d_captureSequence, d_measureObjs);
 	}
 }
 
+void CapturePlot::onMeasurementsReady(const CaptureMeasurements &results)
+{
+	if (!d_measurementsEnabled) {
+		return;
+	}
+
+	for (const ChannelMeasurements &chn : results.channels) {
+		Measure *measure = measureOfChannel(chn.channel);
+		if (!measure) {
+			continue;
+		}
+
+		auto data = measure->measurments();
+		for (int i = 0; i < data.size() && i < chn.values.size(); i++) {
+			data[i]->setValue(chn.values[i]);
+			data[i]->setMeasured(chn.measured[i]);
+		}
+	}
+
+	Q_EMIT measurementsAvailable();
+}
+
+quint64 CapturePlot::captureSequence() const
+{
+	return d_captureSequence;
+}
+
+const MeasureWorker *CapturePlot::measureWorker() const
+{
+	return &d_measureWorker;
+}
+
 QList<std::shared_ptr<MeasurementData>> CapturePlot::measurements(int chnIdx)
 {
 	Measure *measure = measureOfChannel(chnIdx);
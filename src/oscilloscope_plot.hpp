@@ -23,6 +23,7 @@
 
 #include "TimeDomainDisplayPlot.h"
 #include "gui/measure.h"
+#include "measure_worker.hpp"
 #include "gui/customplotpositionbutton.h"
 #include "graticule.h"
 
@@ -119,6 +120,9 @@ namespace adiscope {
 
 		void computeMeasurementsForChannel(unsigned int chnIdx, unsigned int sampleRate);
 
+		quint64 captureSequence() const;
+		const MeasureWorker *measureWorker() const;
+
 		void setConversionFunction(const std::function<double(unsigned int, double, bool)> &fp);
 
 		void enableXaxisLabels();
@@ -194,6 +198,7 @@ namespace adiscope {
 	private Q_SLOTS:
 		void onChannelAdded(int);
 		void onNewDataReceived();
+		void onMeasurementsReady(const adiscope::CaptureMeasurements &results);
 
 		void onGateBar1PixelPosChanged(int);
 		void onGateBar2PixelPosChanged(int);
@@ -266,6 +271,8 @@ namespace adiscope {
 		QPen d_timeTriggerActiveLinePen;
 
 	        QList<Measure *> d_measureObjs;
+		MeasureWorker d_measureWorker;
+		quint64 d_captureSequence;
 
 		double value_v1, value_v2, value_h1, value_h2;
 		double value_gateLeft, value_gateRight;
@@ -77,6 +77,7 @@ PatternGenerator::PatternGenerator(struct iio_context *ctx, Filter *filt,
 	, m_currentGroupMenu(nullptr)
 	, m_m2k_context(m2kOpen(ctx, ""))
 	, m_m2kDigital(m_m2k_context->getDigital())
+	, m_buffer(nullptr)
 	, m_bufferSize(1)
 	, m_sampleRate(1)
 	, m_diom(diom)
@@ -825,6 +826,7 @@ void PatternGenerator::generateBuffer()
 		pattern.second->get_pattern()->setNrOfChannels(pattern.first.size());
 	}
 
+	m_capture.assign(m_buffer, bufferSize);
 	Q_EMIT dataAvailable(0, bufferSize);
 }
 
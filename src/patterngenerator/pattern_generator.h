@@ -130,6 +130,7 @@ private:
 
 	M2k* m_m2k_context;
 	M2kDigital *m_m2kDigital;
+	uint16_t *m_buffer;
 	uint64_t m_bufferSize;
 	uint64_t m_sampleRate;
 
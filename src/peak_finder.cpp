@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "peak_finder.hpp"
+
+#include <algorithm>
+#include <limits>
+
+using namespace adiscope;
+
+/* Ranks the higher peak first, then the one with the lower bin */
+static bool higher(const PeakFinder::Peak &a, const PeakFinder::Peak &b)
+{
+	return a.value > b.value || (a.value == b.value && a.bin < b.bin);
+}
+
+PeakFinder::PeakFinder():
+	d_threshold(-std::numeric_limits<double>::infinity()),
+	d_minProminence(0)
+{
+}
+
+void PeakFinder::setThreshold(double threshold)
+{
+	d_threshold = threshold;
+}
+
+double PeakFinder::threshold() const
+{
+	return d_threshold;
+}
+
+void PeakFinder::setMinProminence(double prominence)
+{
+	d_minProminence = std::max(prominence, 0.0);
+}
+
+double PeakFinder::minProminence() const
+{
+	return d_minProminence;
+}
+
+const std::vector<PeakFinder::Peak> &PeakFinder::peaks() const
+{
+	return d_peaks;
+}
+
+const std::vector<unsigned int> &PeakFinder::byBin() const
+{
+	return d_byBin;
+}
+
+/*
+ * For every bin, the lowest value between it and the closest higher bin
+ * on each side (or the end of the range). A stack of the bins not yet
+ * exceeded, each with the minimum of the values that follow it, makes
+ * this linear.
+ */
+void PeakFinder::findBases(const double *y, size_t start, size_t stop)
+{
+	const double inf = std::numeric_limits<double>::infinity();
+	const size_t size = stop - start;
+
+	d_leftBase.resize(size);
+	d_rightBase.resize(size);
+
+	for (int side = 0; side < 2; side++) {
+		double *base = side ? d_rightBase.data() : d_leftBase.data();
+		double runMin = inf;
+
+		d_stack.clear();
+
+		for (size_t k = 0; k < size; k++) {
+			const size_t i = side ? size - 1 - k : k;
+			const double v = y[start + i];
+			double acc = d_stack.empty() ? inf : d_stack.back().min;
+
+			while (!d_stack.empty() && d_stack.back().value <= v) {
+				acc = std::min(acc, d_stack.back().value);
+				d_stack.pop_back();
+
+				if (!d_stack.empty()) {
+					acc = std::min(acc, d_stack.back().min);
+				}
+			}
+
+			// Nothing higher so far: the base is the end of the range
+			if (d_stack.empty()) {
+				acc = runMin;
+			} else {
+				d_stack.back().min = acc;
+			}
+
+			base[i] = std::min(acc, v);
+			d_stack.push_back({ v, inf });
+			runMin = std::min(runMin, v);
+		}
+	}
+}
+
+void PeakFinder::find(const double *y, size_t size, size_t start,
+		      size_t stop, unsigned int count)
+{
+	d_peaks.clear();
+	d_byBin.clear();
+
+	stop = std::min(stop, size);
+
+	// Every peak needs both neighbours
+	const size_t first = std::max<size_t>(start, 1);
+	const size_t last = std::min(stop, size - 1);
+
+	if (count == 0 || first >= last) {
+		return;
+	}
+
+	const size_t nb = last - first;
+	const double threshold = d_threshold;
+
+	d_mask.resize(nb);
+	unsigned char *mask = d_mask.data();
+	const double *p = y + first;
+
+	// Branch free so that the compiler can vectorize it. NaNs are never
+	// peaks.
+	for (size_t i = 0; i < nb; i++) {
+		mask[i] = (p[i] > p[i - 1]) & (p[i] >= p[i + 1]) &
+			(p[i] >= threshold);
+	}
+
+	findBases(y, start, stop);
+
+	const double *left = d_leftBase.data() + (first - start);
+	const double *right = d_rightBase.data() + (first - start);
+
+	// The worst of the peaks kept so far is on top of the heap
+	for (size_t i = 0; i < nb; i++) {
+		if (!mask[i]) {
+			continue;
+		}
+
+		const double prominence = p[i] - std::max(left[i], right[i]);
+
+		if (prominence < d_minProminence) {
+			continue;
+		}
+
+		const Peak peak = { first + i, p[i], prominence };
+
+		if (d_peaks.size() < count) {
+			d_peaks.push_back(peak);
+			std::push_heap(d_peaks.begin(), d_peaks.end(), higher);
+		} else if (higher(peak, d_peaks.front())) {
+			std::pop_heap(d_peaks.begin(), d_peaks.end(), higher);
+			d_peaks.back() = peak;
+			std::push_heap(d_peaks.begin(), d_peaks.end(), higher);
+		}
+	}
+
+	std::sort_heap(d_peaks.begin(), d_peaks.end(), higher);
+
+	d_byBin.resize(d_peaks.size());
+	for (unsigned int i = 0; i < d_byBin.size(); i++) {
+		d_byBin[i] = i;
+	}
+
+	std::sort(d_byBin.begin(), d_byBin.end(),
+		[this](unsigned int a, unsigned int b) {
+			return d_peaks[a].bin < d_peaks[b].bin;
+		});
+}
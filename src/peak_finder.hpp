@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PEAK_FINDER_HPP
+#define PEAK_FINDER_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace adiscope {
+
+/*
+ * Finds the highest local maxima of a trace. A bin is a peak when it is
+ * above its left neighbour and not below its right one, so a flat top
+ * counts once.
+ *
+ * Peaks under the threshold, or less prominent than the minimum
+ * prominence, are ignored. The prominence of a peak is its height above
+ * the higher of the two lowest points that separate it from a higher
+ * sample (or from the end of the searched range) on either side.
+ *
+ * The result is kept ordered by value, with an index ordered by bin
+ * alongside. All buffers are reused from one search to the next.
+ */
+class PeakFinder
+{
+public:
+	struct Peak {
+		size_t bin;
+		double value;
+		double prominence;
+	};
+
+	PeakFinder();
+
+	void setThreshold(double threshold);
+	double threshold() const;
+
+	void setMinProminence(double prominence);
+	double minProminence() const;
+
+	/*
+	 * Keeps the count highest peaks among the bins [start, stop) of y.
+	 * The bins next to the range are read as neighbours if they exist.
+	 */
+	void find(const double *y, size_t size, size_t start, size_t stop,
+		  unsigned int count);
+
+	/* Highest first; the lower bin first on equal values */
+	const std::vector<Peak> &peaks() const;
+
+	/* Indexes into peaks(), lowest bin first */
+	const std::vector<unsigned int> &byBin() const;
+
+private:
+	struct StackEntry {
+		double value;
+		double min;
+	};
+
+	void findBases(const double *y, size_t start, size_t stop);
+
+	double d_threshold;
+	double d_minProminence;
+
+	std::vector<unsigned char> d_mask;
+	std::vector<double> d_leftBase;
+	std::vector<double> d_rightBase;
+	std::vector<StackEntry> d_stack;
+
+	std::vector<Peak> d_peaks;
+	std::vector<unsigned int> d_byBin;
+};
+
+} /* namespace adiscope */
+
+#endif /* PEAK_FINDER_HPP */
@@ -0,0 +1,363 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "persistence_raster.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace adiscope;
+
+/* Rescale the grids before the weight of new hits loses float precision */
+static const double MAX_WEIGHT = 1e15;
+
+PersistenceRaster::PersistenceRaster(unsigned int nchannels,
+				     unsigned int width, unsigned int height):
+	d_width(0),
+	d_height(0),
+	d_frameSize(0),
+	d_decay(0),
+	d_timeRef(now())
+{
+	configure(nchannels, width, height);
+}
+
+double PersistenceRaster::now()
+{
+	using namespace std::chrono;
+
+	return duration_cast<duration<double>>(
+		steady_clock::now().time_since_epoch()).count();
+}
+
+void PersistenceRaster::configure(unsigned int nchannels, unsigned int width,
+				  unsigned int height)
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+
+	d_width = width;
+	d_height = height;
+	d_channels.assign(nchannels, Channel());
+
+	for (Channel &c : d_channels) {
+		c.hits.assign((size_t)width * height, 0.0f);
+		c.min = -1.0;
+		c.max = 1.0;
+		c.xmin = -1.0;
+		c.xmax = 1.0;
+	}
+
+	d_columns.clear();
+	d_frameSize = 0;
+	d_timeRef = now();
+}
+
+void PersistenceRaster::clear()
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+
+	for (Channel &c : d_channels) {
+		std::fill(c.hits.begin(), c.hits.end(), 0.0f);
+	}
+
+	d_timeRef = now();
+}
+
+void PersistenceRaster::setVerticalRange(unsigned int channel, double min,
+					 double max)
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+
+	if (channel >= d_channels.size() || !(max > min)) {
+		return;
+	}
+
+	Channel &c = d_channels[channel];
+	c.min = min;
+	c.max = max;
+	std::fill(c.hits.begin(), c.hits.end(), 0.0f);
+}
+
+double PersistenceRaster::verticalMin(unsigned int channel) const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	return channel < d_channels.size() ? d_channels[channel].min : 0.0;
+}
+
+double PersistenceRaster::verticalMax(unsigned int channel) const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	return channel < d_channels.size() ? d_channels[channel].max : 0.0;
+}
+
+void PersistenceRaster::setHorizontalRange(unsigned int channel, double min,
+					   double max)
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+
+	if (channel >= d_channels.size() || !(max > min)) {
+		return;
+	}
+
+	Channel &c = d_channels[channel];
+	c.xmin = min;
+	c.xmax = max;
+	std::fill(c.hits.begin(), c.hits.end(), 0.0f);
+}
+
+double PersistenceRaster::horizontalMin(unsigned int channel) const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	return channel < d_channels.size() ? d_channels[channel].xmin : 0.0;
+}
+
+double PersistenceRaster::horizontalMax(unsigned int channel) const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	return channel < d_channels.size() ? d_channels[channel].xmax : 0.0;
+}
+
+void PersistenceRaster::setDecay(double seconds)
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	const double t = now();
+
+	// Bring the stored hits to their present value before the
+	// time constant changes
+	if (d_decay > 0) {
+		rescale(t);
+	}
+
+	d_decay = std::max(seconds, 0.0);
+	d_timeRef = t;
+}
+
+double PersistenceRaster::decay() const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	return d_decay;
+}
+
+void PersistenceRaster::rescale(double t)
+{
+	const float factor = std::exp(-(t - d_timeRef) / d_decay);
+
+	for (Channel &c : d_channels) {
+		float *hits = c.hits.data();
+		const size_t count = c.hits.size();
+
+		for (size_t i = 0; i < count; i++) {
+			hits[i] *= factor;
+		}
+	}
+
+	d_timeRef = t;
+}
+
+float PersistenceRaster::currentWeight()
+{
+	if (d_decay <= 0) {
+		return 1.0f;
+	}
+
+	const double t = now();
+	double weight = std::exp((t - d_timeRef) / d_decay);
+
+	if (weight > MAX_WEIGHT) {
+		rescale(t);
+		weight = 1.0;
+	}
+
+	return weight;
+}
+
+void PersistenceRaster::accumulate(unsigned int channel, const double *data,
+				   size_t size)
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+
+	if (channel >= d_channels.size() || size == 0 ||
+			d_width == 0 || d_height == 0) {
+		return;
+	}
+
+	if (size != d_frameSize) {
+		d_columns.resize(size);
+		for (size_t i = 0; i < size; i++) {
+			d_columns[i] = (unsigned long long)i * d_width / size;
+		}
+		d_frameSize = size;
+	}
+
+	Channel &c = d_channels[channel];
+	const double scale = d_height / (c.max - c.min);
+	const double top = d_height;
+	const double bottom = c.min;
+
+	d_rows.resize(size);
+	int *rows = d_rows.data();
+
+	// Branch free so that the compiler can vectorize it. Samples out of
+	// range (and NaNs) end up on row -1 or d_height, outside of the grid.
+	for (size_t i = 0; i < size; i++) {
+		double r = (data[i] - bottom) * scale;
+		r = !(r >= 0.0) ? -1.0 : r;
+		r = r > top ? top : r;
+		rows[i] = (int)r;
+	}
+
+	const float weight = currentWeight();
+	const int *columns = d_columns.data();
+	const int maxRow = d_height - 1;
+	float *hits = c.hits.data();
+	int prev = rows[0];
+
+	for (size_t i = 0; i < size; i++) {
+		const int row = rows[i];
+		int from = row;
+		int to = row;
+
+		// Join with the previous sample, which was already counted
+		if (i > 0) {
+			if (prev < row - 1) {
+				from = prev + 1;
+			} else if (prev > row + 1) {
+				to = prev - 1;
+			}
+		}
+
+		from = std::max(from, 0);
+		to = std::min(to, maxRow);
+
+		for (int r = from; r <= to; r++) {
+			hits[(size_t)r * d_width + columns[i]] += weight;
+		}
+
+		prev = row;
+	}
+}
+
+void PersistenceRaster::accumulatePoints(unsigned int channel,
+					 const double *x, const double *y,
+					 size_t size, bool replace)
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+
+	if (channel >= d_channels.size() || d_width == 0 || d_height == 0) {
+		return;
+	}
+
+	Channel &c = d_channels[channel];
+
+	if (replace) {
+		std::fill(c.hits.begin(), c.hits.end(), 0.0f);
+	}
+
+	const double xscale = d_width / (c.xmax - c.xmin);
+	const double yscale = d_height / (c.max - c.min);
+	const double xleft = c.xmin;
+	const double ybottom = c.min;
+	const double right = d_width;
+	const double top = d_height;
+	const int width = d_width;
+
+	d_cells.resize(size);
+	int *cells = d_cells.data();
+
+	// Branch free so that the compiler can vectorize it. Points out of
+	// range (and NaNs) get cell -1.
+	for (size_t i = 0; i < size; i++) {
+		const double col = (x[i] - xleft) * xscale;
+		const double row = (y[i] - ybottom) * yscale;
+		const bool inside = (col >= 0.0) & (col < right) &
+			(row >= 0.0) & (row < top);
+		const int cell = (int)(inside ? row : 0.0) * width +
+			(int)(inside ? col : 0.0);
+		cells[i] = inside ? cell : -1;
+	}
+
+	const float weight = currentWeight();
+	float *hits = c.hits.data();
+
+	for (size_t i = 0; i < size; i++) {
+		if (cells[i] >= 0) {
+			hits[cells[i]] += weight;
+		}
+	}
+}
+
+void PersistenceRaster::snapshot(unsigned int channel,
+				 std::vector<double> &out) const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+
+	if (channel >= d_channels.size()) {
+		out.clear();
+		return;
+	}
+
+	const std::vector<float> &hits = d_channels[channel].hits;
+	const size_t count = hits.size();
+	const double present = d_decay > 0 ?
+		std::exp(-(now() - d_timeRef) / d_decay) : 1.0;
+
+	float peak = 0.0f;
+	for (size_t i = 0; i < count; i++) {
+		peak = std::max(peak, hits[i]);
+	}
+
+	out.resize(count);
+
+	if (!(peak * present > 0.0)) {
+		std::fill(out.begin(), out.end(), 0.0);
+		return;
+	}
+
+	const double norm = 1.0 / std::log1p(peak * present);
+
+	for (size_t i = 0; i < count; i++) {
+		out[i] = std::log1p(hits[i] * present) * norm;
+	}
+}
+
+unsigned int PersistenceRaster::numChannels() const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	return d_channels.size();
+}
+
+unsigned int PersistenceRaster::width() const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	return d_width;
+}
+
+unsigned int PersistenceRaster::height() const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	return d_height;
+}
+
+size_t PersistenceRaster::frameSize() const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	return d_frameSize;
+}
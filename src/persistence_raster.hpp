@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PERSISTENCE_RASTER_HPP
+#define PERSISTENCE_RASTER_HPP
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace adiscope {
+
+/*
+ * Per channel 2D hit count grid used for a persistence (phosphor like)
+ * display. Every accumulated waveform spreads its samples over width()
+ * time columns and height() amplitude rows; consecutive samples that land
+ * more than a row apart also light the rows in between, so fast edges
+ * stay visible.
+ *
+ * Older hits fade with an exponential decay. Instead of scaling the whole
+ * grid for every waveform, new hits get an exponentially growing weight
+ * and the grid is only rescaled once that weight gets large.
+ *
+ * The same grid can also hold a density image of (x, y) points, e.g. for
+ * an XY view; the columns then span the horizontal range of the channel.
+ *
+ * Waveforms are accumulated by a sink thread and read by the GUI, so every
+ * method takes the internal lock.
+ */
+class PersistenceRaster
+{
+public:
+	PersistenceRaster(unsigned int nchannels = 0, unsigned int width = 512,
+			  unsigned int height = 256);
+
+	/* Reallocates the grids; every channel range is reset to [-1, 1] */
+	void configure(unsigned int nchannels, unsigned int width,
+		       unsigned int height);
+	void clear();
+
+	/* Amplitude span covered by the rows of a channel; clears it */
+	void setVerticalRange(unsigned int channel, double min, double max);
+	double verticalMin(unsigned int channel) const;
+	double verticalMax(unsigned int channel) const;
+
+	/* Span covered by the columns in point mode; clears the channel */
+	void setHorizontalRange(unsigned int channel, double min, double max);
+	double horizontalMin(unsigned int channel) const;
+	double horizontalMax(unsigned int channel) const;
+
+	/* Time constant of the decay in seconds, 0 keeps hits forever */
+	void setDecay(double seconds);
+	double decay() const;
+
+	void accumulate(unsigned int channel, const double *data, size_t size);
+
+	/*
+	 * Point mode: counts each (x[i], y[i]) in the cell it falls in.
+	 * With replace set, the previous hits of the channel are dropped.
+	 */
+	void accumulatePoints(unsigned int channel, const double *x,
+			      const double *y, size_t size, bool replace);
+
+	/*
+	 * Writes the current intensities of a channel, scaled to [0, 1] on a
+	 * log scale, row by row starting with the lowest amplitude.
+	 */
+	void snapshot(unsigned int channel, std::vector<double> &out) const;
+
+	unsigned int numChannels() const;
+	unsigned int width() const;
+	unsigned int height() const;
+
+	/* Number of samples in the last accumulated waveform */
+	size_t frameSize() const;
+
+private:
+	struct Channel {
+		std::vector<float> hits;
+		double min;
+		double max;
+		double xmin;
+		double xmax;
+	};
+
+	static double now();
+	float currentWeight();
+	void rescale(double t);
+
+	mutable std::mutex d_mutex;
+	unsigned int d_width;
+	unsigned int d_height;
+	std::vector<Channel> d_channels;
+
+	std::vector<int> d_rows;
+	std::vector<int> d_columns;
+	std::vector<int> d_cells;
+	size_t d_frameSize;
+
+	double d_decay;
+	double d_timeRef;
+};
+
+} /* namespace adiscope */
+
+#endif /* PERSISTENCE_RASTER_HPP */
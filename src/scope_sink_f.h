@@ -47,8 +47,12 @@
 #endif
 
 #include "trigger_mode.h"
+#include "segment_buffer.hpp"
+#include "persistence_raster.hpp"
+#include "frame_exchange.hpp"
 #include <gnuradio/sync_block.h>
 #include <qapplication.h>
+#include <memory>
 
 namespace adiscope {
 
@@ -78,6 +82,25 @@ namespace adiscope {
       virtual void set_displayOneBuffer(bool) = 0;
       virtual void clean_buffers() = 0;
 
+      /*
+       * In one buffer mode, also store every triggered buffer into the
+       * given segmented memory, regardless of the plot update rate.
+       * Pass nullptr to disable.
+       */
+      virtual void set_segment_buffer(const std::shared_ptr<SegmentBuffer> &segments) = 0;
+
+      /*
+       * In one buffer mode, also accumulate every triggered buffer into
+       * the given persistence raster. Pass nullptr to disable.
+       */
+      virtual void set_persistence_raster(const std::shared_ptr<PersistenceRaster> &raster) = 0;
+
+      /*
+       * Frames are plot updates. Frames skipped by the update rate or
+       * while the GUI still holds every pooled frame count as dropped.
+       */
+      virtual const FrameCounters &frame_counters() const = 0;
+
       QApplication *d_qApplication;
     };
 
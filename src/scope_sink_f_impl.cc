@@ -76,22 +76,11 @@ namespace adiscope {
                    io_signature::make(nconnections, nconnections, sizeof(float)),
                    io_signature::make(0, 0, 0)),
 	d_size(size), d_buffer_size(2*size), d_samp_rate(samp_rate), d_name(name),
-	d_nconnections(nconnections), d_index(0), d_start(0), d_end(size)
+	d_nconnections(nconnections), d_index(0), d_start(0), d_end(size),
+	d_pool(nconnections, d_buffer_size),
+	d_displayOneBuffer(true), d_cleanBuffers(true)
     {
-
-
-      for(int n = 0; n < d_nconnections; n++) {
-	d_buffers.push_back((double*)volk_malloc(d_buffer_size*sizeof(double),
-                                                 volk_get_alignment()));
-	memset(d_buffers[n], 0, d_buffer_size*sizeof(double));
-
-	d_fbuffers.push_back((float*)volk_malloc(d_buffer_size*sizeof(float),
-                                                  volk_get_alignment()));
-	memset(d_fbuffers[n], 0, d_buffer_size*sizeof(float));
-
-        d_displayOneBuffer = true;
-        d_cleanBuffers = true;
-      }
+      d_frame = d_pool.acquire();
 
       // Set alignment properties for VOLK
       const int alignment_multiple =
@@ -99,6 +88,7 @@ namespace adiscope {
       set_alignment(std::max(1,alignment_multiple));
 
       d_tags = std::vector< std::vector<gr::tag_t> >(d_nconnections);
+      d_segment_channels.resize(d_nconnections);
 
       initialize();
       this->plot = plot;
@@ -116,10 +106,6 @@ namespace adiscope {
 
     scope_sink_f_impl::~scope_sink_f_impl()
     {
-      for(int n = 0; n < d_nconnections; n++) {
-	volk_free(d_buffers[n]);
-	volk_free(d_fbuffers[n]);
-      }
     }
 
     bool
@@ -164,6 +150,7 @@ namespace adiscope {
       d_trigger_tag_key = pmt::intern(tag_key);
       d_triggered = false;
 
+      _renew_frame();
       _reset();
     }
 
@@ -178,17 +165,14 @@ namespace adiscope {
 	d_size = newsize;
         d_buffer_size = 2*d_size;
 
-	// Resize buffers and replace data
-	for(int n = 0; n < d_nconnections; n++) {
-	  volk_free(d_buffers[n]);
-	  d_buffers[n] = (double*)volk_malloc(d_buffer_size*sizeof(double),
-                                              volk_get_alignment());
-	  memset(d_buffers[n], 0, d_buffer_size*sizeof(double));
-
-	  volk_free(d_fbuffers[n]);
-	  d_fbuffers[n] = (float*)volk_malloc(d_buffer_size*sizeof(float),
-                                               volk_get_alignment());
-	  memset(d_fbuffers[n], 0, d_buffer_size*sizeof(float));
+	// Frames still held by pending events are released by them
+	d_pool = TimeFramePool(d_nconnections, d_buffer_size);
+	d_frame = d_pool.acquire();
+
+	// Sized here rather than from work(), which must not allocate
+	if(d_segments) {
+	  d_segments->configure(d_nconnections, d_size,
+				d_segments->numSegments());
 	}
 
         _reset();
@@ -221,12 +205,18 @@ namespace adiscope {
     scope_sink_f_impl::reset()
     {
       gr::thread::scoped_lock lock(d_setlock);
+      _renew_frame();
       _reset();
     }
 
     void
     scope_sink_f_impl::set_displayOneBuffer(bool val)
     {
+            gr::thread::scoped_lock lock(d_setlock);
+
+            if (d_displayOneBuffer != val) {
+                    _renew_frame();
+            }
             d_displayOneBuffer = val;
     }
 
@@ -239,6 +229,11 @@ namespace adiscope {
         d_tags[n].clear();
       }
 
+      // The next samples are written over the frame from the start
+      if (d_frame) {
+	d_frame->restart();
+      }
+
       // Reset the start and end indices.
       d_start = 0;
       d_index = 0;
@@ -254,6 +249,19 @@ namespace adiscope {
       }
     }
 
+    void
+    scope_sink_f_impl::_renew_frame()
+    {
+      // Keep the current frame if nobody besides the pool reads it
+      if (d_frame.use_count() <= 2) {
+	return;
+      }
+
+      // If every frame is still referenced by the GUI, go without one;
+      // work() drops samples until a frame is released.
+      d_frame = d_pool.acquire();
+    }
+
     void
     scope_sink_f_impl::_test_trigger_tags(int nitems)
     {
@@ -293,27 +301,57 @@ namespace adiscope {
     {
             gr::thread::scoped_lock lock(d_setlock);
 
-            // Set new size and reset buffer index
-            // (throws away any currently held data, but who cares?)
-            d_buffer_size = 2*d_size;
-
-            // Resize buffers and replace data
-            for(int n = 0; n < d_nconnections; n++) {
-                    volk_free(d_buffers[n]);
-                    d_buffers[n] = (double*)volk_malloc(d_buffer_size*sizeof(double),
-                                                        volk_get_alignment());
-                    memset(d_buffers[n], 0, d_buffer_size*sizeof(double));
-
-                    volk_free(d_fbuffers[n]);
-                    d_fbuffers[n] = (float*)volk_malloc(d_buffer_size*sizeof(float),
-                                                        volk_get_alignment());
-                    memset(d_fbuffers[n], 0, d_buffer_size*sizeof(float));
-            }
+            // The GUI may still be reading the current frame, so start
+            // filling a different one instead of overwriting it
+            _renew_frame();
 
             _reset();
             d_cleanBuffers = true;
     }
 
+    void
+    scope_sink_f_impl::set_segment_buffer(const std::shared_ptr<SegmentBuffer> &segments)
+    {
+            gr::thread::scoped_lock lock(d_setlock);
+            d_segments = segments;
+
+            if (d_segments && (d_segments->segmentSize() != (size_t)d_size ||
+                               d_segments->numChannels() != (unsigned int)d_nconnections)) {
+                    d_segments->configure(d_nconnections, d_size,
+                                          d_segments->numSegments());
+            }
+    }
+
+    void
+    scope_sink_f_impl::set_persistence_raster(const std::shared_ptr<PersistenceRaster> &raster)
+    {
+            gr::thread::scoped_lock lock(d_setlock);
+            d_persistence = raster;
+    }
+
+    const FrameCounters &
+    scope_sink_f_impl::frame_counters() const
+    {
+            return d_counters;
+    }
+
+    bool
+    scope_sink_f_impl::_store_segment()
+    {
+      // The GUI sizes the buffer; segments of another size are dropped
+      if (d_segments->segmentSize() != (size_t)d_size ||
+                      d_segments->numChannels() != (unsigned int)d_nconnections) {
+              return false;
+      }
+
+      for (int n = 0; n < d_nconnections; n++) {
+              d_segment_channels[n] = &d_frame->channel(n)[d_start];
+      }
+
+      double now = (double)gr::high_res_timer_now() / gr::high_res_timer_tps();
+      return d_segments->push(d_segment_channels.data(), now);
+    }
+
     int
     scope_sink_f_impl::work(int noutput_items,
 			   gr_vector_const_void_star &input_items,
@@ -329,6 +367,16 @@ namespace adiscope {
       if (!d_displayOneBuffer && !d_cleanBuffers) {
               return 0;
       }
+
+      // No free frame to write into; drop the samples rather than
+      // allocating here
+      if (!d_frame) {
+              d_frame = d_pool.acquire();
+              if (!d_frame) {
+                      return noutput_items;
+              }
+              d_frame->restart();
+      }
       int nfill = d_end - d_index;                 // how much room left in buffers
       int nitems = std::min(noutput_items, nfill); // num items we can put in buffers
       int nItemsToSend = 0;
@@ -344,9 +392,7 @@ namespace adiscope {
       // Copy data into the buffers.
       for(n = 0; n < d_nconnections; n++) {
         in = (const float*)input_items[idx];
-	memcpy(&d_fbuffers[n][d_index], &in[0], nitems*sizeof(float));
-        //volk_32f_convert_64f(&d_buffers[n][d_index],
-        //                     &in[1], nitems);
+        volk_32f_convert_64f(&d_frame->channel(n)[d_index], &in[0], nitems);
 
         uint64_t nr = nitems_read(idx);
         std::vector<gr::tag_t> tags;
@@ -362,34 +408,64 @@ namespace adiscope {
       // If we've have a full d_size of items in the buffers, plot.
       if((d_end != 0 && !d_displayOneBuffer) ||
                       ((d_triggered) && (d_index == d_end) && d_end != 0 && d_displayOneBuffer)) {
-              // Copy data to be plotted to start of buffers.
-              for(n = 0; n < d_nconnections; n++) {
-                      if (!d_displayOneBuffer) {
-                              nItemsToSend = d_index;
-                              if (nItemsToSend >= d_size) {
-                                      nItemsToSend = d_size;
-                                      d_cleanBuffers = false;
-                              }
-                              volk_32f_convert_64f(d_buffers[n], &d_fbuffers[n][d_start], nItemsToSend);
-                      } else {
-                              //memmove(d_buffers[n], &d_buffers[n][d_start], d_size*sizeof(double));
-                              volk_32f_convert_64f(d_buffers[n], &d_fbuffers[n][d_start], d_size);
+              // Every triggered buffer goes to the segmented memory and
+              // the persistence raster, even when the plot update below is
+              // skipped. The buffer that fills the segmented memory is
+              // always plotted so the GUI learns about it.
+              bool segments_filled = false;
+              if (d_displayOneBuffer && d_segments) {
+                      segments_filled = _store_segment();
+              }
+              if (d_displayOneBuffer && d_persistence) {
+                      for (n = 0; n < d_nconnections; n++) {
+                              d_persistence->accumulate(n,
+                                      &d_frame->channel(n)[d_start], d_size);
+                      }
+              }
+
+              if (!d_displayOneBuffer) {
+                      nItemsToSend = d_index;
+                      if (nItemsToSend >= d_size) {
                               nItemsToSend = d_size;
+                              d_cleanBuffers = false;
                       }
+              } else {
+                      nItemsToSend = d_size;
               }
 
               // Plot if we are able to update
               if((gr::high_res_timer_now() - d_last_time > d_update_time)
-                              || !d_cleanBuffers) {
-                      d_last_time = gr::high_res_timer_now();
-                      if (d_qApplication) {
+                              || !d_cleanBuffers || segments_filled) {
+                      // The frame is handed over to the plot as it is. In
+                      // rolling mode only samples past d_index are written
+                      // from now on, so the same frame can be sent again.
+                      // Otherwise move on to a free frame, or drop this one
+                      // if the GUI still holds all of them.
+                      std::shared_ptr<TimeFrame> sent = d_frame;
+                      if (d_displayOneBuffer) {
+                              d_frame = d_pool.acquire();
+                              if (!d_frame) {
+                                      d_frame = sent;
+                                      sent.reset();
+                              }
+                      }
+
+                      if (sent && d_qApplication) {
+                              d_last_time = gr::high_res_timer_now();
                               d_qApplication->postEvent(this->plot,
-                                                        new IdentifiableTimeUpdateEvent(d_buffers,
+                                                        new IdentifiableTimeUpdateEvent(sent,
+                                                                                        d_start,
                                                                                         nItemsToSend,
                                                                                         d_tags,
                                                                                         d_name));
+                              d_counters.delivered++;
+                      } else {
+                              d_counters.dropped++;
                       }
+              } else {
+                      d_counters.dropped++;
               }
+              d_counters.produced++;
 
               // We've plotting, so reset the state
               if (d_displayOneBuffer) {
@@ -45,6 +45,7 @@
 #include <gnuradio/high_res_timer.h>
 
 #include "scope_sink_f.h"
+#include "time_frame_pool.hpp"
 #include "TimeDomainDisplayPlot.h"
 #include "FftDisplayPlot.h"
 
@@ -61,8 +62,8 @@ namespace adiscope {
       int d_nconnections;
 
       int d_index, d_start, d_end;
-      std::vector<float*> d_fbuffers;
-      std::vector<double*> d_buffers;
+      TimeFramePool d_pool;
+      std::shared_ptr<TimeFrame> d_frame;
       std::vector< std::vector<gr::tag_t> > d_tags;
 
       QObject *plot;
@@ -79,10 +80,18 @@ namespace adiscope {
       bool d_displayOneBuffer;
       bool d_cleanBuffers;
 
+      std::shared_ptr<SegmentBuffer> d_segments;
+      std::vector<const double *> d_segment_channels;
+      std::shared_ptr<PersistenceRaster> d_persistence;
+
+      FrameCounters d_counters;
+
       void _reset();
+      void _renew_frame();
       void _npoints_resize();
       void _adjust_tags(int adj);
       void _test_trigger_tags(int nitems);
+      bool _store_segment();
 
     public:
       scope_sink_f_impl(int size, double samp_rate,
@@ -107,6 +116,9 @@ namespace adiscope {
       std::string name() const;
       void reset();
       void clean_buffers();
+      void set_segment_buffer(const std::shared_ptr<SegmentBuffer> &segments);
+      void set_persistence_raster(const std::shared_ptr<PersistenceRaster> &raster);
+      const FrameCounters &frame_counters() const;
 
 
       int work(int noutput_items,
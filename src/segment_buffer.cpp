@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "segment_buffer.hpp"
+
+#include <string.h>
+
+using namespace adiscope;
+
+SegmentBuffer::SegmentBuffer(unsigned int nchannels, size_t segmentSize,
+			     unsigned int numSegments):
+	d_nchannels(0),
+	d_segmentSize(0),
+	d_numSegments(0),
+	d_head(0),
+	d_count(0),
+	d_overwrite(true),
+	d_firstTimestamp(0)
+{
+	configure(nchannels, segmentSize, numSegments);
+}
+
+void SegmentBuffer::configure(unsigned int nchannels, size_t segmentSize,
+			      unsigned int numSegments)
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+
+	d_nchannels = nchannels;
+	d_segmentSize = segmentSize;
+	d_numSegments = numSegments;
+
+	d_data.assign((size_t)numSegments * nchannels * segmentSize, 0.0);
+	d_timestamps.assign(numSegments, 0.0);
+	d_head = 0;
+	d_count = 0;
+}
+
+void SegmentBuffer::clear()
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+
+	d_head = 0;
+	d_count = 0;
+}
+
+void SegmentBuffer::setOverwrite(bool overwrite)
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	d_overwrite = overwrite;
+}
+
+bool SegmentBuffer::overwrite() const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	return d_overwrite;
+}
+
+bool SegmentBuffer::push(const double * const *channels, double timestamp)
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+
+	if (d_numSegments == 0 || (!d_overwrite && d_count == d_numSegments)) {
+		return false;
+	}
+
+	if (d_count == 0) {
+		d_firstTimestamp = timestamp;
+	}
+
+	// d_head is the slot of the oldest segment once the buffer is full
+	const unsigned int slot = (d_head + d_count) % d_numSegments;
+
+	for (unsigned int i = 0; i < d_nchannels; i++) {
+		memcpy(slotData(slot, i), channels[i],
+		       d_segmentSize * sizeof(double));
+	}
+
+	d_timestamps[slot] = timestamp - d_firstTimestamp;
+
+	if (d_count < d_numSegments) {
+		d_count++;
+		return d_count == d_numSegments;
+	}
+
+	d_head = (d_head + 1) % d_numSegments;
+	return false;
+}
+
+unsigned int SegmentBuffer::numChannels() const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	return d_nchannels;
+}
+
+size_t SegmentBuffer::segmentSize() const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	return d_segmentSize;
+}
+
+unsigned int SegmentBuffer::numSegments() const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	return d_numSegments;
+}
+
+unsigned int SegmentBuffer::count() const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	return d_count;
+}
+
+bool SegmentBuffer::full() const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	return d_numSegments > 0 && d_count == d_numSegments;
+}
+
+double SegmentBuffer::timestamp(unsigned int index) const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+
+	if (index >= d_count) {
+		return 0.0;
+	}
+
+	return d_timestamps[(d_head + index) % d_numSegments];
+}
+
+std::vector<double> SegmentBuffer::timestamps() const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	std::vector<double> result;
+
+	result.reserve(d_count);
+	for (unsigned int i = 0; i < d_count; i++) {
+		result.push_back(d_timestamps[(d_head + i) % d_numSegments]);
+	}
+
+	return result;
+}
+
+double *SegmentBuffer::slotData(unsigned int slot, unsigned int channel)
+{
+	return &d_data[((size_t)slot * d_nchannels + channel) * d_segmentSize];
+}
+
+const double *SegmentBuffer::segmentData(unsigned int index,
+					 unsigned int channel) const
+{
+	const unsigned int slot = (d_head + index) % d_numSegments;
+
+	return &d_data[((size_t)slot * d_nchannels + channel) * d_segmentSize];
+}
+
+bool SegmentBuffer::copySegment(unsigned int index, unsigned int channel,
+				double *out) const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+
+	if (index >= d_count || channel >= d_nchannels) {
+		return false;
+	}
+
+	memcpy(out, segmentData(index, channel),
+	       d_segmentSize * sizeof(double));
+	return true;
+}
+
+unsigned int SegmentBuffer::copySegments(unsigned int channel,
+					 std::vector<double> &out,
+					 size_t &size) const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+
+	size = d_segmentSize;
+
+	if (channel >= d_nchannels) {
+		return 0;
+	}
+
+	if (out.size() < (size_t)d_count * d_segmentSize) {
+		out.resize((size_t)d_count * d_segmentSize);
+	}
+
+	for (unsigned int i = 0; i < d_count; i++) {
+		memcpy(&out[(size_t)i * d_segmentSize], segmentData(i, channel),
+		       d_segmentSize * sizeof(double));
+	}
+
+	return d_count;
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SEGMENT_BUFFER_HPP
+#define SEGMENT_BUFFER_HPP
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace adiscope {
+
+/*
+ * Segmented acquisition memory: up to numSegments() triggered captures of
+ * segmentSize() samples per channel, stored back to back in one ring that
+ * is allocated by configure() only. Once full, a new segment replaces the
+ * oldest one, or is dropped if overwriting was disabled.
+ *
+ * Segments are indexed from the oldest (0) to the newest (count() - 1).
+ * Each one is stamped with the time, in seconds, at which it was stored,
+ * relative to the first segment stored after the last clear().
+ *
+ * A sink thread pushes segments while the GUI reads them, so every method
+ * takes the internal lock. Readers copy what they need out of the ring,
+ * so pushing never allocates. configure() is for the GUI side; a sink
+ * with segments of another size drops them instead.
+ */
+class SegmentBuffer
+{
+public:
+	SegmentBuffer(unsigned int nchannels = 0, size_t segmentSize = 0,
+		      unsigned int numSegments = 0);
+
+	/* Reallocates the storage and drops every segment */
+	void configure(unsigned int nchannels, size_t segmentSize,
+		       unsigned int numSegments);
+	void clear();
+
+	void setOverwrite(bool overwrite);
+	bool overwrite() const;
+
+	/*
+	 * Stores one segment, reading segmentSize() samples from each of
+	 * channels[0, numChannels()). Returns true if this filled the buffer.
+	 */
+	bool push(const double * const *channels, double timestamp);
+
+	unsigned int numChannels() const;
+	size_t segmentSize() const;
+	unsigned int numSegments() const;
+	unsigned int count() const;
+	bool full() const;
+
+	double timestamp(unsigned int index) const;
+	std::vector<double> timestamps() const;
+
+	/* Copies segmentSize() samples of a channel into out */
+	bool copySegment(unsigned int index, unsigned int channel,
+			 double *out) const;
+
+	/*
+	 * Copies the segments of a channel into out, oldest first and back
+	 * to back, so that they can be read while new ones are pushed. out
+	 * only grows. Returns the number of segments copied, and their size
+	 * in size.
+	 */
+	unsigned int copySegments(unsigned int channel,
+				  std::vector<double> &out, size_t &size) const;
+
+private:
+	double *slotData(unsigned int slot, unsigned int channel);
+	const double *segmentData(unsigned int index,
+				  unsigned int channel) const;
+
+	mutable std::mutex d_mutex;
+	unsigned int d_nchannels;
+	size_t d_segmentSize;
+	unsigned int d_numSegments;
+
+	// Layout: [slot][channel][sample]
+	std::vector<double> d_data;
+	std::vector<double> d_timestamps;
+	unsigned int d_head;
+	unsigned int d_count;
+	bool d_overwrite;
+	double d_firstTimestamp;
+};
+
+} /* namespace adiscope */
+
+#endif /* SEGMENT_BUFFER_HPP */
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "segment_overlay_item.hpp"
+
+#include <qwt_painter.h>
+#include <qwt_scale_map.h>
+
+#include <QPainter>
+#include <QPolygonF>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace adiscope;
+
+SegmentOverlayItem::SegmentOverlayItem(
+		const std::shared_ptr<SegmentBuffer> &segments,
+		unsigned int channel):
+	QwtPlotItem(QwtText("Segments")),
+	d_segments(segments),
+	d_channel(channel),
+	d_start(0),
+	d_step(1)
+{
+	setItemAttribute(QwtPlotItem::AutoScale, false);
+	setItemAttribute(QwtPlotItem::Legend, false);
+	setZ(15);
+}
+
+int SegmentOverlayItem::rtti() const
+{
+	return Rtti_SegmentOverlay;
+}
+
+void SegmentOverlayItem::setPen(const QPen &pen)
+{
+	if (d_pen != pen) {
+		d_pen = pen;
+		itemChanged();
+	}
+}
+
+const QPen &SegmentOverlayItem::pen() const
+{
+	return d_pen;
+}
+
+void SegmentOverlayItem::setTimeBase(double start, double step)
+{
+	d_start = start;
+	d_step = step;
+}
+
+void SegmentOverlayItem::draw(QPainter *painter, const QwtScaleMap &xMap,
+			      const QwtScaleMap &yMap, const QRectF &) const
+{
+	if (!d_segments || d_step <= 0) {
+		return;
+	}
+
+	// Copying is all that happens under the buffer lock, the sink
+	// keeps pushing segments while they are drawn
+	size_t size = 0;
+	const unsigned int count = d_segments->copySegments(d_channel,
+							   d_snapshot, size);
+
+	if (count == 0 || size == 0) {
+		return;
+	}
+
+	const double left = std::min(xMap.s1(), xMap.s2());
+	const double right = std::max(xMap.s1(), xMap.s2());
+	const long first = std::max(0.0, std::floor((left - d_start) / d_step));
+	const long last = std::min<double>((double)size - 1,
+			std::ceil((right - d_start) / d_step));
+
+	if (last <= first) {
+		return;
+	}
+
+	// Samples [bounds[k], bounds[k + 1]) fall on pixel column
+	// columns[k]; the same for every segment
+	const double p1 = xMap.transform(d_start + first * d_step);
+	const double p2 = xMap.transform(d_start + last * d_step);
+	const int dir = p2 >= p1 ? 1 : -1;
+	const int c1 = std::lround(p1);
+	const int c2 = std::lround(p2);
+	std::vector<long> bounds;
+	std::vector<int> columns;
+
+	bounds.reserve(std::abs(c2 - c1) + 2);
+	columns.reserve(std::abs(c2 - c1) + 1);
+
+	for (int c = c1; c != c2 + dir; c += dir) {
+		const double edge = (xMap.invTransform(c - 0.5 * dir) - d_start) / d_step;
+		const long bound = std::min(std::max((long)std::ceil(edge), first), last + 1);
+
+		if (!bounds.empty() && bound == bounds.back()) {
+			// No sample on the previous column, zoomed in past one
+			// sample per pixel
+			columns.back() = c;
+			continue;
+		}
+
+		bounds.push_back(bound);
+		columns.push_back(c);
+	}
+	bounds.push_back(last + 1);
+
+	QPolygonF polyline;
+	polyline.reserve(2 * columns.size());
+
+	painter->save();
+	painter->setPen(d_pen);
+
+	for (unsigned int s = 0; s < count; s++) {
+		const double *data = &d_snapshot[(size_t)s * size];
+
+		polyline.clear();
+
+		// One vertical span per pixel column, joined to the next one
+		for (size_t k = 0; k < columns.size(); k++) {
+			if (bounds[k] >= bounds[k + 1]) {
+				continue;
+			}
+
+			double lo = data[bounds[k]];
+			double hi = lo;
+
+			for (long i = bounds[k] + 1; i < bounds[k + 1]; i++) {
+				lo = std::min(lo, data[i]);
+				hi = std::max(hi, data[i]);
+			}
+
+			polyline << QPointF(columns[k], yMap.transform(lo))
+				 << QPointF(columns[k], yMap.transform(hi));
+		}
+
+		QwtPainter::drawPolyline(painter, polyline);
+	}
+
+	painter->restore();
+}
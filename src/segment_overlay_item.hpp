@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SEGMENT_OVERLAY_ITEM_HPP
+#define SEGMENT_OVERLAY_ITEM_HPP
+
+#include <qwt_plot_item.h>
+
+#include <QPen>
+#include <memory>
+#include <vector>
+
+#include "segment_buffer.hpp"
+
+namespace adiscope {
+
+/*
+ * Paints every segment of one channel of a SegmentBuffer on top of each
+ * other. The segments are copied out of the buffer first, into storage
+ * kept between paints, then each one is reduced to the min/max of every
+ * pixel column, so the cost follows the canvas width rather than the
+ * segment size.
+ */
+class SegmentOverlayItem : public QwtPlotItem
+{
+public:
+	static const int Rtti_SegmentOverlay = QwtPlotItem::Rtti_PlotUserItem + 50;
+
+	SegmentOverlayItem(const std::shared_ptr<SegmentBuffer> &segments,
+			   unsigned int channel);
+
+	virtual int rtti() const;
+
+	void setPen(const QPen &pen);
+	const QPen &pen() const;
+
+	/* Sample i of a segment is drawn at x = start + i * step */
+	void setTimeBase(double start, double step);
+
+	virtual void draw(QPainter *painter, const QwtScaleMap &xMap,
+			  const QwtScaleMap &yMap, const QRectF &canvasRect) const;
+
+private:
+	std::shared_ptr<SegmentBuffer> d_segments;
+	unsigned int d_channel;
+	QPen d_pen;
+	double d_start;
+	double d_step;
+
+	/* Segments copied by the last draw() */
+	mutable std::vector<double> d_snapshot;
+};
+
+} /* namespace adiscope */
+
+#endif /* SEGMENT_OVERLAY_ITEM_HPP */
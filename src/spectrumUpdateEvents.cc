@@ -204,7 +204,8 @@ SpectrumFrequencyRangeEvent::GetStopFrequency() const
 TimeUpdateEvent::TimeUpdateEvent(const std::vector<double*> &timeDomainPoints,
 				 const uint64_t numTimeDomainDataPoints,
 				 const std::vector< std::vector<gr::tag_t> > &tags)
-  : QEvent(QEvent::Type(SpectrumUpdateEventType))
+  : QEvent(QEvent::Type(SpectrumUpdateEventType)),
+    _generation(0)
 {
   if(numTimeDomainDataPoints < 1) {
     _numTimeDomainDataPoints = 1;
@@ -225,8 +226,28 @@ TimeUpdateEvent::TimeUpdateEvent(const std::vector<double*> &timeDomainPoints,
   _tags = tags;
 }
 
+TimeUpdateEvent::TimeUpdateEvent(const std::shared_ptr<adiscope::TimeFrame> &frame,
+				 const uint64_t offset,
+				 const uint64_t numTimeDomainDataPoints,
+				 const std::vector< std::vector<gr::tag_t> > &tags)
+  : QEvent(QEvent::Type(SpectrumUpdateEventType)),
+    _nplots(frame->numChannels()),
+    _numTimeDomainDataPoints(numTimeDomainDataPoints),
+    _tags(tags),
+    _frame(frame),
+    _generation(frame->generation())
+{
+  for(size_t i = 0; i < _nplots; i++) {
+    _dataTimeDomainPoints.push_back(_frame->channel(i) + offset);
+  }
+}
+
 TimeUpdateEvent::~TimeUpdateEvent()
 {
+  if(_frame) {
+    return;
+  }
+
   for(size_t i = 0; i < _nplots; i++) {
     delete[] _dataTimeDomainPoints[i];
   }
@@ -250,6 +271,12 @@ TimeUpdateEvent::getTags() const
   return _tags;
 }
 
+uint64_t
+TimeUpdateEvent::getGeneration() const
+{
+  return _generation;
+}
+
 /***************************************************************************/
 
 
@@ -260,6 +287,16 @@ IdentifiableTimeUpdateEvent::IdentifiableTimeUpdateEvent(const std::vector<doubl
   : TimeUpdateEvent(timeDomainPoints, numTimeDomainDataPoints, tags),
     _senderName(senderName)
 {
+}
+
+IdentifiableTimeUpdateEvent::IdentifiableTimeUpdateEvent(const std::shared_ptr<adiscope::TimeFrame> &frame,
+				 const uint64_t offset,
+				 const uint64_t numTimeDomainDataPoints,
+				 const std::vector< std::vector<gr::tag_t> > &tags,
+				 const std::string &senderName)
+  : TimeUpdateEvent(frame, offset, numTimeDomainDataPoints, tags),
+    _senderName(senderName)
+{
 }
 
  IdentifiableTimeUpdateEvent::~IdentifiableTimeUpdateEvent()
@@ -557,5 +594,32 @@ NumberUpdateEvent::getSamples() const
   return _samples;
 }
 
+/***************************************************************************/
+
+
+FrameReadyEvent::FrameReadyEvent(const std::shared_ptr<adiscope::FrameExchange> &exchange,
+				 const std::string &senderName)
+  : QEvent(QEvent::Type(FrameReadyEventType)),
+    _exchange(exchange),
+    _senderName(senderName)
+{
+}
+
+FrameReadyEvent::~FrameReadyEvent()
+{
+}
+
+adiscope::FrameExchange *
+FrameReadyEvent::exchange() const
+{
+  return _exchange.get();
+}
+
+std::string
+FrameReadyEvent::senderName() const
+{
+  return _senderName;
+}
+
 
 #endif /* SPECTRUM_UPDATE_EVENTS_C */
@@ -29,10 +29,14 @@
 #include <gnuradio/high_res_timer.h>
 #include <gnuradio/tags.h>
 
+#include "frame_exchange.hpp"
+#include "time_frame_pool.hpp"
+
 static const int SpectrumUpdateEventType = 10005;
 static const int SpectrumWindowCaptionEventType = 10008;
 static const int SpectrumWindowResetEventType = 10009;
 static const int SpectrumFrequencyRangeEventType = 10010;
+static const int FrameReadyEventType = 10011;
 
 class SpectrumUpdateEvent:public QEvent{
 
@@ -123,6 +127,13 @@ public:
 		  const uint64_t numTimeDomainDataPoints,
 		  const std::vector< std::vector<gr::tag_t> > &tags);
 
+  // Wraps a shared frame without copying it; the event keeps the frame
+  // alive until the receiver is done with it.
+  TimeUpdateEvent(const std::shared_ptr<adiscope::TimeFrame> &frame,
+		  const uint64_t offset,
+		  const uint64_t numTimeDomainDataPoints,
+		  const std::vector< std::vector<gr::tag_t> > &tags);
+
   ~TimeUpdateEvent();
 
   int which() const;
@@ -132,6 +143,9 @@ public:
 
   const std::vector< std::vector<gr::tag_t> > getTags() const;
 
+  // Generation of the frame when the event was posted, 0 for copied data
+  uint64_t getGeneration() const;
+
   static QEvent::Type Type()
       { return QEvent::Type(SpectrumUpdateEventType); }
 
@@ -142,6 +156,8 @@ private:
   std::vector<double*> _dataTimeDomainPoints;
   uint64_t _numTimeDomainDataPoints;
   std::vector< std::vector<gr::tag_t> > _tags;
+  std::shared_ptr<adiscope::TimeFrame> _frame;
+  uint64_t _generation;
 };
 
 
@@ -156,6 +172,12 @@ public:
 		  const std::vector< std::vector<gr::tag_t> > &tags,
 		  const std::string &senderName);
 
+  IdentifiableTimeUpdateEvent(const std::shared_ptr<adiscope::TimeFrame> &frame,
+		  const uint64_t offset,
+		  const uint64_t numTimeDomainDataPoints,
+		  const std::vector< std::vector<gr::tag_t> > &tags,
+		  const std::string &senderName);
+
   ~IdentifiableTimeUpdateEvent();
 
   std::string senderName();
@@ -352,4 +374,29 @@ private:
 
 
 
+/********************************************************************/
+
+
+// Tells a plot that a sink published a new frame in its FrameExchange. It
+// carries no samples: the plot takes the newest frame from the exchange.
+class FrameReadyEvent: public QEvent
+{
+public:
+  FrameReadyEvent(const std::shared_ptr<adiscope::FrameExchange> &exchange,
+		  const std::string &senderName = "");
+  ~FrameReadyEvent();
+
+  adiscope::FrameExchange *exchange() const;
+  std::string senderName() const;
+
+  static QEvent::Type Type()
+      { return QEvent::Type(FrameReadyEventType); }
+
+private:
+  std::shared_ptr<adiscope::FrameExchange> _exchange;
+  std::string _senderName;
+};
+
+
+
 #endif /* M2K_SPECTRUM_UPDATE_EVENTS_H */
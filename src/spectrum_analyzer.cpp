@@ -20,7 +20,6 @@
 
 /* GNU Radio includes */
 #include <gnuradio/blocks/float_to_complex.h>
-#include <gnuradio/blocks/complex_to_mag_squared.h>
 #include <gnuradio/blocks/add_blk.h>
 #include <scopy/math.h>
 #include <gnuradio/analog/sig_source.h>
@@ -51,6 +50,7 @@
 #include "spectrum_analyzer_api.hpp"
 #include "stream_to_vector_overlap.h"
 #include "tool_launcher.hpp"
+#include "waterfall_plot.hpp"
 
 #ifdef SPECTRAL_MSR
 #include "gui/measure.h"
@@ -78,6 +78,15 @@
 
 static const int MAX_REF_CHANNELS = 4;
 
+/* Largest decimation of the down converter used to zoom on a band */
+static const unsigned int MAX_ZOOM_DECIMATION = 4096;
+
+/* Rows of spectrum history the waterfall can keep */
+static const unsigned int MAX_WATERFALL_DEPTH = 4096;
+
+/* Largest trace a sweep stitches, which bounds its resolution */
+static const size_t MAX_SWEEP_POINTS = 1 << 20;
+
 using namespace adiscope;
 using namespace std;
 using namespace libm2k;
@@ -136,6 +145,7 @@ SpectrumAnalyzer::SpectrumAnalyzer(struct iio_context *ctx, Filter *filt,
 	m_generic_analogin(nullptr),
 	marker_selector(new DbClickButtons(this)),
 	fft_plot(nullptr),
+	waterfall_plot(nullptr),
 	settings_group(new QButtonGroup(this)),
 	channels_group(new QButtonGroup(this)),
 	adc_name(ctx ? filt->device_name(TOOL_SPECTRUM_ANALYZER) : ""),
@@ -148,6 +158,10 @@ SpectrumAnalyzer::SpectrumAnalyzer(struct iio_context *ctx, Filter *filt,
 	searchVisiblePeaks(true),
 	m_max_sample_rate(100e6),
 	sample_rate_divider(1),
+	zoom_decimation(1),
+	zoom_center(0),
+	sweep_resolution(0),
+	sweep_decimation(1),
 	marker_menu_opened(false),
 	bin_sizes({
 	256, 512, 1024, 2048, 4096, 8192, 16384, 32768, 65536, 131072, 262144
@@ -267,6 +281,17 @@ SpectrumAnalyzer::SpectrumAnalyzer(struct iio_context *ctx, Filter *filt,
 
 	vLayout->addWidget(fft_plot->getPlotwithElements());
 
+	// The waterfall shows the selected channel; it is off by default
+	m_waterfall = std::make_shared<WaterfallRaster>();
+	waterfall_plot = new WaterfallPlot(centralWidget);
+	waterfall_plot->setRaster(m_waterfall);
+	waterfall_plot->setAlignmentWidget(fft_plot->canvas());
+	waterfall_plot->setVisible(false);
+	vLayout->addWidget(waterfall_plot);
+	connect(fft_plot, SIGNAL(newData()), waterfall_plot, SLOT(update()));
+	ui->spinBox_waterfallDepth->setMaximum(MAX_WATERFALL_DEPTH);
+	ui->spinBox_waterfallDepth->setValue(m_waterfall->depth());
+
 	ui->widgetPlotContainer->layout()->removeWidget(ui->markerTable);
 	vLayout->addWidget(ui->markerTable);
 
@@ -360,6 +385,8 @@ SpectrumAnalyzer::SpectrumAnalyzer(struct iio_context *ctx, Filter *filt,
 		fft_plot->bottomHandlesArea()->repaint();
 
 		setSampleRate(2 * stop);
+		setZoom(start, stop);
+		updateSweep();
 
 		/* Re-populate the RBW list with the new available values */
 		ui->cmb_rbw->blockSignals(true);
@@ -368,7 +395,7 @@ SpectrumAnalyzer::SpectrumAnalyzer(struct iio_context *ctx, Filter *filt,
 
 		for (; i < bin_sizes.size(); i++) {
 			ui->cmb_rbw->addItem(freq_formatter.format(
-						     sample_rate / bin_sizes[i], "Hz", 2));
+						     fftSampleRate() / bin_sizes[i], "Hz", 2));
 		}
 
 		ui->cmb_rbw->blockSignals(false);
@@ -382,7 +409,7 @@ SpectrumAnalyzer::SpectrumAnalyzer(struct iio_context *ctx, Filter *filt,
 
 	connect(ui->cmb_rbw, QOverload<int>::of(&QComboBox::currentIndexChanged),
 		[=](int index){
-		startStopRange->setMinimumSpanValue(10 * sample_rate / bin_sizes[index]);
+		startStopRange->setMinimumSpanValue(10 * fftSampleRate() / bin_sizes[index]);
 	});
 
 	connect(ui->cmbGainMode, QOverload<int>::of(&QComboBox::currentIndexChanged),
@@ -592,6 +619,8 @@ SpectrumAnalyzer::SpectrumAnalyzer(struct iio_context *ctx, Filter *filt,
 				return;
 			}
 
+			fft_plot->completeSpectrum();
+
 			QVector<double> xData;
 			QVector<double> yData;
 			for (size_t i = 0; i < curve->data()->size(); ++i) {
@@ -797,6 +826,8 @@ void SpectrumAnalyzer::btnExportClicked()
 		FileManager fm("Spectrum Analyzer");
 		fm.open(fileName, FileManager::EXPORT);
 
+		fft_plot->completeSpectrum();
+
 		QVector<double> frequency_data;
 		int nr_samples = fft_plot->Curve(0)->data()->size();
 		for (int i = 0; i < nr_samples; ++i) {
@@ -1804,8 +1835,9 @@ void SpectrumAnalyzer::runStopToggled(bool checked)
 			writeAllSettingsToHardware();
 		}
 
-		fft_plot->presetSampleRate(sample_rate);
+		fft_plot->presetSampleRate(fftSampleRate());
 		fft_sink->set_samp_rate(sample_rate);
+		m_waterfall->clear();
 		m_time_start = std::chrono::system_clock::now();
 		start_blockchain_flow();
 		sample_timer->start(TIMER_TIMEOUT_MS);
@@ -1818,6 +1850,11 @@ void SpectrumAnalyzer::runStopToggled(bool checked)
 		fft_plot->resetAverageHistory();
 	}
 	fft_plot->startStop(checked);
+
+	// A stopped trace is shown whole, it can be panned and read
+	if (!checked) {
+		fft_plot->completeSpectrum();
+	}
 	m_running = checked;
 }
 
@@ -1850,16 +1887,21 @@ void SpectrumAnalyzer::build_gnuradio_block_chain()
 
 	for (size_t i = 0; i < m_adc_nb_channels; i++) {
 		auto fft = gnuradio::get_initial_sptr(
-		                   new fft_block(false, fft_size));
-		auto ctm = gr::blocks::complex_to_mag_squared::make(1);
+		                   new fft_block(false, fft_size, fftThreads()));
+		auto psd = gnuradio::get_initial_sptr(
+		                   new welch_psd_cf(fft_size));
+		auto stitch = gnuradio::get_initial_sptr(
+		                   new sweep_stitch_ff());
 
-		// iio(i)->fft->ctm->fft_sink
+		// iio(i)->fft->psd->stitch->fft_sink
 		fft_ids[i] = iio->connect(fft, i, 0, true, fft_size);
-		iio->connect(fft, 0, ctm, 0);
-		iio->connect(ctm, 0, fft_sink, i);
+		iio->connect(fft, 0, psd, 0);
+		iio->connect(psd, 0, stitch, 0);
+		iio->connect(stitch, 0, fft_sink, i);
 
 		channels[i]->fft_block = fft;
-		channels[i]->ctm_block = ctm;
+		channels[i]->psd_block = psd;
+		channels[i]->sweep_block = stitch;
 	}
 
 	if (started) {
@@ -1880,8 +1922,11 @@ void SpectrumAnalyzer::build_gnuradio_block_chain_no_ctx()
 
 	for (size_t i = 0; i < m_adc_nb_channels; i++) {
 		auto fft = gnuradio::get_initial_sptr(
-		                   new fft_block(false, fft_size));
-		auto ctm = gr::blocks::complex_to_mag_squared::make(1);
+		                   new fft_block(false, fft_size, fftThreads()));
+		auto psd = gnuradio::get_initial_sptr(
+		                   new welch_psd_cf(fft_size));
+		auto stitch = gnuradio::get_initial_sptr(
+		                   new sweep_stitch_ff());
 
 		auto siggen = gr::analog::sig_source_f::make(m_max_sample_rate,
 		                gr::analog::GR_SIN_WAVE, 5e6 + i * 5e6, 2048);
@@ -1890,18 +1935,29 @@ void SpectrumAnalyzer::build_gnuradio_block_chain_no_ctx()
 		auto add = gr::blocks::add_ff::make();
 
 		//siggen->|
-		//        |->add->fft->ctm->fft_sink
+		//        |->add->fft->psd->stitch->fft_sink
 		//noise-->|
 		top_block->connect(siggen, 0, add, 0);
 		top_block->connect(noise, 0, add, 1);
 		top_block->connect(add, 0, fft, 0);
-		top_block->connect(fft, 0, ctm, 0);
-		top_block->connect(ctm, 0, fft_sink, i);
+		top_block->connect(fft, 0, psd, 0);
+		top_block->connect(psd, 0, stitch, 0);
+		top_block->connect(stitch, 0, fft_sink, i);
 
 		channels[i]->fft_block = fft;
+		channels[i]->psd_block = psd;
+		channels[i]->sweep_block = stitch;
 	}
 }
 
+/* The FFT blocks of all channels run side by side and share the cores */
+unsigned int SpectrumAnalyzer::fftThreads() const
+{
+	int channels = std::max<int>(m_adc_nb_channels, 1);
+
+	return std::max(QThread::idealThreadCount() / channels, 1);
+}
+
 void SpectrumAnalyzer::start_blockchain_flow()
 {
 	if (iio) {
@@ -2184,6 +2240,10 @@ void SpectrumAnalyzer::onChannelSelected(bool en)
 	{
 		crt_channel_id = chIdx;
 		Q_EMIT selectedChannelChanged(chIdx);
+
+		if (waterfallEnabled()) {
+			fft_plot->setWaterfallRaster(m_waterfall, chIdx);
+		}
 	}
 
 	if (!cw->isReferenceChannel()) {
@@ -2430,16 +2490,17 @@ void SpectrumAnalyzer::on_cmb_rbw_currentIndexChanged(int index)
 	double update_time = 1.0/getScopyPreferences()->getTarget_fps();
 	switch(bin_sizes[index]) {
 	case 1<<17:
-		fft_sink->set_update_time(update_time * 2);
+		update_time *= 2;
 	break;
 	case 1<<18:
-		fft_sink->set_update_time(update_time * 4);
+		update_time *= 4;
 	break;
 	default:
-		fft_sink->set_update_time(update_time);
 		break;
 	}
 
+	fft_sink->set_update_time(update_time);
+
 	uint new_fft_size = bin_sizes[index];
 
 	if (new_fft_size != fft_size) {
@@ -2483,7 +2544,7 @@ void SpectrumAnalyzer::setSampleRate(double sr)
 			}
 		}
 
-		fft_plot->presetSampleRate(new_sr);
+		fft_plot->presetSampleRate(fftSampleRate());
 		fft_plot->resetAverageHistory();
 		fft_sink->set_samp_rate(new_sr);
 
@@ -2497,10 +2558,6 @@ void SpectrumAnalyzer::setSampleRate(double sr)
 
 void SpectrumAnalyzer::setFftSize(uint size)
 {
-	// TO DO: This is cumbersome. We shouldn't have to rebuild the entire
-	//        block chain every time we need to change the FFT size. A
-	//        spectrum_sink block similar to scope_sink_f would be better
-
 	bool started = isIioManagerStarted();
 
 	if (started) {
@@ -2514,35 +2571,264 @@ void SpectrumAnalyzer::setFftSize(uint size)
 		fft_plot->setNbOverlappingAverages(m_nb_overlapping_avg);
 	}
 
+	/* The FFT blocks change size in place */
 	for (int i = 0; i < channels.size(); i++) {
-		auto fft = gnuradio::get_initial_sptr(
-		                   new fft_block(false, size));
+		channels[i]->fft_block->set_fft_size(size);
+		channels[i]->psd_block->set_fft_size(size);
+		channels[i]->setFftWindow(channels[i]->fftWindow(), size);
 
-		iio->disconnect(fft_ids[i]);
+		iio->set_buffer_size(fft_ids[i], iioBufferSize());
+	}
 
-		fft_ids[i] = iio->connect(fft, i, 0, true, fft_size * m_nb_overlapping_avg);
+	if (started) {
+		iio->unlock();
+	}
 
-		iio->connect(fft, 0, channels[i]->ctm_block, 0);
-		iio->connect(channels[i]->ctm_block, 0, fft_sink, i);
+	sample_timer->stop();
+	setCurrentSampleLabel(0.0);
+	m_time_start = std::chrono::system_clock::now();
+	sample_timer->start(TIMER_TIMEOUT_MS);
 
-		if (started) {
-			iio->start(fft_ids[i]);
+	/* Sweep segments are transforms of the new size */
+	updateSweep();
+}
+
+/*
+ * Narrow bands are zoomed on: the FFT blocks down convert the band to a
+ * lower rate first, so the same FFT size gives a finer resolution. The
+ * decimation is the largest power of two that keeps the whole span in
+ * the flat part of the converted band and its mirror image out of it.
+ */
+void SpectrumAnalyzer::setZoom(double start, double stop)
+{
+	const double span = stop - start;
+	const double center = (start + stop) / 2;
+	unsigned int decimation = 1;
+
+	while (decimation < MAX_ZOOM_DECIMATION) {
+		const double rate = sample_rate / (2 * decimation);
+
+		if (span > 0.8 * rate || center < 0.6 * rate) {
+			break;
 		}
 
-		channels[i]->fft_block = fft;
-		channels[i]->setFftWindow(channels[i]->fftWindow(), size);
+		decimation *= 2;
+	}
 
-		iio->set_buffer_size(fft_ids[i], size * m_nb_overlapping_avg);
+	const double relative_center = decimation > 1 ?
+		center / sample_rate : 0.0;
+
+	if (decimation == zoom_decimation && relative_center == zoom_center) {
+		return;
+	}
+
+	zoom_decimation = decimation;
+	zoom_center = relative_center;
+
+	bool started = isIioManagerStarted();
+
+	if (started) {
+		iio->lock();
+	}
+
+	for (int i = 0; i < channels.size(); i++) {
+		channels[i]->fft_block->set_zoom(zoom_center, zoom_decimation);
+		channels[i]->psd_block->reset();
+
+		if (fft_ids) {
+			iio->set_buffer_size(fft_ids[i], iioBufferSize());
+		}
 	}
 
 	if (started) {
 		iio->unlock();
 	}
 
-	sample_timer->stop();
-	setCurrentSampleLabel(0.0);
-	m_time_start = std::chrono::system_clock::now();
-	sample_timer->start(TIMER_TIMEOUT_MS);
+	fft_plot->presetSampleRate(fftSampleRate());
+	fft_plot->presetZoom(zoom_decimation > 1, zoom_center * sample_rate);
+	fft_plot->resetAverageHistory();
+}
+
+/* Rate of the samples that go into the FFT */
+double SpectrumAnalyzer::fftSampleRate() const
+{
+	return sample_rate / (zoom_decimation * sweep_decimation);
+}
+
+/*
+ * One buffer per spectrum, so every spectrum starts on a buffer. Zoomed
+ * spectra span more samples than the largest buffer we allow; those
+ * get several buffers each.
+ */
+unsigned long SpectrumAnalyzer::iioBufferSize() const
+{
+	return std::min<unsigned long>((unsigned long)fft_size *
+			m_nb_overlapping_avg * zoom_decimation *
+			sweep_decimation, bin_sizes.back());
+}
+
+/*
+ * Spans too wide to zoom on are swept instead, when a resolution is
+ * set: the zoom steps over the span, one spectrum of fft_size bins at
+ * each step, and the plot gets the stitched trace. The decimation is
+ * the smallest that reaches the resolution, so the span takes as few
+ * segments as it can. Every block of the flowgraph runs on its own
+ * thread, so the next segment is captured and down converted while the
+ * previous one is transformed and stitched.
+ */
+void SpectrumAnalyzer::updateSweep()
+{
+	const double start = startStopRange->getStartValue();
+	const double stop = startStopRange->getStopValue();
+	unsigned int decimation = 1;
+
+	if (sweep_resolution > 0 && zoom_decimation == 1) {
+		while (decimation < MAX_ZOOM_DECIMATION &&
+				sample_rate / ((double)decimation * fft_size) >
+				sweep_resolution &&
+				2 * decimation * fft_size * (stop - start) /
+				sample_rate <= MAX_SWEEP_POINTS) {
+			decimation *= 2;
+		}
+	}
+
+	SweepStitcher sweep;
+	sweep.configure(start, stop, sample_rate, fft_size, decimation);
+
+	if (sweep == m_sweep) {
+		return;
+	}
+
+	m_sweep = sweep;
+	sweep_decimation = sweep.empty() ? 1 : decimation;
+
+	bool started = isIioManagerStarted();
+
+	if (started) {
+		iio->lock();
+	}
+
+	/* Welch would average the segments together */
+	const bool welch = fft_plot->magnitudeType() ==
+		FftDisplayPlot::VROOTHZ && m_sweep.empty();
+
+	for (int i = 0; i < channels.size(); i++) {
+		channels[i]->fft_block->set_sweep(m_sweep.centers(),
+						  sweep_decimation);
+		channels[i]->psd_block->reset();
+		channels[i]->psd_block->set_welch(welch);
+		channels[i]->sweep_block->set_stitcher(m_sweep);
+
+		if (fft_ids) {
+			iio->set_buffer_size(fft_ids[i], iioBufferSize());
+		}
+	}
+
+	fft_sink->set_nsamps(m_sweep.empty() ? fft_size : m_sweep.size());
+
+	if (started) {
+		iio->unlock();
+	}
+
+	fft_plot->presetSampleRate(fftSampleRate());
+	fft_plot->presetSweep(m_sweep.empty() ? 0 : fft_size,
+			      m_sweep.startFrequency(), m_sweep.stopFrequency());
+	fft_plot->resetAverageHistory();
+
+	/* The resolutions offered are those of the new FFT rate */
+	for (int i = 0; i < ui->cmb_rbw->count(); i++) {
+		ui->cmb_rbw->setItemText(i, freq_formatter.format(
+				fftSampleRate() / bin_sizes[i], "Hz", 2));
+	}
+}
+
+void SpectrumAnalyzer::setSweepResolution(double resolution)
+{
+	sweep_resolution = std::max(resolution, 0.0);
+	updateSweep();
+}
+
+double SpectrumAnalyzer::sweepResolution() const
+{
+	return sweep_resolution;
+}
+
+unsigned int SpectrumAnalyzer::sweepSegments() const
+{
+	return m_sweep.segments();
+}
+
+void SpectrumAnalyzer::setWaterfallEnabled(bool en)
+{
+	if (en == waterfallEnabled()) {
+		return;
+	}
+
+	fft_plot->setWaterfallRaster(en ? m_waterfall : nullptr,
+				     crt_channel_id);
+	waterfall_plot->setVisible(en);
+	ui->btnWaterfall->setChecked(en);
+}
+
+bool SpectrumAnalyzer::waterfallEnabled() const
+{
+	return !waterfall_plot->isHidden();
+}
+
+void SpectrumAnalyzer::setWaterfallDepth(unsigned int depth)
+{
+	depth = std::min(depth, MAX_WATERFALL_DEPTH);
+
+	if (depth == 0 || depth == m_waterfall->depth()) {
+		return;
+	}
+
+	m_waterfall->configure(depth, m_waterfall->width());
+	waterfall_plot->update();
+	ui->spinBox_waterfallDepth->setValue(depth);
+}
+
+unsigned int SpectrumAnalyzer::waterfallDepth() const
+{
+	return m_waterfall->depth();
+}
+
+/* One column per waterfall row, the oldest first */
+bool SpectrumAnalyzer::exportWaterfall(const QString &fileName)
+{
+	std::vector<double> values, timestamps, frequencies;
+	const unsigned int width = m_waterfall->width();
+
+	m_waterfall->snapshot(values, timestamps);
+	m_waterfall->frequencies(frequencies);
+
+	if (timestamps.empty() || fileName.isEmpty()) {
+		return false;
+	}
+
+	FileManager fm("Spectrum Analyzer");
+	fm.open(fileName, FileManager::EXPORT);
+
+	QVector<double> frequency_data(width);
+	std::copy(frequencies.begin(), frequencies.end(),
+		  frequency_data.begin());
+	fm.save(frequency_data, "Frequency(Hz)");
+
+	const QString unit = ui->lblMagUnit->text();
+
+	for (size_t row = 0; row < timestamps.size(); row++) {
+		const double *first = &values[row * width];
+		QVector<double> data(width);
+
+		std::copy(first, first + width, data.begin());
+
+		fm.save(data, QString("Amplitude(%1) @%2s").arg(unit)
+			.arg(timestamps[row], 0, 'g', 9));
+	}
+
+	fm.performWrite();
+
+	return true;
 }
 
 
@@ -2553,7 +2839,7 @@ void SpectrumAnalyzer::refreshCurrentSampleLabel()
 		return;
 	}
 
-	double time_acquisition = fft_size / sample_rate;
+	double time_acquisition = fft_size / fftSampleRate();
 
 	auto time_now = std::chrono::system_clock::now();
 	std::chrono::duration<double> elapsed_done = time_now - m_time_start;
@@ -2766,7 +3052,7 @@ void SpectrumAnalyzer::onMarkerFreqPosChanged(double freq)
 void SpectrumAnalyzer::updateMrkFreqPosSpinBtnLimits()
 {
 	marker_freq_pos->setMaxValue(startStopRange->getStopValue());
-	marker_freq_pos->setStep(2 * startStopRange->getStopValue() /
+	marker_freq_pos->setStep(fftSampleRate() /
 	                             bin_sizes[ui->cmb_rbw->currentIndex()]);
 
 	updateMrkFreqPosSpinBtnValue();
@@ -2838,6 +3124,11 @@ void SpectrumAnalyzer::on_cmb_units_currentIndexChanged(const QString& unit)
 		} else {
 			channels[i]->fft_block->set_overlap_factor(0.0);
 		}
+
+		/* Density readings get a Welch estimate from the flowgraph,
+		 * unless it would average sweep segments together */
+		channels[i]->psd_block->set_welch(
+			magType == FftDisplayPlot::VROOTHZ && m_sweep.empty());
 	}
 
 	if (started) {
@@ -2935,6 +3226,16 @@ void SpectrumAnalyzer::on_btnHistory_toggled(bool checked)
 	}
 }
 
+void SpectrumAnalyzer::on_btnWaterfall_toggled(bool checked)
+{
+	setWaterfallEnabled(checked);
+}
+
+void SpectrumAnalyzer::on_spinBox_waterfallDepth_valueChanged(int depth)
+{
+	setWaterfallDepth(depth);
+}
+
 void SpectrumAnalyzer::on_btnMarkerTable_toggled(bool checked)
 {
 	ui->markerTable->setVisible(checked);
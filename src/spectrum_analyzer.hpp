@@ -23,12 +23,14 @@
 
 #include <gnuradio/top_block.h>
 #include <gnuradio/fft/window.h>
-#include <gnuradio/blocks/complex_to_mag_squared.h>
 
 #include "apiObject.hpp"
 #include "iio_manager.hpp"
 #include "scope_sink_f.h"
 #include "fft_block.hpp"
+#include "welch_psd_cf.hpp"
+#include "sweep_stitch_ff.hpp"
+#include "sweep_stitcher.hpp"
 #include "FftDisplayPlot.h"
 #include "tool.hpp"
 #include "plot_utils.hpp"
@@ -71,6 +73,7 @@ class SpectrumChannel;
 class Filter;
 class ChannelWidget;
 class DbClickButtons;
+class WaterfallPlot;
 
 #ifdef SPECTRAL_MSR
 class MeasurementData;
@@ -187,6 +190,8 @@ private Q_SLOTS:
 	void onPlotSampleCountUpdated(uint);
 	void singleCaptureDone();
 	void on_btnMarkerTable_toggled(bool checked);
+	void on_btnWaterfall_toggled(bool checked);
+	void on_spinBox_waterfallDepth_valueChanged(int depth);
 	void onTopValueChanged(double);
 	void onScalePerDivValueChanged(double);
 	void onBottomValueChanged(double);
@@ -204,12 +209,26 @@ private:
 	void initInstrumentStrings();
 	void build_gnuradio_block_chain();
 	void build_gnuradio_block_chain_no_ctx();
+	unsigned int fftThreads() const;
 	void start_blockchain_flow();
 	void stop_blockchain_flow();
 	void writeAllSettingsToHardware();
 	int channelIdOfOpenedSettings() const;
 	void setSampleRate(double sr);
 	void setFftSize(uint size);
+	void setZoom(double start, double stop);
+	double fftSampleRate() const;
+	unsigned long iioBufferSize() const;
+	void updateSweep();
+	void setSweepResolution(double resolution);
+	double sweepResolution() const;
+	unsigned int sweepSegments() const;
+
+	void setWaterfallEnabled(bool en);
+	bool waterfallEnabled() const;
+	void setWaterfallDepth(unsigned int depth);
+	unsigned int waterfallDepth() const;
+	bool exportWaterfall(const QString &fileName);
 	void setMarkerEnabled(int ch_idx, int mrk_idx, bool en);
 	void updateWidgetsRelatedToMarker(int mrk_idx);
 	void setCurrentMarkerLabelData(int chIdx, int mkIdx);
@@ -266,6 +285,8 @@ private:
 	QButtonGroup *settings_group;
 	QButtonGroup *channels_group;
 	FftDisplayPlot *fft_plot;
+	WaterfallPlot *waterfall_plot;
+	std::shared_ptr<WaterfallRaster> m_waterfall;
 
 	ScaleSpinButton *top_scale;
 	ScaleSpinButton *bottom_scale;
@@ -294,6 +315,11 @@ private:
 	double sample_rate;
 	double m_max_sample_rate;
 	int sample_rate_divider;
+	unsigned int zoom_decimation;
+	double zoom_center; /* relative to sample_rate */
+	double sweep_resolution; /* 0 when not sweeping */
+	unsigned int sweep_decimation;
+	SweepStitcher m_sweep;
 	uint fft_size;
 	QList<uint> bin_sizes;
 	MetricPrefixFormatter freq_formatter;
@@ -355,7 +381,8 @@ class SpectrumChannel: public QObject
 
 public:
 	boost::shared_ptr<adiscope::fft_block> fft_block;
-	gr::blocks::complex_to_mag_squared::sptr ctm_block;
+	boost::shared_ptr<adiscope::welch_psd_cf> psd_block;
+	boost::shared_ptr<adiscope::sweep_stitch_ff> sweep_block;
 
 	SpectrumChannel(int id, const QString& name, FftDisplayPlot *plot);
 
@@ -23,6 +23,8 @@
 #include "gui/channel_widget.hpp"
 #include "gui/db_click_buttons.hpp"
 
+#include <cmath>
+
 namespace adiscope {
 int SpectrumChannel_API::type()
 {
@@ -79,6 +81,8 @@ QList<double> SpectrumChannel_API::data() const
 {
 	QList<double> list;
 	int i = sp->ch_api.indexOf(const_cast<SpectrumChannel_API*>(this));
+	sp->fft_plot->completeSpectrum();
+
 	int nr_samples = sp->fft_plot->Curve(0)->data()->size();
 	for (int j = 0; j < nr_samples; ++j) {
 		list.push_back(sp->fft_plot->Curve(i)->sample(j).y());
@@ -96,6 +100,75 @@ QList<double> SpectrumChannel_API::freq() const
 	return frequency_data;
 }
 
+QVariantList SpectrumChannel_API::peaks(int count) const
+{
+	QVariantList list;
+	int i = sp->ch_api.indexOf(const_cast<SpectrumChannel_API*>(this));
+
+	if (i < 0 || count <= 0) {
+		return list;
+	}
+
+	auto curve = sp->fft_plot->Curve(i);
+	auto peaks = sp->fft_plot->topPeaks(i, count);
+
+	for (const PeakFinder::Peak &peak : peaks) {
+		if (peak.bin >= curve->data()->size()) {
+			continue;
+		}
+
+		QVariantMap p;
+		p["freq"] = curve->sample(peak.bin).x();
+		p["magnitude"] = peak.value;
+		p["prominence"] = peak.prominence;
+		list.append(p);
+	}
+
+	return list;
+}
+
+double SpectrumChannel_API::channelPower(double start, double stop) const
+{
+	int i = sp->ch_api.indexOf(const_cast<SpectrumChannel_API*>(this));
+
+	return 10 * log10(sp->fft_plot->bandPower(i, start, stop));
+}
+
+QVariantMap SpectrumChannel_API::occupiedBandwidth(double percent) const
+{
+	QVariantMap obw;
+	int i = sp->ch_api.indexOf(const_cast<SpectrumChannel_API*>(this));
+	double low, high;
+
+	if (sp->fft_plot->occupiedBandwidth(i, percent / 100, low, high)) {
+		obw["low"] = low;
+		obw["high"] = high;
+		obw["bandwidth"] = high - low;
+	}
+
+	return obw;
+}
+
+QVariantMap SpectrumChannel_API::acpr(double center, double bandwidth,
+				      double spacing) const
+{
+	QVariantMap ratios;
+	int i = sp->ch_api.indexOf(const_cast<SpectrumChannel_API*>(this));
+	const double half = bandwidth / 2;
+	auto power = [=](double c) {
+		return sp->fft_plot->bandPower(i, c - half, c + half);
+	};
+
+	const double main = power(center);
+
+	if (main > 0) {
+		ratios["lower"] = 10 * log10(power(center - spacing) / main);
+		ratios["upper"] = 10 * log10(power(center + spacing) / main);
+	}
+
+	return ratios;
+}
+
 int SpectrumMarker_API::chId()
 {
 	return m_chid;
@@ -464,4 +537,78 @@ void SpectrumAnalyzer_API::setNotes(QString str)
 {
 	sp->ui->instrumentNotes->setNotes(str);
 }
+
+double SpectrumAnalyzer_API::peakThreshold() const
+{
+	return sp->fft_plot->peakThreshold();
+}
+
+void SpectrumAnalyzer_API::setPeakThreshold(double threshold)
+{
+	sp->fft_plot->setPeakThreshold(threshold);
+}
+
+double SpectrumAnalyzer_API::peakProminence() const
+{
+	return sp->fft_plot->peakProminence();
+}
+
+void SpectrumAnalyzer_API::setPeakProminence(double prominence)
+{
+	sp->fft_plot->setPeakProminence(prominence);
+}
+
+bool SpectrumAnalyzer_API::waterfall() const
+{
+	return sp->waterfallEnabled();
+}
+
+void SpectrumAnalyzer_API::setWaterfall(bool en)
+{
+	sp->setWaterfallEnabled(en);
+}
+
+int SpectrumAnalyzer_API::waterfallDepth() const
+{
+	return sp->waterfallDepth();
+}
+
+void SpectrumAnalyzer_API::setWaterfallDepth(int depth)
+{
+	if (depth > 0) {
+		sp->setWaterfallDepth(depth);
+	}
+}
+
+bool SpectrumAnalyzer_API::exportWaterfall(const QString &fileName)
+{
+	return sp->exportWaterfall(fileName);
+}
+
+double SpectrumAnalyzer_API::sweepResolution() const
+{
+	return sp->sweepResolution();
+}
+
+void SpectrumAnalyzer_API::setSweepResolution(double resolution)
+{
+	sp->setSweepResolution(resolution);
+}
+
+int SpectrumAnalyzer_API::sweepSegments() const
+{
+	return sp->sweepSegments();
+}
+
+double SpectrumAnalyzer_API::logAccuracy() const
+{
+	return sp->fft_plot->logAccuracy();
+}
+
+void SpectrumAnalyzer_API::setLogAccuracy(double dB)
+{
+	if (dB >= 0) {
+		sp->fft_plot->setLogAccuracy(dB);
+	}
+}
 }
@@ -55,8 +55,28 @@ class SpectrumAnalyzer_API : public ApiObject
 	Q_PROPERTY(bool logScale READ getLogScale WRITE setLogScale)
 	Q_PROPERTY(QString notes READ getNotes WRITE setNotes)
 
+	Q_PROPERTY(double peakThreshold READ peakThreshold
+		   WRITE setPeakThreshold STORED false)
+	Q_PROPERTY(double peakProminence READ peakProminence
+		   WRITE setPeakProminence STORED false)
+
+	/* Spectrum history of the selected channel, one row per spectrum */
+	Q_PROPERTY(bool waterfall READ waterfall WRITE setWaterfall)
+	Q_PROPERTY(int waterfallDepth READ waterfallDepth
+		   WRITE setWaterfallDepth)
+
+	/* Spans too wide to zoom on are swept at this resolution, 0 is off */
+	Q_PROPERTY(double sweepResolution READ sweepResolution
+		   WRITE setSweepResolution)
+	Q_PROPERTY(int sweepSegments READ sweepSegments STORED false)
+
+	/* Largest error of the dB conversion in dB, 0 makes it exact */
+	Q_PROPERTY(double logAccuracy READ logAccuracy WRITE setLogAccuracy
+		   STORED false)
+
 public:
 	Q_INVOKABLE void show();
+	Q_INVOKABLE bool exportWaterfall(const QString &fileName);
 	explicit SpectrumAnalyzer_API(SpectrumAnalyzer *sp) :
 		ApiObject(), sp(sp) {}
 	~SpectrumAnalyzer_API() {}
@@ -121,6 +141,25 @@ private:
 	QString getNotes();
 	void setNotes(QString str);
 
+	double peakThreshold() const;
+	void setPeakThreshold(double threshold);
+
+	double peakProminence() const;
+	void setPeakProminence(double prominence);
+
+	bool waterfall() const;
+	void setWaterfall(bool en);
+
+	int waterfallDepth() const;
+	void setWaterfallDepth(int depth);
+
+	double sweepResolution() const;
+	void setSweepResolution(double resolution);
+
+	int sweepSegments() const;
+
+	double logAccuracy() const;
+	void setLogAccuracy(double dB);
 };
 
 class SpectrumChannel_API : public ApiObject
@@ -155,6 +194,25 @@ public:
 	QList<double> data() const;
 	QList<double> freq() const;
 
+	/*
+	 * The count highest peaks of the last spectrum, highest first.
+	 * Each one is an object with freq, magnitude and prominence.
+	 */
+	Q_INVOKABLE QVariantList peaks(int count) const;
+
+	/*
+	 * Band measurements on the last spectrum, frequencies in Hz.
+	 * channelPower is the power between start and stop in dBV.
+	 * occupiedBandwidth returns {low, high, bandwidth} for the band
+	 * holding percent of the power. acpr returns {lower, upper}: the
+	 * power of the channels spacing Hz below and above the one at
+	 * center, all bandwidth Hz wide, relative to it in dBc.
+	 */
+	Q_INVOKABLE double channelPower(double start, double stop) const;
+	Q_INVOKABLE QVariantMap occupiedBandwidth(double percent) const;
+	Q_INVOKABLE QVariantMap acpr(double center, double bandwidth,
+				     double spacing) const;
+
 private:
 	SpectrumAnalyzer *sp;
 	boost::shared_ptr<SpectrumChannel> spch;
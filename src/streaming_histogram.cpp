@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "streaming_histogram.hpp"
+
+#include <algorithm>
+#include <limits>
+
+using namespace adiscope;
+
+StreamingHistogram::StreamingHistogram(unsigned int nchannels,
+				       unsigned int bins):
+	d_bins(0),
+	d_left(0),
+	d_right(1),
+	d_width(1)
+{
+	configure(nchannels, bins);
+}
+
+void StreamingHistogram::configure(unsigned int nchannels, unsigned int bins)
+{
+	d_bins = bins;
+	d_counts.assign(nchannels, std::vector<uint32_t>(bins + 2, 0));
+	setRange(d_left, d_right);
+}
+
+void StreamingHistogram::clear()
+{
+	for (std::vector<uint32_t> &c : d_counts) {
+		std::fill(c.begin(), c.end(), 0);
+	}
+}
+
+void StreamingHistogram::setRange(double left, double right)
+{
+	d_left = left;
+	d_right = right;
+	d_width = d_bins ? (right - left) / d_bins : 0;
+	clear();
+}
+
+void StreamingHistogram::add(unsigned int channel, const float *data,
+			     size_t size)
+{
+	if (channel >= d_counts.size() || !(d_width > 0)) {
+		return;
+	}
+
+	const double scale = 1.0 / d_width;
+	const double offset = 0.5 - d_left * scale;
+	const double top = d_bins;
+
+	d_index.resize(size);
+	int *index = d_index.data();
+
+	// Round to the nearest bin center. Branch free so that the compiler
+	// can vectorize it; samples out of range and NaNs end up in one of
+	// the two guard bins.
+	for (size_t i = 0; i < size; i++) {
+		double r = data[i] * scale + offset;
+		r = !(r >= 0.0) ? -1.0 : r;
+		r = r > top ? top : r;
+		index[i] = (int)r + 1;
+	}
+
+	uint32_t *counts = d_counts[channel].data();
+
+	for (size_t i = 0; i < size; i++) {
+		counts[index[i]]++;
+	}
+}
+
+void StreamingHistogram::copyCounts(unsigned int channel, double *out) const
+{
+	if (channel >= d_counts.size()) {
+		return;
+	}
+
+	const uint32_t *counts = d_counts[channel].data() + 1;
+
+	for (unsigned int i = 0; i < d_bins; i++) {
+		out[i] = counts[i];
+	}
+}
+
+void StreamingHistogram::minMax(const float *data, size_t size,
+				float &min, float &max)
+{
+	// Independent lanes, so that the compiler can vectorize the loop
+	// without reordering a floating point reduction
+	const size_t LANES = 16;
+	float lo[LANES];
+	float hi[LANES];
+
+	std::fill(lo, lo + LANES, std::numeric_limits<float>::infinity());
+	std::fill(hi, hi + LANES, -std::numeric_limits<float>::infinity());
+
+	size_t i = 0;
+	for (; i + LANES <= size; i += LANES) {
+		for (size_t j = 0; j < LANES; j++) {
+			lo[j] = data[i + j] < lo[j] ? data[i + j] : lo[j];
+			hi[j] = data[i + j] > hi[j] ? data[i + j] : hi[j];
+		}
+	}
+
+	for (; i < size; i++) {
+		lo[0] = data[i] < lo[0] ? data[i] : lo[0];
+		hi[0] = data[i] > hi[0] ? data[i] : hi[0];
+	}
+
+	min = *std::min_element(lo, lo + LANES);
+	max = *std::max_element(hi, hi + LANES);
+}
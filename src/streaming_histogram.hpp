@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STREAMING_HISTOGRAM_HPP
+#define STREAMING_HISTOGRAM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace adiscope {
+
+/*
+ * Per channel integer bin counts over a fixed range. Bin k is centered on
+ * left() + k * binWidth(); samples that round outside of [0, bins()) are
+ * not counted. Adding samples only ever increments the counts, so
+ * accumulating over many buffers costs nothing more than binning each of
+ * them once.
+ *
+ * Not thread safe: it is meant to be owned by a single sink thread.
+ */
+class StreamingHistogram
+{
+public:
+	StreamingHistogram(unsigned int nchannels = 0, unsigned int bins = 0);
+
+	/* Reallocates the counts; the range is kept */
+	void configure(unsigned int nchannels, unsigned int bins);
+	void clear();
+
+	/* Sets the span covered by the bins and clears the counts */
+	void setRange(double left, double right);
+
+	double left() const { return d_left; }
+	double right() const { return d_right; }
+	double binWidth() const { return d_width; }
+
+	unsigned int numChannels() const { return d_counts.size(); }
+	unsigned int bins() const { return d_bins; }
+
+	void add(unsigned int channel, const float *data, size_t size);
+
+	/* Copies the bins() counts of a channel */
+	void copyCounts(unsigned int channel, double *out) const;
+
+	/* Smallest and largest sample of data; NaNs are ignored */
+	static void minMax(const float *data, size_t size,
+			   float &min, float &max);
+
+private:
+	unsigned int d_bins;
+	double d_left;
+	double d_right;
+	double d_width;
+
+	/* Every channel has a guard bin at each end for samples out of range */
+	std::vector<std::vector<uint32_t>> d_counts;
+	std::vector<int> d_index;
+};
+
+} /* namespace adiscope */
+
+#endif /* STREAMING_HISTOGRAM_HPP */
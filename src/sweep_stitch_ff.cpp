@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sweep_stitch_ff.hpp"
+
+#include <gnuradio/io_signature.h>
+
+#include <algorithm>
+#include <string.h>
+
+using namespace adiscope;
+using namespace gr;
+
+sweep_stitch_ff::sweep_stitch_ff()
+	: block("sweep_stitch_ff",
+			io_signature::make(1, 1, sizeof(float)),
+			io_signature::make(1, 1, sizeof(float))),
+	d_segment_key(pmt::intern("sweep_segment")),
+	d_trace_key(pmt::intern("buffer_start")),
+	d_segment(-1),
+	d_pos(0),
+	d_out_pos(0),
+	d_pending(false)
+{
+	set_tag_propagation_policy(TPP_DONT);
+}
+
+sweep_stitch_ff::~sweep_stitch_ff()
+{
+}
+
+void sweep_stitch_ff::restart()
+{
+	d_segment = -1;
+	d_pos = 0;
+	d_out_pos = 0;
+	d_pending = false;
+}
+
+void sweep_stitch_ff::set_stitcher(const SweepStitcher &stitcher)
+{
+	gr::thread::scoped_lock lock(d_setlock);
+
+	d_stitcher = stitcher;
+	d_frame.resize(stitcher.fftSize());
+	restart();
+}
+
+void sweep_stitch_ff::forecast(int noutput_items,
+			       gr_vector_int &ninput_items_required)
+{
+	// A trace still going out needs no input
+	ninput_items_required[0] = d_pending ? 0 : 1;
+}
+
+void sweep_stitch_ff::add_segment(const float *power)
+{
+	if (d_stitcher.add(d_segment, power)) {
+		d_out = d_stitcher.trace();
+		d_out_pos = 0;
+		d_pending = true;
+	}
+
+	d_segment = -1;
+	d_pos = 0;
+}
+
+int sweep_stitch_ff::general_work(int noutput_items,
+				  gr_vector_int &ninput_items,
+				  gr_vector_const_void_star &input_items,
+				  gr_vector_void_star &output_items)
+{
+	gr::thread::scoped_lock lock(d_setlock);
+
+	const float *in = static_cast<const float *>(input_items[0]);
+	float *out = static_cast<float *>(output_items[0]);
+	const size_t available = ninput_items[0];
+	std::vector<tag_t> tags;
+
+	if (d_stitcher.empty()) {
+		const size_t n = std::min<size_t>(available, noutput_items);
+
+		memcpy(out, in, n * sizeof(float));
+
+		get_tags_in_range(tags, 0, nitems_read(0), nitems_read(0) + n);
+		for (tag_t tag : tags) {
+			tag.offset = tag.offset - nitems_read(0) + nitems_written(0);
+			add_item_tag(0, tag);
+		}
+
+		consume_each(n);
+		return n;
+	}
+
+	const size_t fft_size = d_stitcher.fftSize();
+	size_t consumed = 0;
+	int produced = 0;
+
+	while (produced < noutput_items) {
+		if (d_pending) {
+			const size_t n = std::min<size_t>(d_out.size() - d_out_pos,
+							  noutput_items - produced);
+
+			if (d_out_pos == 0) {
+				add_item_tag(0, nitems_written(0) + produced,
+					     d_trace_key, pmt::PMT_T);
+			}
+
+			memcpy(out + produced, &d_out[d_out_pos], n * sizeof(float));
+			produced += n;
+			d_out_pos += n;
+			d_pending = d_out_pos < d_out.size();
+			continue;
+		}
+
+		if (consumed == available) {
+			break;
+		}
+
+		const uint64_t start = nitems_read(0) + consumed;
+
+		// Skip to the first bin of the next segment
+		if (d_segment < 0) {
+			tags.clear();
+			get_tags_in_range(tags, 0, start,
+					  nitems_read(0) + available,
+					  d_segment_key);
+
+			if (tags.empty()) {
+				consumed = available;
+				break;
+			}
+
+			const tag_t &tag = *std::min_element(tags.begin(),
+					tags.end(), tag_t::offset_compare);
+
+			consumed = tag.offset - nitems_read(0);
+			d_segment = pmt::to_uint64(tag.value);
+			d_pos = 0;
+			continue;
+		}
+
+		size_t n = std::min(available - consumed, fft_size - d_pos);
+
+		// A segment that starts early means this one was cut short,
+		// e.g. by an FFT size change upstream
+		tags.clear();
+		get_tags_in_range(tags, 0, start + (d_pos == 0), start + n,
+				  d_segment_key);
+
+		if (!tags.empty()) {
+			const tag_t &tag = *std::min_element(tags.begin(),
+					tags.end(), tag_t::offset_compare);
+
+			consumed = tag.offset - nitems_read(0);
+			d_segment = -1;
+			continue;
+		}
+
+		// Whole segments are blended straight from the input
+		if (d_pos == 0 && n == fft_size) {
+			add_segment(in + consumed);
+		} else {
+			memcpy(&d_frame[d_pos], in + consumed, n * sizeof(float));
+			d_pos += n;
+
+			if (d_pos == fft_size) {
+				add_segment(d_frame.data());
+			}
+		}
+
+		consumed += n;
+	}
+
+	consume_each(consumed);
+	return produced;
+}
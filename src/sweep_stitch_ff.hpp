@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SWEEP_STITCH_FF_HPP
+#define SWEEP_STITCH_FF_HPP
+
+#include <gnuradio/block.h>
+
+#include "sweep_stitcher.hpp"
+
+#include <vector>
+
+namespace adiscope {
+	/*
+	 * Stitches the power spectra of a sweeping fft_block into one
+	 * trace per sweep, of stitcher.size() items. Segments are found
+	 * by their "sweep_segment" tag; every trace starts with a
+	 * "buffer_start" tag.
+	 *
+	 * Without a stitcher, items and tags are passed through.
+	 */
+	class sweep_stitch_ff : public gr::block
+	{
+	public:
+		sweep_stitch_ff();
+		~sweep_stitch_ff();
+
+		/* Drops the segments received so far */
+		void set_stitcher(const SweepStitcher &stitcher);
+
+		void forecast(int noutput_items,
+			      gr_vector_int &ninput_items_required);
+		int general_work(int noutput_items,
+				 gr_vector_int &ninput_items,
+				 gr_vector_const_void_star &input_items,
+				 gr_vector_void_star &output_items);
+
+	private:
+		void restart();
+		void add_segment(const float *power);
+
+		SweepStitcher d_stitcher;
+		pmt::pmt_t d_segment_key;
+		pmt::pmt_t d_trace_key;
+
+		/* Segment being received, -1 while looking for one */
+		long d_segment;
+		std::vector<float> d_frame;
+		size_t d_pos;
+
+		/* Trace waiting for output space */
+		std::vector<float> d_out;
+		size_t d_out_pos;
+		bool d_pending;
+	};
+}
+
+#endif /* SWEEP_STITCH_FF_HPP */
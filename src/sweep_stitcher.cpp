@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sweep_stitcher.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace adiscope;
+
+/* Part of the decimated rate the down converter keeps flat */
+static const double USABLE_BAND = 0.8;
+
+/* Part of the used bins of a segment crossfaded with a neighbour */
+static const size_t OVERLAP_DIVIDER = 8;
+
+SweepStitcher::SweepStitcher():
+	d_start(0),
+	d_binWidth(0),
+	d_sampleRate(0),
+	d_fftSize(0),
+	d_decimation(1),
+	d_next(0)
+{
+}
+
+void SweepStitcher::configure(double start, double stop, double sampleRate,
+			      size_t fftSize, unsigned int decimation)
+{
+	clear();
+
+	if (decimation <= 1 || fftSize < 2 || !(stop > start) ||
+			!(sampleRate > 0)) {
+		return;
+	}
+
+	const double binWidth = sampleRate / decimation / fftSize;
+	const size_t size = std::max<long>(std::lround((stop - start) /
+						       binWidth), 1);
+	const size_t margin = std::ceil(fftSize * (1 - USABLE_BAND) / 2);
+	const size_t usable = fftSize - 2 * margin;
+	const size_t overlap = std::max<size_t>(usable / OVERLAP_DIVIDER, 1);
+	const size_t step = usable - overlap;
+	const size_t count = size <= usable ? 1 :
+		1 + (size - usable + step - 1) / step;
+
+	d_start = start;
+	d_binWidth = binWidth;
+	d_sampleRate = sampleRate;
+	d_fftSize = fftSize;
+	d_decimation = decimation;
+	d_segments.resize(count);
+	d_centers.resize(count);
+	d_trace.assign(size, 0.0f);
+
+	std::vector<float> sum(size, 0.0f);
+
+	for (size_t k = 0; k < count; k++) {
+		Segment &s = d_segments[k];
+
+		// The last segment ends with the band
+		const size_t first = size <= usable ? 0 :
+			std::min(k * step, size - usable);
+
+		s.offset = (long)first - (long)margin;
+		s.first = margin;
+		s.count = std::min(usable, size - first);
+		s.weights.resize(s.count);
+
+		// Bin fftSize / 2 of a segment is its center
+		d_centers[k] = (start + (s.offset + (double)(fftSize / 2)) *
+				binWidth) / sampleRate;
+
+		// Linear ramps over the bins shared with a neighbour
+		for (size_t i = 0; i < s.count; i++) {
+			float w = 1.0f;
+
+			if (k > 0) {
+				w = std::min(w, (i + 0.5f) / overlap);
+			}
+			if (k + 1 < count) {
+				w = std::min(w, (s.count - i - 0.5f) / overlap);
+			}
+
+			s.weights[i] = w;
+			sum[first + i] += w;
+		}
+	}
+
+	// Normalize once here, so that blending is a single multiply-add
+	for (Segment &s : d_segments) {
+		const float *total = &sum[s.offset + s.first];
+
+		for (size_t i = 0; i < s.count; i++) {
+			s.weights[i] /= total[i];
+		}
+	}
+}
+
+void SweepStitcher::clear()
+{
+	d_start = 0;
+	d_binWidth = 0;
+	d_sampleRate = 0;
+	d_fftSize = 0;
+	d_decimation = 1;
+	d_segments.clear();
+	d_centers.clear();
+	d_trace.clear();
+	d_next = 0;
+}
+
+bool SweepStitcher::empty() const
+{
+	return d_segments.empty();
+}
+
+unsigned int SweepStitcher::segments() const
+{
+	return d_segments.size();
+}
+
+size_t SweepStitcher::fftSize() const
+{
+	return d_fftSize;
+}
+
+unsigned int SweepStitcher::decimation() const
+{
+	return d_decimation;
+}
+
+const std::vector<double> &SweepStitcher::centers() const
+{
+	return d_centers;
+}
+
+size_t SweepStitcher::size() const
+{
+	return d_trace.size();
+}
+
+double SweepStitcher::startFrequency() const
+{
+	return d_start;
+}
+
+double SweepStitcher::stopFrequency() const
+{
+	return d_start + d_trace.size() * d_binWidth;
+}
+
+bool SweepStitcher::add(unsigned int segment, const float *power)
+{
+	if (segment >= d_segments.size()) {
+		return false;
+	}
+
+	if (segment == 0) {
+		std::fill(d_trace.begin(), d_trace.end(), 0.0f);
+		d_next = 0;
+	}
+
+	// A sweep that missed a segment is only finished at the next one
+	if (segment != d_next) {
+		return false;
+	}
+
+	const Segment &s = d_segments[segment];
+	const float *src = power + s.first;
+	const float *w = s.weights.data();
+	float *dst = &d_trace[s.offset + s.first];
+
+	for (size_t i = 0; i < s.count; i++) {
+		dst[i] += w[i] * src[i];
+	}
+
+	d_next++;
+	return d_next == d_segments.size();
+}
+
+const std::vector<float> &SweepStitcher::trace() const
+{
+	return d_trace;
+}
+
+bool SweepStitcher::operator==(const SweepStitcher &other) const
+{
+	return d_start == other.d_start &&
+		d_binWidth == other.d_binWidth &&
+		d_sampleRate == other.d_sampleRate &&
+		d_fftSize == other.d_fftSize &&
+		d_decimation == other.d_decimation &&
+		d_trace.size() == other.d_trace.size();
+}
+
+bool SweepStitcher::operator!=(const SweepStitcher &other) const
+{
+	return !(*this == other);
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SWEEP_STITCHER_HPP
+#define SWEEP_STITCHER_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace adiscope {
+
+/*
+ * Covers a band too wide for a single zoom with several zoomed spectra,
+ * one per segment, and stitches their power into one trace.
+ *
+ * Every segment is the two sided spectrum of fftSize() bins of the input
+ * down converted by decimation(); only its flat middle, 0.8 of the
+ * decimated rate, is used. The segment centers are placed so that their
+ * bins fall on the bins of the trace, and neighbouring segments overlap
+ * by a few bins which are crossfaded. The last segment is moved back to
+ * end with the band, so it may overlap its neighbour by more.
+ */
+class SweepStitcher
+{
+public:
+	SweepStitcher();
+
+	/*
+	 * Band from start to stop, in Hz, of an input of the given sample
+	 * rate. A decimation of 1 or an empty band clears the plan.
+	 */
+	void configure(double start, double stop, double sampleRate,
+		       size_t fftSize, unsigned int decimation);
+	void clear();
+
+	bool empty() const;
+	unsigned int segments() const;
+	size_t fftSize() const;
+	unsigned int decimation() const;
+
+	/* Centers of the segments, relative to the input sample rate */
+	const std::vector<double> &centers() const;
+
+	/* Bins of the stitched trace and the band they cover */
+	size_t size() const;
+	double startFrequency() const;
+	double stopFrequency() const;
+
+	/*
+	 * Blends the power of one segment, lowest frequency first, into
+	 * the trace. Returns true once the last segment completes a sweep
+	 * that got every segment in order; the trace then stays as it is
+	 * until the next sweep begins with segment 0.
+	 */
+	bool add(unsigned int segment, const float *power);
+	const std::vector<float> &trace() const;
+
+	bool operator==(const SweepStitcher &other) const;
+	bool operator!=(const SweepStitcher &other) const;
+
+private:
+	struct Segment {
+		/* Bin of the trace the first bin of the segment falls on */
+		long offset;
+
+		/* Used bins, within the segment, and their weights */
+		size_t first;
+		size_t count;
+		std::vector<float> weights;
+	};
+
+	double d_start;
+	double d_binWidth;
+	double d_sampleRate;
+	size_t d_fftSize;
+	unsigned int d_decimation;
+
+	std::vector<Segment> d_segments;
+	std::vector<double> d_centers;
+	std::vector<float> d_trace;
+	unsigned int d_next;
+};
+
+} /* namespace adiscope */
+
+#endif /* SWEEP_STITCHER_HPP */
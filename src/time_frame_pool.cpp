@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "time_frame_pool.hpp"
+
+#include <atomic>
+#include <string.h>
+#include <volk/volk.h>
+
+using namespace adiscope;
+
+/* Generation 0 is never used, it stands for data of unknown origin */
+static std::atomic<uint64_t> s_generation(0);
+
+TimeFrame::TimeFrame(unsigned int nchannels, size_t size):
+	d_size(size)
+{
+	restart();
+
+	for (unsigned int i = 0; i < nchannels; i++) {
+		double *buf = static_cast<double *>(volk_malloc(
+				size * sizeof(double), volk_get_alignment()));
+		memset(buf, 0, size * sizeof(double));
+		d_channels.push_back(buf);
+	}
+}
+
+TimeFrame::~TimeFrame()
+{
+	for (auto buf : d_channels) {
+		volk_free(buf);
+	}
+}
+
+void TimeFrame::restart()
+{
+	d_generation = ++s_generation;
+}
+
+TimeFramePool::TimeFramePool(unsigned int nchannels, size_t frameSize,
+			     unsigned int capacity):
+	d_nchannels(nchannels),
+	d_frameSize(frameSize),
+	d_capacity(capacity)
+{
+	// Allocated up front so acquire() never allocates on the producer side
+	for (unsigned int i = 0; i < d_capacity; i++) {
+		d_frames.push_back(std::make_shared<TimeFrame>(d_nchannels,
+							       d_frameSize));
+	}
+}
+
+std::shared_ptr<TimeFrame> TimeFramePool::acquire()
+{
+	// Only the producer thread acquires frames, so a frame seen with a
+	// single (pool) reference cannot be picked up by anyone else meanwhile.
+	for (const auto &frame : d_frames) {
+		if (frame.use_count() == 1) {
+			return frame;
+		}
+	}
+
+	return nullptr;
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIME_FRAME_POOL_HPP
+#define TIME_FRAME_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace adiscope {
+
+/*
+ * A block of per-channel sample buffers that a sink fills and hands over to
+ * a plot by reference. Ownership is shared: the sink, the pool and any event
+ * still in flight towards the GUI each hold a reference.
+ */
+class TimeFrame
+{
+public:
+	TimeFrame(unsigned int nchannels, size_t size);
+	~TimeFrame();
+
+	TimeFrame(const TimeFrame&) = delete;
+	TimeFrame& operator=(const TimeFrame&) = delete;
+
+	double *channel(unsigned int idx) { return d_channels[idx]; }
+	const double *channel(unsigned int idx) const { return d_channels[idx]; }
+
+	unsigned int numChannels() const { return d_channels.size(); }
+	size_t size() const { return d_size; }
+
+	/*
+	 * Changes whenever the producer starts writing new samples into the
+	 * frame from the beginning; unique across all frames. While it stays
+	 * the same, samples already written are only ever added to.
+	 */
+	uint64_t generation() const { return d_generation; }
+	void restart();
+
+private:
+	std::vector<double *> d_channels;
+	size_t d_size;
+	uint64_t d_generation;
+};
+
+/*
+ * Fixed-capacity set of TimeFrames. A frame is free when the pool holds the
+ * only reference to it; all frames are allocated by the constructor.
+ * acquire() returns nullptr when every frame is still in use, which lets
+ * the producer drop a frame instead of queueing unbounded work on the GUI.
+ */
+class TimeFramePool
+{
+public:
+	TimeFramePool(unsigned int nchannels = 0, size_t frameSize = 0,
+		      unsigned int capacity = 3);
+
+	std::shared_ptr<TimeFrame> acquire();
+
+	unsigned int numChannels() const { return d_nchannels; }
+	size_t frameSize() const { return d_frameSize; }
+
+private:
+	unsigned int d_nchannels;
+	size_t d_frameSize;
+	unsigned int d_capacity;
+	std::vector<std::shared_ptr<TimeFrame>> d_frames;
+};
+
+} /* namespace adiscope */
+
+#endif /* TIME_FRAME_POOL_HPP */
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "waterfall_plot.hpp"
+#include "waterfall_raster.hpp"
+
+#include <QPainter>
+
+using namespace adiscope;
+
+WaterfallPlot::WaterfallPlot(QWidget *parent):
+	QWidget(parent)
+{
+	setAttribute(Qt::WA_OpaquePaintEvent);
+	setMinimumHeight(100);
+}
+
+void WaterfallPlot::setRaster(const std::shared_ptr<WaterfallRaster> &raster)
+{
+	d_raster = raster;
+	update();
+}
+
+void WaterfallPlot::setAlignmentWidget(QWidget *widget)
+{
+	d_alignment = widget;
+	update();
+}
+
+void WaterfallPlot::paintEvent(QPaintEvent *)
+{
+	QPainter p(this);
+	QRect target = rect();
+
+	p.fillRect(target, Qt::black);
+
+	if (!d_raster) {
+		return;
+	}
+
+	if (d_alignment) {
+		QPoint left = mapFrom(window(),
+			d_alignment->mapTo(window(), QPoint(0, 0)));
+
+		target.setLeft(left.x());
+		target.setWidth(d_alignment->width());
+	}
+
+	d_raster->draw(&p, target);
+}
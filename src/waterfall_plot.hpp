@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WATERFALL_PLOT_HPP
+#define WATERFALL_PLOT_HPP
+
+#include <QPointer>
+#include <QWidget>
+
+#include <memory>
+
+namespace adiscope {
+
+class WaterfallRaster;
+
+/*
+ * Paints a WaterfallRaster. The image spans horizontally the same pixels
+ * as the alignment widget, usually the canvas of the spectrum plot, so
+ * that the columns line up with the frequency axis above.
+ */
+class WaterfallPlot : public QWidget
+{
+	Q_OBJECT
+
+public:
+	explicit WaterfallPlot(QWidget *parent = nullptr);
+
+	void setRaster(const std::shared_ptr<WaterfallRaster> &raster);
+	void setAlignmentWidget(QWidget *widget);
+
+protected:
+	void paintEvent(QPaintEvent *) Q_DECL_OVERRIDE;
+
+private:
+	std::shared_ptr<WaterfallRaster> d_raster;
+	QPointer<QWidget> d_alignment;
+};
+
+} /* namespace adiscope */
+
+#endif /* WATERFALL_PLOT_HPP */
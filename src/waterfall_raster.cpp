@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "waterfall_raster.hpp"
+
+#include <QPainter>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace adiscope;
+
+/* Black through blue, cyan and yellow to red */
+static const struct {
+	double pos;
+	int r, g, b;
+} COLOR_STOPS[] = {
+	{ 0.00,   0,   0,   0 },
+	{ 0.25,   0,   0, 255 },
+	{ 0.50,   0, 255, 255 },
+	{ 0.75, 255, 255,   0 },
+	{ 1.00, 255,   0,   0 },
+};
+
+static const int NB_COLORS = 256;
+
+WaterfallRaster::WaterfallRaster(unsigned int depth, unsigned int width):
+	d_depth(0),
+	d_width(0),
+	d_head(0),
+	d_count(0),
+	d_min(-120.0),
+	d_max(0.0),
+	d_left(0),
+	d_right(0),
+	d_log(false),
+	d_frameSize(0),
+	d_start(0),
+	d_stop(0)
+{
+	configure(depth, width);
+}
+
+double WaterfallRaster::now()
+{
+	using namespace std::chrono;
+
+	return duration_cast<duration<double>>(
+		steady_clock::now().time_since_epoch()).count();
+}
+
+void WaterfallRaster::buildColorTable()
+{
+	const int nb_stops = sizeof(COLOR_STOPS) / sizeof(COLOR_STOPS[0]);
+	QVector<QRgb> table(NB_COLORS);
+
+	for (int i = 0; i < NB_COLORS; i++) {
+		const double pos = (double)i / (NB_COLORS - 1);
+		int s = 1;
+
+		while (s < nb_stops - 1 && COLOR_STOPS[s].pos < pos) {
+			s++;
+		}
+
+		const double t = (pos - COLOR_STOPS[s - 1].pos) /
+			(COLOR_STOPS[s].pos - COLOR_STOPS[s - 1].pos);
+		auto mix = [t](int a, int b) {
+			return (int)std::lround(a + (b - a) * t);
+		};
+
+		table[i] = qRgb(mix(COLOR_STOPS[s - 1].r, COLOR_STOPS[s].r),
+				mix(COLOR_STOPS[s - 1].g, COLOR_STOPS[s].g),
+				mix(COLOR_STOPS[s - 1].b, COLOR_STOPS[s].b));
+	}
+
+	d_image.setColorTable(table);
+}
+
+void WaterfallRaster::configure(unsigned int depth, unsigned int width)
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+
+	d_depth = std::max(depth, 1u);
+	d_width = std::max(width, 1u);
+
+	d_image = QImage(d_width, d_depth, QImage::Format_Indexed8);
+	buildColorTable();
+	d_image.fill(0);
+
+	d_values.assign((size_t)d_depth * d_width, 0.0f);
+	d_timestamps.assign(d_depth, 0.0);
+	d_head = 0;
+	d_count = 0;
+
+	// Recomputed by the next push
+	d_frameSize = 0;
+}
+
+void WaterfallRaster::clear()
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+
+	d_image.fill(0);
+	d_head = 0;
+	d_count = 0;
+}
+
+void WaterfallRaster::setRange(double min, double max)
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+
+	if (!(max > min) || (min == d_min && max == d_max)) {
+		return;
+	}
+
+	d_min = min;
+	d_max = max;
+
+	for (unsigned int i = 0; i < d_count; i++) {
+		paintRow((d_head + i) % d_depth);
+	}
+}
+
+void WaterfallRaster::setView(double left, double right, bool log)
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+
+	if (left == d_left && right == d_right && log == d_log) {
+		return;
+	}
+
+	d_left = left;
+	d_right = right;
+	d_log = log;
+
+	// Rows of the old view no longer line up with the axis
+	d_frameSize = 0;
+	d_image.fill(0);
+	d_count = 0;
+}
+
+double WaterfallRaster::rangeMin() const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	return d_min;
+}
+
+double WaterfallRaster::rangeMax() const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	return d_max;
+}
+
+void WaterfallRaster::paintRow(unsigned int row)
+{
+	const float *values = &d_values[(size_t)row * d_width];
+	uchar *pixels = d_image.scanLine(row);
+	const float offset = d_min;
+	const float scale = (NB_COLORS - 1) / (d_max - d_min);
+	const float top = NB_COLORS - 1;
+
+	// Branch free so that the compiler can vectorize it. NaNs get the
+	// first colour.
+	for (unsigned int i = 0; i < d_width; i++) {
+		float index = (values[i] - offset) * scale;
+		index = !(index >= 0.0f) ? 0.0f : index;
+		index = index > top ? top : index;
+		pixels[i] = (uchar)index;
+	}
+}
+
+/*
+ * Places the column edges on the frequency axis, then finds the bin under
+ * every edge. Bin b covers [start + b * step, start + (b + 1) * step).
+ */
+void WaterfallRaster::mapColumns(size_t size, double start, double stop)
+{
+	double left = d_left, right = d_right;
+
+	if (left == right) {
+		left = start;
+		right = stop;
+	}
+
+	// Log steps need a positive axis, as for the scale engine
+	const bool log = d_log && left > 0.0 && right > 0.0;
+	const double step = (stop - start) / size;
+
+	d_edges.resize(d_width + 1);
+	d_columns.resize(d_width + 1);
+
+	for (unsigned int i = 0; i <= d_width; i++) {
+		const double t = (double)i / d_width;
+		const double edge = log ? left * std::pow(right / left, t) :
+			left + (right - left) * t;
+		const double bin = std::floor((edge - start) / step);
+
+		// Edges beyond the spectrum only need to stay beyond it
+		d_edges[i] = edge;
+		d_columns[i] = (long long)std::min(std::max(bin, -1.0),
+						   (double)size + 1);
+	}
+}
+
+void WaterfallRaster::push(const double *data, size_t size, double start,
+			   double stop)
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+
+	if (size == 0 || !(stop > start)) {
+		return;
+	}
+
+	if (size != d_frameSize || start != d_start || stop != d_stop) {
+		mapColumns(size, start, stop);
+
+		d_frameSize = size;
+		d_start = start;
+		d_stop = stop;
+		d_image.fill(0);
+		d_count = 0;
+	}
+
+	// The newest row is written just above the previous one
+	d_head = (d_head + d_depth - 1) % d_depth;
+	float *row = &d_values[(size_t)d_head * d_width];
+	const long long bins = size;
+
+	// A column narrower than a bin shows the bin under its left edge
+	for (unsigned int i = 0; i < d_width; i++) {
+		const long long first = std::max(d_columns[i], 0LL);
+		const long long last = std::min(std::max(d_columns[i + 1],
+					d_columns[i] + 1), bins);
+
+		if (first >= last) {
+			row[i] = NAN;
+			continue;
+		}
+
+		double value = data[first];
+
+		for (long long j = first + 1; j < last; j++) {
+			value = std::max(value, data[j]);
+		}
+
+		row[i] = value;
+	}
+
+	d_timestamps[d_head] = now();
+	d_count = std::min(d_count + 1, d_depth);
+	paintRow(d_head);
+}
+
+void WaterfallRaster::draw(QPainter *painter, const QRect &target) const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+
+	if (d_count == 0) {
+		return;
+	}
+
+	// The ring is drawn from d_head to its end, then from its start
+	const double rowHeight = (double)target.height() / d_depth;
+	const unsigned int first = std::min(d_count, d_depth - d_head);
+	const unsigned int second = d_count - first;
+
+	painter->drawImage(QRectF(target.left(), target.top(),
+				  target.width(), first * rowHeight),
+			   d_image, QRectF(0, d_head, d_width, first));
+
+	if (second > 0) {
+		painter->drawImage(QRectF(target.left(),
+					  target.top() + first * rowHeight,
+					  target.width(), second * rowHeight),
+				   d_image, QRectF(0, 0, d_width, second));
+	}
+}
+
+unsigned int WaterfallRaster::depth() const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	return d_depth;
+}
+
+unsigned int WaterfallRaster::width() const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	return d_width;
+}
+
+unsigned int WaterfallRaster::count() const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+	return d_count;
+}
+
+void WaterfallRaster::frequencies(std::vector<double> &columns) const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+
+	if (d_edges.size() == (size_t)d_width + 1) {
+		columns.assign(d_edges.begin(), d_edges.end() - 1);
+	} else {
+		columns.assign(d_width, 0.0);
+	}
+}
+
+void WaterfallRaster::snapshot(std::vector<double> &values,
+			       std::vector<double> &timestamps) const
+{
+	std::lock_guard<std::mutex> lock(d_mutex);
+
+	values.resize((size_t)d_count * d_width);
+	timestamps.resize(d_count);
+
+	if (d_count == 0) {
+		return;
+	}
+
+	const double first = d_timestamps[(d_head + d_count - 1) % d_depth];
+
+	for (unsigned int i = 0; i < d_count; i++) {
+		const unsigned int row = (d_head + d_count - 1 - i) % d_depth;
+		const float *src = &d_values[(size_t)row * d_width];
+
+		std::copy(src, src + d_width, &values[(size_t)i * d_width]);
+		timestamps[i] = d_timestamps[row] - first;
+	}
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WATERFALL_RASTER_HPP
+#define WATERFALL_RASTER_HPP
+
+#include <QImage>
+#include <QRect>
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+class QPainter;
+
+namespace adiscope {
+
+/*
+ * Spectrum history for a waterfall display. Every spectrum becomes one
+ * row of a preallocated 8 bit indexed image, whose colour table maps
+ * the displayed range from the lowest to the highest value. The width()
+ * columns span the visible part of the frequency axis, linearly or
+ * logarithmically like the axis, and each keeps the highest of the bins
+ * it covers. Columns outside of the spectrum are left blank.
+ *
+ * The rows form a ring: a new spectrum overwrites the oldest row and
+ * draw() blits the ring in two pieces, newest row on top, so nothing is
+ * ever moved or reallocated once configured. The values of the rows
+ * are kept too, for export and to repaint them when the range changes.
+ *
+ * Spectra are pushed by the spectrum worker thread and drawn by the GUI,
+ * so every method takes the internal lock.
+ */
+class WaterfallRaster
+{
+public:
+	WaterfallRaster(unsigned int depth = 256, unsigned int width = 1024);
+
+	/* Reallocates the ring; the history is dropped */
+	void configure(unsigned int depth, unsigned int width);
+	void clear();
+
+	/* Values mapped from the first to the last colour */
+	void setRange(double min, double max);
+	double rangeMin() const;
+	double rangeMax() const;
+
+	/*
+	 * Frequencies at the left and right edges of the columns. Until it
+	 * is set, the columns span the spectrum. A new view clears the rows.
+	 */
+	void setView(double left, double right, bool log);
+
+	/*
+	 * Adds the spectrum of size bins spanning [start, stop). A spectrum
+	 * of a different size or span than the stored ones clears them.
+	 */
+	void push(const double *data, size_t size, double start, double stop);
+
+	/* Draws the rows stored so far into target, newest at the top */
+	void draw(QPainter *painter, const QRect &target) const;
+
+	unsigned int depth() const;
+	unsigned int width() const;
+	unsigned int count() const;
+
+	/* Frequency at the left edge of every column */
+	void frequencies(std::vector<double> &columns) const;
+
+	/*
+	 * Copies the column values of the stored rows, row after row from
+	 * the oldest, and the seconds elapsed from the oldest to each row.
+	 */
+	void snapshot(std::vector<double> &values,
+		      std::vector<double> &timestamps) const;
+
+private:
+	static double now();
+	void buildColorTable();
+	void paintRow(unsigned int row);
+	void mapColumns(size_t size, double start, double stop);
+
+	mutable std::mutex d_mutex;
+	unsigned int d_depth;
+	unsigned int d_width;
+
+	QImage d_image;
+	std::vector<float> d_values;
+	std::vector<double> d_timestamps;
+	unsigned int d_head;
+	unsigned int d_count;
+
+	double d_min;
+	double d_max;
+
+	double d_left;
+	double d_right;
+	bool d_log;
+
+	/* Frequency and first bin at every column edge */
+	size_t d_frameSize;
+	double d_start;
+	double d_stop;
+	std::vector<double> d_edges;
+	std::vector<long long> d_columns;
+};
+
+} /* namespace adiscope */
+
+#endif /* WATERFALL_RASTER_HPP */
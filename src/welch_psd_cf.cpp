@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "welch_psd_cf.hpp"
+
+#include <gnuradio/io_signature.h>
+
+#include <algorithm>
+#include <string.h>
+
+using namespace adiscope;
+using namespace gr;
+
+welch_psd_cf::welch_psd_cf(size_t fft_size)
+	: block("welch_psd_cf",
+			io_signature::make(1, 1, sizeof(gr_complex)),
+			io_signature::make(1, 1, sizeof(float))),
+	d_fft_size(fft_size),
+	d_welch(false),
+	d_buffer_key(pmt::intern("buffer_start")),
+	d_pos(0),
+	d_frames(0),
+	d_partial(false),
+	d_buffer(false),
+	d_out_pos(0),
+	d_pending(false),
+	d_last_frames(0)
+{
+	set_tag_propagation_policy(TPP_DONT);
+	restart();
+}
+
+welch_psd_cf::~welch_psd_cf()
+{
+}
+
+void welch_psd_cf::restart()
+{
+	d_acc.assign(d_fft_size, 0.0);
+	d_out.assign(d_fft_size, 0.0f);
+	d_pos = 0;
+	d_frames = 0;
+	d_partial = false;
+	d_tags.clear();
+	d_buffer = false;
+	d_pending = false;
+	d_out_pos = 0;
+}
+
+bool welch_psd_cf::start()
+{
+	gr::thread::scoped_lock lock(d_setlock);
+
+	restart();
+
+	return block::start();
+}
+
+void welch_psd_cf::set_fft_size(size_t fft_size)
+{
+	gr::thread::scoped_lock lock(d_setlock);
+
+	if (fft_size != d_fft_size && fft_size > 0) {
+		d_fft_size = fft_size;
+		restart();
+	}
+}
+
+void welch_psd_cf::reset()
+{
+	gr::thread::scoped_lock lock(d_setlock);
+
+	restart();
+}
+
+void welch_psd_cf::set_welch(bool enabled)
+{
+	gr::thread::scoped_lock lock(d_setlock);
+
+	if (enabled != d_welch) {
+		// Stay aligned to the frames already in the stream, but leave
+		// out the one that is halfway through
+		const size_t pos = d_pos;
+
+		d_welch = enabled;
+		restart();
+		d_pos = pos;
+		d_partial = pos != 0;
+	}
+}
+
+bool welch_psd_cf::welch() const
+{
+	return d_welch;
+}
+
+unsigned int welch_psd_cf::averaged_frames() const
+{
+	return d_last_frames;
+}
+
+void welch_psd_cf::forecast(int noutput_items,
+			    gr_vector_int &ninput_items_required)
+{
+	// An averaged spectrum still going out needs no input
+	ninput_items_required[0] = d_pending ? 0 : 1;
+}
+
+void welch_psd_cf::emit_average()
+{
+	const double scale = 1.0 / d_frames;
+	double *acc = d_acc.data();
+	float *out = d_out.data();
+
+	for (size_t i = 0; i < d_fft_size; i++) {
+		out[i] = acc[i] * scale;
+		acc[i] = 0.0;
+	}
+
+	d_out_tags.swap(d_tags);
+	d_tags.clear();
+	d_last_frames = d_frames;
+	d_frames = 0;
+	d_out_pos = 0;
+	d_pending = true;
+}
+
+void welch_psd_cf::drop_average()
+{
+	std::fill(d_acc.begin(), d_acc.end(), 0.0);
+	d_tags.clear();
+	d_frames = 0;
+}
+
+int welch_psd_cf::general_work(int noutput_items,
+			       gr_vector_int &ninput_items,
+			       gr_vector_const_void_star &input_items,
+			       gr_vector_void_star &output_items)
+{
+	gr::thread::scoped_lock lock(d_setlock);
+
+	const gr_complex *in = static_cast<const gr_complex *>(input_items[0]);
+	float *out = static_cast<float *>(output_items[0]);
+	const size_t available = ninput_items[0];
+	std::vector<tag_t> tags;
+
+	if (!d_welch) {
+		const size_t n = std::min<size_t>(available, noutput_items);
+
+		for (size_t i = 0; i < n; i++) {
+			out[i] = in[i].real() * in[i].real() +
+				in[i].imag() * in[i].imag();
+		}
+
+		get_tags_in_range(tags, 0, nitems_read(0), nitems_read(0) + n);
+		for (tag_t tag : tags) {
+			tag.offset = tag.offset - nitems_read(0) + nitems_written(0);
+			add_item_tag(0, tag);
+		}
+
+		d_pos = (d_pos + n) % d_fft_size;
+		consume_each(n);
+		return n;
+	}
+
+	size_t consumed = 0;
+	int produced = 0;
+
+	while (produced < noutput_items) {
+		if (d_pending) {
+			const size_t n = std::min<size_t>(d_fft_size - d_out_pos,
+							  noutput_items - produced);
+
+			if (d_out_pos == 0) {
+				for (tag_t tag : d_out_tags) {
+					tag.offset = nitems_written(0) + produced;
+					add_item_tag(0, tag);
+				}
+			}
+
+			memcpy(out + produced, &d_out[d_out_pos], n * sizeof(float));
+			produced += n;
+			d_out_pos += n;
+			d_pending = d_out_pos < d_fft_size;
+			continue;
+		}
+
+		if (consumed == available) {
+			break;
+		}
+
+		const uint64_t start = nitems_read(0) + consumed;
+
+		// A new buffer closes the average of the previous one
+		if (d_pos == 0 && !d_partial) {
+			tags.clear();
+			get_tags_in_range(tags, 0, start, start + 1,
+					  d_buffer_key);
+
+			if (!tags.empty()) {
+				if (d_buffer && d_frames > 0) {
+					emit_average();
+					continue;
+				}
+
+				drop_average();
+				d_buffer = true;
+			}
+		}
+
+		// Accumulate up to the end of the current frame
+		const size_t n = std::min(available - consumed,
+					  d_fft_size - d_pos);
+		const gr_complex *src = in + consumed;
+		double *acc = d_acc.data() + d_pos;
+
+		for (size_t i = 0; i < n; i++) {
+			acc[i] += src[i].real() * src[i].real() +
+				src[i].imag() * src[i].imag();
+		}
+
+		tags.clear();
+		get_tags_in_range(tags, 0, start, start + n);
+		d_tags.insert(d_tags.end(), tags.begin(), tags.end());
+
+		consumed += n;
+		d_pos += n;
+
+		if (d_pos == d_fft_size) {
+			d_pos = 0;
+
+			if (d_partial) {
+				std::fill(d_acc.begin(), d_acc.end(), 0.0);
+				d_tags.clear();
+				d_partial = false;
+				continue;
+			}
+
+			d_frames++;
+		}
+	}
+
+	consume_each(consumed);
+	return produced;
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WELCH_PSD_CF_HPP
+#define WELCH_PSD_CF_HPP
+
+#include <gnuradio/block.h>
+
+#include <vector>
+
+namespace adiscope {
+	/*
+	 * Turns a stream of FFT frames of fft_size bins into power spectra.
+	 *
+	 * By default every frame is passed on as |X|^2, like
+	 * complex_to_mag_squared. In Welch mode the power of every frame
+	 * is added in place to an accumulator instead, and only the mean
+	 * over the frames of one captured buffer is emitted; with
+	 * overlapping segments upstream, this is Welch's estimate.
+	 *
+	 * Buffers are told apart by the "buffer_start" tag on their first
+	 * frame, so a buffer is averaged once the next one starts. Frames
+	 * that arrive before the first tag are dropped.
+	 *
+	 * Tags are not propagated item by item: the tags of the averaged
+	 * frames are placed on the first bin of the result.
+	 */
+	class welch_psd_cf : public gr::block
+	{
+	public:
+		explicit welch_psd_cf(size_t fft_size);
+		~welch_psd_cf();
+
+		void set_fft_size(size_t fft_size);
+
+		/* Drops partial frames, e.g. after the FFT dropped its own */
+		void reset();
+		void set_welch(bool enabled);
+		bool welch() const;
+
+		/* Frames in the last averaged spectrum */
+		unsigned int averaged_frames() const;
+
+		/* Frames left over from the last run are dropped */
+		bool start();
+
+		void forecast(int noutput_items,
+			      gr_vector_int &ninput_items_required);
+		int general_work(int noutput_items,
+				 gr_vector_int &ninput_items,
+				 gr_vector_const_void_star &input_items,
+				 gr_vector_void_star &output_items);
+
+	private:
+		void restart();
+		void emit_average();
+		void drop_average();
+
+		size_t d_fft_size;
+		bool d_welch;
+		pmt::pmt_t d_buffer_key;
+
+		/* Sum of the power of whole frames, and of the current one */
+		std::vector<double> d_acc;
+		size_t d_pos;
+		unsigned int d_frames;
+		bool d_partial;
+		std::vector<gr::tag_t> d_tags;
+
+		/* Whether the frames so far follow a "buffer_start" tag */
+		bool d_buffer;
+
+		/* Averaged spectrum waiting for output space */
+		std::vector<float> d_out;
+		size_t d_out_pos;
+		bool d_pending;
+		std::vector<gr::tag_t> d_out_tags;
+		unsigned int d_last_frames;
+	};
+}
+
+#endif /* WELCH_PSD_CF_HPP */
@@ -50,6 +50,11 @@
 #include <qapplication.h>
 #include <gnuradio/filter/firdes.h>
 
+#include "frame_exchange.hpp"
+#include "persistence_raster.hpp"
+
+#include <memory>
+
 namespace adiscope {
 
     class xy_sink_c : virtual public gr::sync_block
@@ -71,6 +76,16 @@ namespace adiscope {
       virtual int nsamps() const = 0;
       virtual void reset() = 0;
 
+      virtual const FrameCounters &frame_counters() const = 0;
+
+      /*
+       * Also bin every buffer into the given raster as a density image,
+       * one channel per input. Without persistence, the raster only
+       * holds the last plotted buffer. Pass nullptr to disable.
+       */
+      virtual void set_density_raster(const std::shared_ptr<PersistenceRaster> &raster) = 0;
+      virtual void set_density_persistence(bool en) = 0;
+
       QApplication *d_qApplication;
     };
 
@@ -73,19 +73,11 @@ namespace adiscope {
       : sync_block("xy_sink_c",
 		   io_signature::make(nconnections, nconnections, sizeof(gr_complex)),
 		   io_signature::make(0, 0, 0)),
-	d_size(size), d_buffer_size(2*size), d_name(name),
-	d_nconnections(nconnections), d_index(0), d_start(0), d_end(size)
+	d_size(size), d_name(name),
+	d_nconnections(nconnections), d_index(0), d_start(0), d_end(size),
+	d_exchange(std::make_shared<FrameExchange>()),
+	d_density_persistence(false)
     {
-
-      for(int i = 0; i < d_nconnections; i++) {
-	d_residbufs_real.push_back((double*)volk_malloc(d_buffer_size*sizeof(double),
-                                                        volk_get_alignment()));
-	d_residbufs_imag.push_back((double*)volk_malloc(d_buffer_size*sizeof(double),
-                                                        volk_get_alignment()));
-	memset(d_residbufs_real[i], 0, d_buffer_size*sizeof(double));
-	memset(d_residbufs_imag[i], 0, d_buffer_size*sizeof(double));
-      }
-
       // Set alignment properties for VOLK
       const int alignment_multiple =
 	volk_get_alignment() / sizeof(gr_complex);
@@ -98,10 +90,6 @@ namespace adiscope {
     xy_sink_c_impl::~xy_sink_c_impl()
     {
       // d_main_gui is a qwidget destroyed with its parent
-      for(int i = 0; i < d_nconnections; i++) {
-	volk_free(d_residbufs_real[i]);
-	volk_free(d_residbufs_imag[i]);
-      }
     }
 
     bool
@@ -144,23 +132,10 @@ namespace adiscope {
       if(newsize != d_size) {
 	// Set new size and reset buffer index
 	// (throws away any currently held data, but who cares?)
+	// The frames of the exchange get resized as they are reused.
 	d_size = newsize;
-        d_buffer_size = 2*d_size;
 	d_index = 0;
 
-	// Resize residbuf and replace data
-	for(int i = 0; i < d_nconnections; i++) {
-	  volk_free(d_residbufs_real[i]);
-	  volk_free(d_residbufs_imag[i]);
-	  d_residbufs_real[i] = (double*)volk_malloc(d_buffer_size*sizeof(double),
-                                                     volk_get_alignment());
-	  d_residbufs_imag[i] = (double*)volk_malloc(d_buffer_size*sizeof(double),
-                                                     volk_get_alignment());
-
-	  memset(d_residbufs_real[i], 0, d_buffer_size*sizeof(double));
-	  memset(d_residbufs_imag[i], 0, d_buffer_size*sizeof(double));
-	}
-
         _reset();
       }
     }
@@ -178,6 +153,26 @@ namespace adiscope {
       _reset();
     }
 
+    const FrameCounters &
+    xy_sink_c_impl::frame_counters() const
+    {
+      return d_exchange->counters();
+    }
+
+    void
+    xy_sink_c_impl::set_density_raster(const std::shared_ptr<PersistenceRaster> &raster)
+    {
+      gr::thread::scoped_lock lock(d_setlock);
+      d_density = raster;
+    }
+
+    void
+    xy_sink_c_impl::set_density_persistence(bool en)
+    {
+      gr::thread::scoped_lock lock(d_setlock);
+      d_density_persistence = en;
+    }
+
     void
     xy_sink_c_impl::_reset()
     {
@@ -202,14 +197,18 @@ namespace adiscope {
 
       _npoints_resize();
 
+      gr::thread::scoped_lock lock(d_setlock);
+
       int nfill = d_end - d_index;                 // how much room left in buffers
       int nitems = std::min(noutput_items, nfill); // num items we can put in buffers
 
-      // Copy data into the buffers.
+      // Copy data into the frame: the real parts of every input go to
+      // the first d_nconnections channels, the imaginary parts after them.
+      TimeFrame &frame = d_exchange->back(2 * d_nconnections, d_size);
       for(n = 0; n < d_nconnections; n++) {
         in = (const gr_complex*)input_items[n];
-        volk_32fc_deinterleave_64f_x2(&d_residbufs_real[n][d_index],
-                                      &d_residbufs_imag[n][d_index],
+        volk_32fc_deinterleave_64f_x2(&frame.channel(n)[d_index],
+                                      &frame.channel(d_nconnections + n)[d_index],
                                       &in[0], nitems);
       }
       d_index += nitems;
@@ -217,20 +216,27 @@ namespace adiscope {
 
       // If we have a full d_size of items in the buffers, plot.
       if((d_index == d_end) && d_end  != 0) {
-        // Copy data to be plotted to start of buffers.
-        for(n = 0; n < d_nconnections; n++) {
-          memmove(d_residbufs_real[n], &d_residbufs_real[n][d_start], d_size*sizeof(double));
-          memmove(d_residbufs_imag[n], &d_residbufs_imag[n][d_start], d_size*sizeof(double));
+        const bool update = gr::high_res_timer_now() - d_last_time > d_update_time;
+
+        // With persistence every buffer adds up in the density image,
+        // otherwise it only needs the buffers that get plotted
+        if(d_density && (update || d_density_persistence)) {
+          for(n = 0; n < d_nconnections; n++) {
+            d_density->accumulatePoints(n, &frame.channel(n)[d_start],
+                                        &frame.channel(d_nconnections + n)[d_start],
+                                        d_size, !d_density_persistence);
+          }
         }
 
-        // Plot if we are able to update
-        if(gr::high_res_timer_now() - d_last_time > d_update_time) {
+        // Plot if we are able to update, otherwise the frame gets
+        // overwritten by the next one
+        if(update) {
           d_last_time = gr::high_res_timer_now();
-          if (d_qApplication)
+          if (d_exchange->publish(d_start, d_size) && d_qApplication)
 		d_qApplication->postEvent(plot,
-                                    new ConstUpdateEvent(d_residbufs_real,
-							 d_residbufs_imag,
-							 d_size));
+                                    new FrameReadyEvent(d_exchange));
+        } else {
+          d_exchange->drop();
         }
 
         // We've plotting, so reset the state
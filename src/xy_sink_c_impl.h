@@ -54,13 +54,15 @@ namespace adiscope {
     private:
       void initialize();
 
-      int d_size, d_buffer_size;
+      int d_size;
       std::string d_name;
       int d_nconnections;
 
       int d_index, d_start, d_end;
-      std::vector<double*> d_residbufs_real;
-      std::vector<double*> d_residbufs_imag;
+      std::shared_ptr<FrameExchange> d_exchange;
+
+      std::shared_ptr<PersistenceRaster> d_density;
+      bool d_density_persistence;
 
       ConstellationDisplayPlot *plot;
 
@@ -87,6 +89,10 @@ namespace adiscope {
       int nsamps() const;
       void reset();
 
+      const FrameCounters &frame_counters() const;
+      void set_density_raster(const std::shared_ptr<PersistenceRaster> &raster);
+      void set_density_persistence(bool en);
+
       int work(int noutput_items,
 	       gr_vector_const_void_star &input_items,
 	       gr_vector_void_star &output_items);
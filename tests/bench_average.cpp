@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "average.h"
+
+#include <QtTest>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace adiscope;
+
+/*
+ * Times one frame through every SpectrumAverage: pushNewData() followed by
+ * getAverage(), as the spectrum analyzer does for each FFT. The history is
+ * filled beforehand so the windowed averages run in their steady state.
+ *
+ * Run with e.g. "bench_average -tickcounter" or "-iterations 1000".
+ */
+class BenchAverage : public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void initTestCase();
+	void pushFrame_data();
+	void pushFrame();
+
+private:
+	static const unsigned int WIDTH = 16384;
+
+	std::vector<std::vector<double>> d_frames;
+	std::vector<double> d_out;
+};
+
+enum AverageType {
+	PEAK_HOLD,
+	PEAK_HOLD_CONTINUOUS,
+	MIN_HOLD,
+	MIN_HOLD_CONTINUOUS,
+	LINEAR_RMS,
+	LINEAR_RMS_ONE,
+	LINEAR_AVERAGE,
+	LINEAR_AVERAGE_ONE,
+	EXPONENTIAL_RMS,
+	EXPONENTIAL_AVERAGE,
+};
+
+Q_DECLARE_METATYPE(AverageType)
+
+static SpectrumAverage *makeAverage(AverageType type, unsigned int width,
+		unsigned int history)
+{
+	switch (type) {
+	case PEAK_HOLD:
+		return new PeakHold(width, history);
+	case PEAK_HOLD_CONTINUOUS:
+		return new PeakHoldContinuous(width, history);
+	case MIN_HOLD:
+		return new MinHold(width, history);
+	case MIN_HOLD_CONTINUOUS:
+		return new MinHoldContinuous(width, history);
+	case LINEAR_RMS:
+		return new LinearRMS(width, history);
+	case LINEAR_RMS_ONE:
+		return new LinearRMSOne(width, history);
+	case LINEAR_AVERAGE:
+		return new LinearAverage(width, history);
+	case LINEAR_AVERAGE_ONE:
+		return new LinearAverageOne(width, history);
+	case EXPONENTIAL_RMS:
+		return new ExponentialRMS(width, history);
+	case EXPONENTIAL_AVERAGE:
+		return new ExponentialAverage(width, history);
+	}
+
+	return nullptr;
+}
+
+/* A few distinct spectra, cycled so min/max holds keep changing */
+void BenchAverage::initTestCase()
+{
+	std::mt19937 gen(1234);
+	std::uniform_real_distribution<double> dist(-120.0, 0.0);
+
+	d_frames.resize(7);
+	for (auto &frame : d_frames) {
+		frame.resize(WIDTH);
+		for (auto &bin : frame) {
+			bin = dist(gen);
+		}
+	}
+
+	d_out.resize(WIDTH);
+}
+
+void BenchAverage::pushFrame_data()
+{
+	static const struct {
+		AverageType type;
+		const char *name;
+	} types[] = {
+		{ PEAK_HOLD, "PeakHold" },
+		{ PEAK_HOLD_CONTINUOUS, "PeakHoldContinuous" },
+		{ MIN_HOLD, "MinHold" },
+		{ MIN_HOLD_CONTINUOUS, "MinHoldContinuous" },
+		{ LINEAR_RMS, "LinearRMS" },
+		{ LINEAR_RMS_ONE, "LinearRMSOne" },
+		{ LINEAR_AVERAGE, "LinearAverage" },
+		{ LINEAR_AVERAGE_ONE, "LinearAverageOne" },
+		{ EXPONENTIAL_RMS, "ExponentialRMS" },
+		{ EXPONENTIAL_AVERAGE, "ExponentialAverage" },
+	};
+	static const unsigned int histories[] = { 4, 64, 1000 };
+
+	QTest::addColumn<AverageType>("type");
+	QTest::addColumn<unsigned int>("history");
+
+	for (const auto &t : types) {
+		for (unsigned int history : histories) {
+			QTest::newRow(QString("%1/%2").arg(t.name).arg(history)
+				.toLatin1().constData()) << t.type << history;
+		}
+	}
+}
+
+void BenchAverage::pushFrame()
+{
+	QFETCH(AverageType, type);
+	QFETCH(unsigned int, history);
+
+	std::unique_ptr<SpectrumAverage> avg(makeAverage(type, WIDTH, history));
+	unsigned int frame = 0;
+
+	for (unsigned int i = 0; i < history; i++) {
+		avg->pushNewData(d_frames[frame++ % d_frames.size()].data());
+	}
+
+	QBENCHMARK {
+		avg->pushNewData(d_frames[frame++ % d_frames.size()].data());
+		avg->getAverage(d_out.data(), WIDTH);
+	}
+}
+
+QTEST_APPLESS_MAIN(BenchAverage)
+
+#include "bench_average.moc"
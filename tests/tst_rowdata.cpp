@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "logicanalyzer/rowdata.h"
+
+#include <QtTest>
+
+class TestRowData : public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void initTestCase();
+	void subsetInGap();
+	void subsetOverlapping();
+	void subsetOutside();
+
+private:
+	void add(uint64_t start, uint64_t end);
+
+	RowData d_data;
+};
+
+void TestRowData::add(uint64_t start, uint64_t end)
+{
+	char text[] = "ann";
+	char *texts[] = { text, nullptr };
+	srd_proto_data_annotation pda = {};
+	srd_proto_data pdata = {};
+
+	pda.ann_text = texts;
+	pdata.start_sample = start;
+	pdata.end_sample = end;
+	pdata.data = &pda;
+
+	d_data.emplace_annotation(&pdata, nullptr);
+}
+
+/* A wide annotation, a narrow one and another wide one, with gaps */
+void TestRowData::initTestCase()
+{
+	add(10, 20);
+	add(30, 31);
+	add(40, 50);
+}
+
+/* A cursor in a gap gets both neighbours, so a narrow one can be hit */
+void TestRowData::subsetInGap()
+{
+	auto range = d_data.get_annotation_subset(32, 33);
+	QCOMPARE(range.first, uint64_t(1));
+	QCOMPARE(range.second, uint64_t(2));
+
+	range = d_data.get_annotation_subset(24, 25);
+	QCOMPARE(range.first, uint64_t(0));
+	QCOMPARE(range.second, uint64_t(1));
+}
+
+void TestRowData::subsetOverlapping()
+{
+	auto range = d_data.get_annotation_subset(14, 15);
+	QCOMPARE(range.first, uint64_t(0));
+	QCOMPARE(range.second, uint64_t(1));
+
+	range = d_data.get_annotation_subset(44, 45);
+	QCOMPARE(range.first, uint64_t(1));
+	QCOMPARE(range.second, uint64_t(2));
+}
+
+void TestRowData::subsetOutside()
+{
+	auto range = d_data.get_annotation_subset(4, 5);
+	QCOMPARE(range.first, uint64_t(0));
+	QCOMPARE(range.second, uint64_t(0));
+
+	range = d_data.get_annotation_subset(60, 61);
+	QCOMPARE(range.first, uint64_t(2));
+	QCOMPARE(range.second, uint64_t(2));
+}
+
+QTEST_APPLESS_MAIN(TestRowData)
+
+#include "tst_rowdata.moc"
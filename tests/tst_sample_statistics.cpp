@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2021 Analog Devices Inc.
+ *
+ * This file is part of Scopy
+ * (see http://www.github.com/analogdevicesinc/scopy).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gui/sample_statistics.h"
+
+#include <QtTest>
+
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace adiscope;
+
+class TestSampleStatistics : public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void initTestCase();
+	void vectorMatchesScalar_data();
+	void vectorMatchesScalar();
+
+private:
+	std::vector<double> d_samples;
+};
+
+static bool sameBits(double a, double b)
+{
+	return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+/* Random samples plus the values where kernels usually disagree */
+void TestSampleStatistics::initTestCase()
+{
+	std::mt19937 gen(1234);
+	std::normal_distribution<double> dist(0.0, 1e3);
+
+	for (int i = 0; i < 10007; i++) {
+		d_samples.push_back(dist(gen));
+	}
+
+	const double nan = std::numeric_limits<double>::quiet_NaN();
+
+	d_samples[0] = nan;
+	d_samples[5] = 0.0;
+	d_samples[6] = -0.0;
+	d_samples[7] = -0.0;
+	d_samples[102] = nan;
+	d_samples[103] = nan;
+	d_samples[4095] = 1e-310;
+	d_samples[4096] = -1e-310;
+	d_samples.back() = nan;
+}
+
+void TestSampleStatistics::vectorMatchesScalar_data()
+{
+	QTest::addColumn<int>("offset");
+	QTest::addColumn<int>("chunk");
+
+	QTest::newRow("whole buffer") << 0 << int(d_samples.size());
+	QTest::newRow("unaligned start") << 3 << int(d_samples.size());
+	QTest::newRow("measurement blocks") << 0 << 4096;
+	QTest::newRow("odd chunks") << 1 << 7;
+}
+
+/*
+ * Fed one sample at a time, SampleStatistics only ever runs its scalar
+ * reference; fed in chunks it runs whichever vector kernel this build
+ * targets. Both must produce the very same bits.
+ */
+void TestSampleStatistics::vectorMatchesScalar()
+{
+	QFETCH(int, offset);
+	QFETCH(int, chunk);
+
+	const double *data = d_samples.data() + offset;
+	const size_t length = d_samples.size() - offset;
+	SampleStatistics scalar, vector;
+
+	for (size_t i = 0; i < length; i++) {
+		scalar.accumulate(data + i, 1);
+	}
+
+	for (size_t i = 0; i < length; i += chunk) {
+		vector.accumulate(data + i, std::min<size_t>(chunk, length - i));
+	}
+
+	QCOMPARE(vector.count(), scalar.count());
+	QVERIFY(sameBits(vector.min(), scalar.min()));
+	QVERIFY(sameBits(vector.max(), scalar.max()));
+	QVERIFY(sameBits(vector.sum(), scalar.sum()));
+	QVERIFY(sameBits(vector.sqrSum(), scalar.sqrSum()));
+}
+
+QTEST_APPLESS_MAIN(TestSampleStatistics)
+
+#include "tst_sample_statistics.moc"